@@ -202,10 +202,10 @@ void cmCTestBuildHandler::Initialize()
   this->ReallyCustomWarningExceptions.clear();
   this->ErrorWarningFileLineRegex.clear();
 
-  this->ErrorMatchRegex.clear();
-  this->ErrorExceptionRegex.clear();
-  this->WarningMatchRegex.clear();
-  this->WarningExceptionRegex.clear();
+  this->ErrorMatchRegex.Clear();
+  this->ErrorExceptionRegex.Clear();
+  this->WarningMatchRegex.Clear();
+  this->WarningExceptionRegex.Clear();
   this->BuildProcessingQueue.clear();
   this->BuildProcessingErrorQueue.clear();
   this->BuildOutputLogSize = 0;
@@ -401,14 +401,14 @@ int cmCTestBuildHandler::ProcessHandler()
   std::vector<std::string>::iterator it;
 
 #define cmCTestBuildHandlerPopulateRegexVector(strings, regexes) \
-  regexes.clear(); \
+  regexes.Clear(); \
     cmCTestOptionalLog(this->CTest, DEBUG, this << "Add " #regexes \
     << std::endl, this->Quiet); \
   for ( it = strings.begin(); it != strings.end(); ++it ) \
     { \
     cmCTestOptionalLog(this->CTest, DEBUG, "Add " #strings ": " \
     << *it << std::endl, this->Quiet); \
-    regexes.push_back(it->c_str()); \
+    regexes.Add(*it); \
     }
   cmCTestBuildHandlerPopulateRegexVector(
     this->CustomErrorMatches, this->ErrorMatchRegex);
@@ -606,7 +606,48 @@ void cmCTestBuildHandler::GenerateXMLLaunched(std::ostream& os)
   // only report the first 50 warnings and first 50 errors
   int numErrorsAllowed = this->MaxErrors;
   int numWarningsAllowed = this->MaxWarnings;
-  // Identify fragments on disk.
+
+  // Copy the fragments appended to the journal.  They are already in
+  // chronological order.
+  std::string journal = this->CTestLaunchDir + "/CTestLaunchJournal.txt";
+  cmsys::ifstream fin(journal.c_str(), std::ios::in | std::ios::binary);
+  std::string header;
+  std::vector<char> xml;
+  while(cmSystemTools::GetLineFromStream(fin, header))
+    {
+    // Each fragment follows a "<type> <size>" line.
+    std::string::size_type pos = header.find(' ');
+    if(pos == std::string::npos)
+      {
+      break;
+      }
+    xml.resize(static_cast<size_t>(atol(header.c_str() + pos + 1)));
+    if(!xml.empty() && !fin.read(&xml[0], xml.size()))
+      {
+      break;
+      }
+    std::string type = header.substr(0, pos);
+    if(type == "error" && numErrorsAllowed)
+      {
+      numErrorsAllowed--;
+      ++this->TotalErrors;
+      }
+    else if(type == "warning" && numWarningsAllowed)
+      {
+      numWarningsAllowed--;
+      ++this->TotalWarnings;
+      }
+    else
+      {
+      continue;
+      }
+    if(!xml.empty())
+      {
+      os.write(&xml[0], xml.size());
+      }
+    }
+
+  // Identify fragments on disk written by launchers without the journal.
   cmsys::Directory launchDir;
   launchDir.Load(this->CTestLaunchDir);
   unsigned long n = launchDir.GetNumberOfFiles();
@@ -824,8 +865,10 @@ cmCTestBuildHandler::LaunchHelper::LaunchHelper(cmCTestBuildHandler* handler):
 
     if(this->Handler->UseCTestLaunch)
       {
-      // Enable launcher fragments.
+      // Enable launcher fragments.  Launchers append them to the
+      // journal when it exists.
       cmSystemTools::MakeDirectory(launchDir.c_str());
+      cmSystemTools::Touch(launchDir + "/CTestLaunchJournal.txt", true);
       this->WriteLauncherConfig();
       std::string launchEnv = "CTEST_LAUNCH_LOGS=";
       launchEnv += launchDir;
@@ -863,6 +906,13 @@ void cmCTestBuildHandler::LaunchHelper::WriteLauncherConfig()
   cmGeneratedFileStream fout(fname.c_str());
   std::string srcdir = this->CTest->GetCTestConfiguration("SourceDirectory");
   fout << "set(CTEST_SOURCE_DIRECTORY \"" << srcdir << "\")\n";
+
+  // The same information in a form the launcher reads without an
+  // interpreter.
+  fname = this->Handler->CTestLaunchDir;
+  fname += "/CTestLaunchConfig.txt";
+  cmGeneratedFileStream ftxt(fname.c_str());
+  ftxt << "SourceDirectory: " << srcdir << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -1226,83 +1276,56 @@ int cmCTestBuildHandler::ProcessSingleLine(const char* data)
   cmCTestOptionalLog(this->CTest, DEBUG, "Line: [" << data << "]" <<
     std::endl, this->Quiet);
 
-  std::vector<cmsys::RegularExpression>::iterator it;
-
   int warningLine = 0;
   int errorLine = 0;
 
-  // Check for regular expressions
+  // Check for regular expressions.  An exception is looked for only if
+  // the line matched.
 
   if ( !this->ErrorQuotaReached )
     {
     // Errors
-    int wrxCnt = 0;
-    for ( it = this->ErrorMatchRegex.begin();
-      it != this->ErrorMatchRegex.end();
-      ++ it )
-      {
-      if ( it->find(data) )
-        {
-        errorLine = 1;
-        cmCTestOptionalLog(this->CTest, DEBUG, "  Error Line: " << data
-          << " (matches: " << this->CustomErrorMatches[wrxCnt] << ")"
-          << std::endl, this->Quiet);
-        break;
-        }
-      wrxCnt ++;
-      }
-    // Error exceptions
-    wrxCnt = 0;
-    for ( it = this->ErrorExceptionRegex.begin();
-      it != this->ErrorExceptionRegex.end();
-      ++ it )
+    int wrxCnt = this->ErrorMatchRegex.Find(data);
+    if ( wrxCnt >= 0 )
       {
-      if ( it->find(data) )
+      errorLine = 1;
+      cmCTestOptionalLog(this->CTest, DEBUG, "  Error Line: " << data
+        << " (matches: " << this->CustomErrorMatches[wrxCnt] << ")"
+        << std::endl, this->Quiet);
+
+      // Error exceptions
+      wrxCnt = this->ErrorExceptionRegex.Find(data);
+      if ( wrxCnt >= 0 )
         {
         errorLine = 0;
         cmCTestOptionalLog(this->CTest, DEBUG, "  Not an error Line: " << data
           << " (matches: " << this->CustomErrorExceptions[wrxCnt] << ")"
           << std::endl, this->Quiet);
-        break;
         }
-      wrxCnt ++;
       }
     }
   if ( !this->WarningQuotaReached )
     {
     // Warnings
-    int wrxCnt = 0;
-    for ( it = this->WarningMatchRegex.begin();
-      it != this->WarningMatchRegex.end();
-      ++ it )
+    int wrxCnt = this->WarningMatchRegex.Find(data);
+    if ( wrxCnt >= 0 )
       {
-      if ( it->find(data) )
-        {
-        warningLine = 1;
-        cmCTestOptionalLog(this->CTest, DEBUG,
-          "  Warning Line: " << data
-          << " (matches: " << this->CustomWarningMatches[wrxCnt] << ")"
-          << std::endl, this->Quiet);
-        break;
-        }
-      wrxCnt ++;
-      }
-
-    wrxCnt = 0;
-    // Warning exceptions
-    for ( it = this->WarningExceptionRegex.begin();
-      it != this->WarningExceptionRegex.end();
-      ++ it )
-      {
-      if ( it->find(data) )
+      warningLine = 1;
+      cmCTestOptionalLog(this->CTest, DEBUG,
+        "  Warning Line: " << data
+        << " (matches: " << this->CustomWarningMatches[wrxCnt] << ")"
+        << std::endl, this->Quiet);
+
+      // Warning exceptions
+      wrxCnt = this->WarningExceptionRegex.Find(data);
+      if ( wrxCnt >= 0 )
         {
         warningLine = 0;
-        cmCTestOptionalLog(this->CTest, DEBUG, "  Not a warning Line: " << data
+        cmCTestOptionalLog(this->CTest, DEBUG, "  Not a warning Line: "
+          << data
           << " (matches: " << this->CustomWarningExceptions[wrxCnt] << ")"
           << std::endl, this->Quiet);
-        break;
         }
-      wrxCnt ++;
       }
     }
   if ( errorLine )
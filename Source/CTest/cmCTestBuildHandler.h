@@ -17,6 +17,8 @@
 #include "cmCTestGenericHandler.h"
 #include "cmListFileCache.h"
 
+#include "cmRegularExpressionSet.h"
+
 #include <cmsys/RegularExpression.hxx>
 
 #include <deque>
@@ -107,10 +109,10 @@ private:
   std::vector<std::string> ReallyCustomWarningExceptions;
   std::vector<cmCTestCompileErrorWarningRex> ErrorWarningFileLineRegex;
 
-  std::vector<cmsys::RegularExpression> ErrorMatchRegex;
-  std::vector<cmsys::RegularExpression> ErrorExceptionRegex;
-  std::vector<cmsys::RegularExpression> WarningMatchRegex;
-  std::vector<cmsys::RegularExpression> WarningExceptionRegex;
+  cmRegularExpressionSet ErrorMatchRegex;
+  cmRegularExpressionSet ErrorExceptionRegex;
+  cmRegularExpressionSet WarningMatchRegex;
+  cmRegularExpressionSet WarningExceptionRegex;
 
   typedef std::deque<char> t_BuildProcessingQueueType;
 
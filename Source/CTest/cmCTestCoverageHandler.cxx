@@ -23,6 +23,7 @@
 #include "cmSystemTools.h"
 #include "cmGeneratedFileStream.h"
 #include "cmXMLSafe.h"
+#include "cmAlgorithms.h"
 
 #include <cmsys/Process.h>
 #include <cmsys/RegularExpression.hxx>
@@ -31,6 +32,8 @@
 #include <cmsys/stl/algorithm>
 #include <cmsys/FStream.hxx>
 
+#include <deque>
+
 #include <stdlib.h>
 #include <math.h>
 #include <float.h>
@@ -124,6 +127,26 @@ public:
       return this->PipeState;
     }
   int GetProcessState() { return this->PipeState;}
+  bool Exited()
+    {
+      return cmsysProcess_GetState(this->Process) ==
+        cmsysProcess_State_Exited;
+    }
+  int GetExitValue() { return cmsysProcess_GetExitValue(this->Process); }
+  std::string GetErrorString()
+    {
+      switch(cmsysProcess_GetState(this->Process))
+        {
+        case cmsysProcess_State_Exception:
+          return cmsysProcess_GetExceptionString(this->Process);
+        case cmsysProcess_State_Error:
+          return cmsysProcess_GetErrorString(this->Process);
+        case cmsysProcess_State_Expired:
+          return "Process terminated due to timeout";
+        default:
+          return "";
+        }
+    }
 private:
   int PipeState;
   cmsysProcess* Process;
@@ -134,10 +157,308 @@ private:
 
 
 //----------------------------------------------------------------------
+// One gcov process run alongside others.  Each job gets its own
+// directory for the .gcov files and the output it writes.
+class cmCTestGCovJob
+{
+public:
+  cmCTestGCovJob(std::string const& command, std::string const& dir)
+    : Directory(dir)
+    {
+      cmSystemTools::MakeDirectory(dir.c_str());
+      std::vector<std::string> args =
+        cmSystemTools::ParseArguments(command.c_str());
+      for(std::vector<std::string>::const_iterator a = args.begin();
+          a != args.end(); ++a)
+        {
+        if(a == args.begin())
+          {
+          this->Process.SetCommand(a->c_str());
+          }
+        else
+          {
+          this->Process.AddArgument(a->c_str());
+          }
+        }
+      this->Process.SetWorkingDirectory(dir.c_str());
+      this->Process.SetStdoutFile((dir + "/gcov.out").c_str());
+      this->Process.SetStderrFile((dir + "/gcov.err").c_str());
+      this->Started = !args.empty() && this->Process.StartProcess();
+    }
+
+  // Wait for the process and get its results like cmCTest::RunCommand.
+  bool Finish(std::string& output, std::string& errors, int& retVal)
+    {
+      if(this->Started)
+        {
+        this->Process.WaitForExit();
+        }
+      output = ReadFile(this->Directory + "/gcov.out");
+      errors = ReadFile(this->Directory + "/gcov.err");
+      if(!this->Started || !this->Process.Exited())
+        {
+        errors += this->Process.GetErrorString();
+        return false;
+        }
+      retVal = this->Process.GetExitValue();
+      return true;
+    }
+
+  std::string const& GetDirectory() const { return this->Directory; }
+
+private:
+  static std::string ReadFile(std::string const& fname)
+    {
+      std::string content;
+      std::string line;
+      cmsys::ifstream fin(fname.c_str());
+      while(cmSystemTools::GetLineFromStream(fin, line))
+        {
+        content += line;
+        content += "\n";
+        }
+      return content;
+    }
+
+  cmCTestRunProcess Process;
+  std::string Directory;
+  bool Started;
+};
+
+//----------------------------------------------------------------------
+// Reads back the line counts of one spill file.  Files appear in the
+// sorted order in which they were written.
+class cmCTestCoverageHandlerContainer::SpillReader
+{
+public:
+  SpillReader(std::string const& fname)
+    : Stream(fname.c_str(), std::ios::in | std::ios::binary)
+    {
+      this->Next();
+    }
+
+  void Next()
+    {
+      this->Valid = false;
+      unsigned int nameLength = 0;
+      unsigned int countsLength = 0;
+      if(!this->Read(&nameLength, sizeof(nameLength)))
+        {
+        return;
+        }
+      this->File.resize(nameLength);
+      if(nameLength > 0 && !this->Read(&this->File[0], nameLength))
+        {
+        return;
+        }
+      if(!this->Read(&countsLength, sizeof(countsLength)))
+        {
+        return;
+        }
+      this->Counts.resize(countsLength);
+      if(countsLength > 0 &&
+         !this->Read(&this->Counts[0], countsLength * sizeof(int)))
+        {
+        return;
+        }
+      this->Valid = true;
+    }
+
+  bool Valid;
+  std::string File;
+  SingleFileCoverageVector Counts;
+
+private:
+  bool Read(void* data, size_t length)
+    {
+      return this->Stream.read(static_cast<char*>(data),
+                               static_cast<std::streamsize>(length))?
+        true : false;
+    }
+
+  cmsys::ifstream Stream;
+};
+
+//----------------------------------------------------------------------
+cmCTestCoverageHandlerContainer::cmCTestCoverageHandlerContainer()
+{
+  this->Error = 0;
+  this->OFS = 0;
+  this->Quiet = false;
+  this->MemoryLimit = 0;
+  this->MemoryInUse = 0;
+}
+
+//----------------------------------------------------------------------
+cmCTestCoverageHandlerContainer::~cmCTestCoverageHandlerContainer()
+{
+  cmDeleteAll(this->SpillReaders);
+  for(std::vector<std::string>::const_iterator i = this->SpillFiles.begin();
+      i != this->SpillFiles.end(); ++i)
+    {
+    cmSystemTools::RemoveFile(*i);
+    }
+}
+
+//----------------------------------------------------------------------
+void cmCTestCoverageHandlerContainer::SpillIfNeeded()
+{
+  if(this->MemoryLimit == 0 || this->MemoryInUse <= this->MemoryLimit ||
+     this->TotalCoverage.empty())
+    {
+    return;
+    }
+
+  std::ostringstream fname;
+  fname << this->SpillDirectory << "/CoverageSpill"
+        << this->SpillFiles.size() << ".bin";
+  bool okay;
+  {
+  cmsys::ofstream fout(fname.str().c_str(),
+                       std::ios::out | std::ios::binary);
+  for(TotalCoverageMap::const_iterator i = this->TotalCoverage.begin();
+      fout && i != this->TotalCoverage.end(); ++i)
+    {
+    unsigned int nameLength = static_cast<unsigned int>(i->first.size());
+    unsigned int countsLength = static_cast<unsigned int>(i->second.size());
+    fout.write(reinterpret_cast<const char*>(&nameLength),
+               sizeof(nameLength));
+    fout.write(i->first.c_str(), nameLength);
+    fout.write(reinterpret_cast<const char*>(&countsLength),
+               sizeof(countsLength));
+    if(countsLength > 0)
+      {
+      fout.write(reinterpret_cast<const char*>(&i->second[0]),
+                 countsLength * sizeof(int));
+      }
+    }
+  fout.flush();
+  okay = fout? true : false;
+  }
+  if(!okay)
+    {
+    // Keep everything in memory if the counts cannot be written.
+    cmSystemTools::RemoveFile(fname.str());
+    this->MemoryLimit = 0;
+    return;
+    }
+
+  this->SpillFiles.push_back(fname.str());
+  for(TotalCoverageMap::const_iterator i = this->TotalCoverage.begin();
+      i != this->TotalCoverage.end(); ++i)
+    {
+    this->SpilledNames.insert(i->first);
+    }
+  this->TotalCoverage.clear();
+  this->MemoryInUse = 0;
+}
+
+//----------------------------------------------------------------------
+static void cmCTestCoverageHandlerMergeCounts(
+  cmCTestCoverageHandlerContainer::SingleFileCoverageVector& counts,
+  cmCTestCoverageHandlerContainer::SingleFileCoverageVector const& more)
+{
+  // A count of -1 marks a line that is not executable.  Combine counts
+  // the way the handlers add them to a single vector.
+  if(counts.size() < more.size())
+    {
+    counts.resize(more.size(), -1);
+    }
+  for(size_t i = 0; i < more.size(); ++i)
+    {
+    if(more[i] >= 0)
+      {
+      counts[i] = counts[i] < 0? more[i] : counts[i] + more[i];
+      }
+    }
+}
+
+//----------------------------------------------------------------------
+bool cmCTestCoverageHandlerContainer::TakeNextFile(std::string& file,
+  SingleFileCoverageVector& counts)
+{
+  if(this->SpillReaders.empty())
+    {
+    for(std::vector<std::string>::const_iterator i =
+          this->SpillFiles.begin(); i != this->SpillFiles.end(); ++i)
+      {
+      this->SpillReaders.push_back(new SpillReader(*i));
+      }
+    }
+
+  // Find the first file name in sorted order.
+  bool found = false;
+  if(!this->TotalCoverage.empty())
+    {
+    file = this->TotalCoverage.begin()->first;
+    found = true;
+    }
+  for(std::vector<SpillReader*>::const_iterator r =
+        this->SpillReaders.begin(); r != this->SpillReaders.end(); ++r)
+    {
+    if((*r)->Valid && (!found || (*r)->File < file))
+      {
+      file = (*r)->File;
+      found = true;
+      }
+    }
+  if(!found)
+    {
+    return false;
+    }
+
+  // Collect its counts from memory and from every spill file.
+  counts.clear();
+  TotalCoverageMap::iterator mi = this->TotalCoverage.begin();
+  if(mi != this->TotalCoverage.end() && mi->first == file)
+    {
+    counts.swap(mi->second);
+    this->TotalCoverage.erase(mi);
+    }
+  for(std::vector<SpillReader*>::const_iterator r =
+        this->SpillReaders.begin(); r != this->SpillReaders.end(); ++r)
+    {
+    if((*r)->Valid && (*r)->File == file)
+      {
+      cmCTestCoverageHandlerMergeCounts(counts, (*r)->Counts);
+      (*r)->Next();
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------
+size_t cmCTestCoverageHandlerContainer::GetNumberOfFiles() const
+{
+  size_t count = this->SpilledNames.size();
+  for(TotalCoverageMap::const_iterator i = this->TotalCoverage.begin();
+      i != this->TotalCoverage.end(); ++i)
+    {
+    if(this->SpilledNames.find(i->first) == this->SpilledNames.end())
+      {
+      ++count;
+      }
+    }
+  return count;
+}
+
+//----------------------------------------------------------------------
+void cmCTestCoverageHandlerContainer
+::GetFileNames(std::set<std::string>& names) const
+{
+  names.insert(this->SpilledNames.begin(), this->SpilledNames.end());
+  for(TotalCoverageMap::const_iterator i = this->TotalCoverage.begin();
+      i != this->TotalCoverage.end(); ++i)
+    {
+    names.insert(i->first);
+    }
+}
 
 //----------------------------------------------------------------------
 cmCTestCoverageHandler::cmCTestCoverageHandler()
 {
+  this->GCovParallelLevel = 0;
+  this->MemoryLimit = 0;
 }
 
 //----------------------------------------------------------------------
@@ -145,6 +466,8 @@ void cmCTestCoverageHandler::Initialize()
 {
   this->Superclass::Initialize();
   this->CustomCoverageExclude.clear();
+  this->GCovParallelLevel = 0;
+  this->MemoryLimit = 0;
   this->SourceLabels.clear();
   this->TargetDirs.clear();
   this->LabelIdMap.clear();
@@ -365,6 +688,11 @@ int cmCTestCoverageHandler::ProcessHandler()
   cont.BinaryDir = binaryDir;
   cont.OFS = &ofs;
   cont.Quiet = this->Quiet;
+  cont.SpillDirectory = this->CTest->GetBinaryDir() + "/Testing/CoverageInfo";
+  if(this->MemoryLimit > 0)
+    {
+    cont.MemoryLimit = static_cast<size_t>(this->MemoryLimit) * 1024 * 1024;
+    }
 
   // setup the regex exclude stuff
   this->CustomCoverageExcludeRegex.clear();
@@ -472,7 +800,6 @@ int cmCTestCoverageHandler::ProcessHandler()
     {
     return -1;
     }
-  cmCTestCoverageHandlerContainer::TotalCoverageMap::iterator fileIterator;
   int cnt = 0;
   long total_tested = 0;
   long total_untested = 0;
@@ -486,10 +813,20 @@ int cmCTestCoverageHandler::ProcessHandler()
 
   std::vector<std::string> errorsWhileAccumulating;
 
+  if(cont.GetNumberOfSpills() > 0)
+    {
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+      " Merging line counts written to disk "
+      << cont.GetNumberOfSpills() << " times" << std::endl, this->Quiet);
+    }
+
+  // Each file is written as soon as its counts are combined and its
+  // counts are released right after.
+  size_t totalFiles = cont.GetNumberOfFiles();
+  std::string fullFileName;
+  cmCTestCoverageHandlerContainer::SingleFileCoverageVector fcov;
   file_count = 0;
-  for ( fileIterator = cont.TotalCoverage.begin();
-    fileIterator != cont.TotalCoverage.end();
-    ++fileIterator )
+  while ( cont.TakeNextFile(fullFileName, fcov) )
     {
     cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT, "." << std::flush,
       this->Quiet);
@@ -499,11 +836,10 @@ int cmCTestCoverageHandler::ProcessHandler()
       cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT, " processed: "
         << file_count
         << " out of "
-        << cont.TotalCoverage.size() << std::endl, this->Quiet);
+        << totalFiles << std::endl, this->Quiet);
       cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT, "    ", this->Quiet);
       }
 
-    const std::string fullFileName = fileIterator->first;
     bool shouldIDoCoverage
       = this->ShouldIDoCoverage(fullFileName.c_str(),
         sourceDir.c_str(), binaryDir.c_str());
@@ -540,8 +876,6 @@ int cmCTestCoverageHandler::ProcessHandler()
       = cmSystemTools::GetFilenameName(fullFileName);
     std::string shortFileName =
       this->CTest->GetShortPathToFile(fullFileName.c_str());
-    const cmCTestCoverageHandlerContainer::SingleFileCoverageVector& fcov
-      = fileIterator->second;
     covLogFile << "\t<File Name=\"" << cmXMLSafe(fileName)
       << "\" FullPath=\"" << cmXMLSafe(shortFileName) << "\">\n"
       << "\t\t<Report>" << std::endl;
@@ -748,6 +1082,10 @@ void cmCTestCoverageHandler::PopulateCustomVectors(cmMakefile *mf)
                                 this->CustomCoverageExclude);
   this->CTest->PopulateCustomVector(mf, "CTEST_EXTRA_COVERAGE_GLOB",
                                 this->ExtraCoverageGlobs);
+  this->CTest->PopulateCustomInteger(mf, "CTEST_COVERAGE_PARALLEL_LEVEL",
+                                     this->GCovParallelLevel);
+  this->CTest->PopulateCustomInteger(mf, "CTEST_COVERAGE_MEMORY_LIMIT",
+                                     this->MemoryLimit);
   std::vector<std::string>::iterator it;
   for ( it = this->CustomCoverageExclude.begin();
     it != this->CustomCoverageExclude.end();
@@ -1075,6 +1413,27 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
   cmCTestCoverageHandlerLocale locale_C;
   static_cast<void>(locale_C);
 
+  // Several gcov processes may run at once, each in its own directory.
+  // Their output is still processed in the order of the files so the
+  // results do not depend on which process finishes first.
+  size_t parallelLevel = static_cast<size_t>(this->GCovParallelLevel > 0?
+    this->GCovParallelLevel : this->CTest->GetParallelLevel());
+  std::deque<cmCTestGCovJob*> jobs;
+  std::vector<std::string> jobDirs;
+  std::vector<std::string>::const_iterator nextJob = files.begin();
+  if(parallelLevel > 1)
+    {
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+      " Running up to " << parallelLevel << " gcov processes at once"
+      << std::endl, this->Quiet);
+    for(size_t i = parallelLevel; i > 0; --i)
+      {
+      std::ostringstream dir;
+      dir << tempDir << "/gcov" << i;
+      jobDirs.push_back(dir.str());
+      }
+    }
+
   // files is a list of *.da and *.gcda files with coverage data in them.
   // These are binary files that you give as input to gcov so that it will
   // give us text output we can analyze to summarize coverage.
@@ -1087,10 +1446,8 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
     // Call gcov to get coverage data for this *.gcda file:
     //
     std::string fileDir = cmSystemTools::GetFilenamePath(*it);
-    std::string command = "\"" + gcovCommand + "\" " +
-      gcovExtraFlags + " " +
-      "-o \"" + fileDir + "\" " +
-      "\"" + *it + "\"";
+    std::string command =
+      this->GetGCovCommand(gcovCommand, gcovExtraFlags, *it);
 
     cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT, command.c_str()
       << std::endl, this->Quiet);
@@ -1100,8 +1457,33 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
     int retVal = 0;
     *cont->OFS << "* Run coverage for: " << fileDir << std::endl;
     *cont->OFS << "  Command: " << command << std::endl;
-    int res = this->CTest->RunCommand(command.c_str(), &output, &errors,
-      &retVal, tempDir.c_str(), 0 /*this->TimeOut*/);
+    int res;
+    std::string gcovDir = tempDir;
+    if(parallelLevel > 1)
+      {
+      // Keep a gcov process running in every free directory.
+      while(nextJob != files.end() && !jobDirs.empty())
+        {
+        jobs.push_back(new cmCTestGCovJob(
+          this->GetGCovCommand(gcovCommand, gcovExtraFlags, *nextJob),
+          jobDirs.back()));
+        jobDirs.pop_back();
+        ++nextJob;
+        }
+      cmCTestGCovJob* job = jobs.front();
+      jobs.pop_front();
+      res = job->Finish(output, errors, retVal)? 1 : 0;
+      gcovDir = job->GetDirectory();
+      delete job;
+
+      // The directory is reused once the output of this file is read.
+      jobDirs.push_back(gcovDir);
+      }
+    else
+      {
+      res = this->CTest->RunCommand(command.c_str(), &output, &errors,
+        &retVal, tempDir.c_str(), 0 /*this->TimeOut*/);
+      }
 
     *cont->OFS << "  Output: " << output << std::endl;
     *cont->OFS << "  Errors: " << errors << std::endl;
@@ -1299,12 +1681,22 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
       //
       if ( !gcovFile.empty() && !actualSourceFile.empty() )
         {
+        size_t fileCount = cont->TotalCoverage.size();
         cmCTestCoverageHandlerContainer::SingleFileCoverageVector& vec
           = cont->TotalCoverage[actualSourceFile];
+        size_t lineCount = vec.size();
+        if ( cont->TotalCoverage.size() != fileCount )
+          {
+          cont->MemoryInUse += actualSourceFile.size();
+          }
 
         cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
           "   in gcovFile: " << gcovFile << std::endl, this->Quiet);
 
+        if(!cmSystemTools::FileIsFullPath(gcovFile.c_str()))
+          {
+          gcovFile = gcovDir + "/" + gcovFile;
+          }
         cmsys::ifstream ifile(gcovFile.c_str());
         if ( ! ifile )
           {
@@ -1364,6 +1756,7 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
               }
             }
           }
+        cont->MemoryInUse += (vec.size() - lineCount) * sizeof(int);
 
         actualSourceFile = "";
         }
@@ -1424,6 +1817,9 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
 
     file_count++;
 
+    // Keep the line counts within the memory limit.
+    cont->SpillIfNeeded();
+
     if ( file_count % 50 == 0 )
       {
       cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT, " processed: "
@@ -1437,6 +1833,18 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
   return file_count;
 }
 
+//----------------------------------------------------------------------
+std::string cmCTestCoverageHandler::GetGCovCommand(
+  std::string const& gcovCommand, std::string const& gcovExtraFlags,
+  std::string const& file)
+{
+  std::string fileDir = cmSystemTools::GetFilenamePath(file);
+  return "\"" + gcovCommand + "\" " +
+    gcovExtraFlags + " " +
+    "-o \"" + fileDir + "\" " +
+    "\"" + file + "\"";
+}
+
 //----------------------------------------------------------------------
 int cmCTestCoverageHandler::HandleLCovCoverage(
   cmCTestCoverageHandlerContainer* cont)
@@ -2608,11 +3016,13 @@ std::set<std::string> cmCTestCoverageHandler::FindUncoveredFiles(
 
   if(!extraMatches.empty())
     {
-    for(cmCTestCoverageHandlerContainer::TotalCoverageMap::iterator i =
-        cont->TotalCoverage.begin(); i != cont->TotalCoverage.end(); ++i)
+    // Files whose line counts were spilled to disk are covered too.
+    std::set<std::string> covered;
+    cont->GetFileNames(covered);
+    for(std::set<std::string>::const_iterator i = covered.begin();
+        i != covered.end(); ++i)
       {
-      std::string shortPath = this->CTest->GetShortPathToFile(
-        i->first.c_str());
+      std::string shortPath = this->CTest->GetShortPathToFile(i->c_str());
       extraMatches.erase(shortPath);
       }
     }
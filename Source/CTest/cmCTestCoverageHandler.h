@@ -23,6 +23,9 @@ class cmGeneratedFileStream;
 class cmCTestCoverageHandlerContainer
 {
 public:
+  cmCTestCoverageHandlerContainer();
+  ~cmCTestCoverageHandlerContainer();
+
   int Error;
   std::string SourceDir;
   std::string BinaryDir;
@@ -31,6 +34,44 @@ public:
   TotalCoverageMap TotalCoverage;
   std::ostream* OFS;
   bool Quiet;
+
+  // Line counts may be moved from TotalCoverage to files in this
+  // directory when they take more than MemoryLimit bytes.  A limit of 0
+  // keeps everything in memory.
+  std::string SpillDirectory;
+  size_t MemoryLimit;
+
+  // Bytes of line counts added to TotalCoverage since the last spill.
+  // Handlers that call SpillIfNeeded keep this up to date.
+  size_t MemoryInUse;
+
+  /**
+   * Move the line counts in TotalCoverage to disk if they exceed the
+   * memory limit.
+   */
+  void SpillIfNeeded();
+
+  /**
+   * Remove the file that comes next in sorted order from TotalCoverage
+   * and the spilled line counts, and combine all its counts.  Returns
+   * false when no file is left.
+   */
+  bool TakeNextFile(std::string& file, SingleFileCoverageVector& counts);
+
+  /** Number of distinct files with line counts.  */
+  size_t GetNumberOfFiles() const;
+
+  /** Add the names of all files with line counts, spilled or not.  */
+  void GetFileNames(std::set<std::string>& names) const;
+
+  /** Number of times line counts were moved to disk.  */
+  size_t GetNumberOfSpills() const { return this->SpillFiles.size(); }
+
+private:
+  class SpillReader;
+  std::vector<std::string> SpillFiles;
+  std::vector<SpillReader*> SpillReaders;
+  std::set<std::string> SpilledNames;
 };
 /** \class cmCTestCoverageHandler
  * \brief A class that handles coverage computation for ctest
@@ -68,6 +109,9 @@ private:
   //! Handle coverage using GCC's GCov
   int HandleGCovCoverage(cmCTestCoverageHandlerContainer* cont);
   void FindGCovFiles(std::vector<std::string>& files);
+  std::string GetGCovCommand(std::string const& gcovCommand,
+                             std::string const& gcovExtraFlags,
+                             std::string const& file);
 
   //! Handle coverage using Intel's LCov
   int HandleLCovCoverage(cmCTestCoverageHandlerContainer* cont);
@@ -130,6 +174,13 @@ private:
   std::vector<cmsys::RegularExpression> CustomCoverageExcludeRegex;
   std::vector<std::string> ExtraCoverageGlobs;
 
+  // Number of gcov processes to run at once, or 0 to use the
+  // parallel level of ctest.
+  int GCovParallelLevel;
+
+  // Megabytes of gcov line counts to keep in memory, or 0 for no limit.
+  int MemoryLimit;
+
 
   // Map from source file to label ids.
   class LabelSet: public std::set<int> {};
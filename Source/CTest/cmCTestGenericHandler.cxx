@@ -143,6 +143,19 @@ bool cmCTestGenericHandler::StartLogFile(const char* name,
       "Cannot create log file without providing the name" << std::endl;);
     return false;
     }
+  std::string fname = this->GetLogFileName(name);
+  if( !this->CTest->OpenOutputFile("Temporary", fname, xofs) )
+    {
+    cmCTestLog(this->CTest, ERROR_MESSAGE, "Cannot create log file: "
+      << fname << std::endl);
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------
+std::string cmCTestGenericHandler::GetLogFileName(const char* name)
+{
   std::ostringstream ostr;
   ostr << "Last" << name;
   if ( this->SubmitIndex > 0 )
@@ -154,11 +167,5 @@ bool cmCTestGenericHandler::StartLogFile(const char* name,
     ostr << "_" << this->CTest->GetCurrentTag();
     }
   ostr << ".log";
-  if( !this->CTest->OpenOutputFile("Temporary", ostr.str(), xofs) )
-    {
-    cmCTestLog(this->CTest, ERROR_MESSAGE, "Cannot create log file: "
-      << ostr.str() << std::endl);
-    return false;
-    }
-  return true;
+  return ostr.str();
 }
@@ -94,6 +94,7 @@ protected:
   bool StartResultingXML(cmCTest::Part part,
                          const char* name, cmGeneratedFileStream& xofs);
   bool StartLogFile(const char* name, cmGeneratedFileStream& xofs);
+  std::string GetLogFileName(const char* name);
 
   bool AppendXML;
   bool Quiet;
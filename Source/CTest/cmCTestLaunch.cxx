@@ -11,6 +11,7 @@
 ============================================================================*/
 #include "cmCTestLaunch.h"
 
+#include "cmAlgorithms.h"
 #include "cmGeneratedFileStream.h"
 #include "cmSystemTools.h"
 #include "cmXMLSafe.h"
@@ -25,8 +26,38 @@
 #include <io.h> // for _setmode
 #include <fcntl.h> // for _O_BINARY
 #include <stdio.h> // for std{out,err} and fileno
+#include <windows.h>
+#include <cmsys/Encoding.hxx>
+#else
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
+//----------------------------------------------------------------------------
+// Get the next line of a log kept in memory the way GetLineFromStream
+// reads it from a file.
+static bool cmCTestLaunchGetLine(std::string const& log,
+                                 std::string::size_type& pos,
+                                 std::string& line)
+{
+  if(pos >= log.size())
+    {
+    return false;
+    }
+  std::string::size_type end = log.find('\n', pos);
+  if(end == std::string::npos)
+    {
+    end = log.size();
+    }
+  line.assign(log, pos, end - pos);
+  if(!line.empty() && line[line.size()-1] == '\r')
+    {
+    line.resize(line.size()-1);
+    }
+  pos = end + 1;
+  return true;
+}
+
 //----------------------------------------------------------------------------
 cmCTestLaunch::cmCTestLaunch(int argc, const char* const* argv)
 {
@@ -43,8 +74,6 @@ cmCTestLaunch::cmCTestLaunch(int argc, const char* const* argv)
   this->ComputeFileNames();
 
   this->ScrapeRulesLoaded = false;
-  this->HaveOut = false;
-  this->HaveErr = false;
   this->Process = cmsysProcess_New();
 }
 
@@ -52,11 +81,6 @@ cmCTestLaunch::cmCTestLaunch(int argc, const char* const* argv)
 cmCTestLaunch::~cmCTestLaunch()
 {
   cmsysProcess_Delete(this->Process);
-  if(!this->Passthru)
-    {
-    cmSystemTools::RemoveFile(this->LogOut);
-    cmSystemTools::RemoveFile(this->LogErr);
-    }
 }
 
 //----------------------------------------------------------------------------
@@ -207,7 +231,11 @@ void cmCTestLaunch::ComputeFileNames()
   this->LogDir = d;
   cmSystemTools::ConvertToUnixSlashes(this->LogDir);
   this->LogDir += "/";
+}
 
+//----------------------------------------------------------------------------
+void cmCTestLaunch::ComputeLogHash()
+{
   // We hash the input command working dir and command line to obtain
   // a repeatable and (probably) unique name for log files.
   char hash[32];
@@ -222,16 +250,6 @@ void cmCTestLaunch::ComputeFileNames()
   cmsysMD5_FinalizeHex(md5, hash);
   cmsysMD5_Delete(md5);
   this->LogHash.assign(hash, 32);
-
-  // We store stdout and stderr in temporary log files.
-  this->LogOut = this->LogDir;
-  this->LogOut += "launch-";
-  this->LogOut += this->LogHash;
-  this->LogOut += "-out.txt";
-  this->LogErr = this->LogDir;
-  this->LogErr += "launch-";
-  this->LogErr += this->LogHash;
-  this->LogErr += "-err.txt";
 }
 
 //----------------------------------------------------------------------------
@@ -248,22 +266,12 @@ void cmCTestLaunch::RunChild()
   cmsysProcess* cp = this->Process;
   cmsysProcess_SetCommand(cp, this->RealArgV);
 
-  cmsys::ofstream fout;
-  cmsys::ofstream ferr;
   if(this->Passthru)
     {
     // In passthru mode we just share the output pipes.
     cmsysProcess_SetPipeShared(cp, cmsysProcess_Pipe_STDOUT, 1);
     cmsysProcess_SetPipeShared(cp, cmsysProcess_Pipe_STDERR, 1);
     }
-  else
-    {
-    // In full mode we record the child output pipes to log files.
-    fout.open(this->LogOut.c_str(),
-              std::ios::out | std::ios::binary);
-    ferr.open(this->LogErr.c_str(),
-              std::ios::out | std::ios::binary);
-    }
 
 #ifdef _WIN32
   // Do this so that newline transformation is not done when writing to cout
@@ -275,7 +283,8 @@ void cmCTestLaunch::RunChild()
   // Run the real command.
   cmsysProcess_Execute(cp);
 
-  // Record child stdout and stderr if necessary.
+  // Record child stdout and stderr in memory if necessary.  Most rules
+  // produce no output and need no report at all.
   if(!this->Passthru)
     {
     char* data = 0;
@@ -284,15 +293,13 @@ void cmCTestLaunch::RunChild()
       {
       if(p == cmsysProcess_Pipe_STDOUT)
         {
-        fout.write(data, length);
+        this->LogOut.append(data, length);
         std::cout.write(data, length);
-        this->HaveOut = true;
         }
       else if(p == cmsysProcess_Pipe_STDERR)
         {
-        ferr.write(data, length);
+        this->LogErr.append(data, length);
         std::cerr.write(data, length);
-        this->HaveErr = true;
         }
       }
     }
@@ -399,14 +406,7 @@ bool cmCTestLaunch::IsError() const
 //----------------------------------------------------------------------------
 void cmCTestLaunch::WriteXML()
 {
-  // Name the xml file.
-  std::string logXML = this->LogDir;
-  logXML += this->IsError()? "error-" : "warning-";
-  logXML += this->LogHash;
-  logXML += ".xml";
-
-  // Use cmGeneratedFileStream to atomically create the report file.
-  cmGeneratedFileStream fxml(logXML.c_str());
+  std::ostringstream fxml;
   fxml << "\t<Failure type=\""
        << (this->IsError()? "Error" : "Warning") << "\">\n";
   this->WriteXMLAction(fxml);
@@ -414,6 +414,62 @@ void cmCTestLaunch::WriteXML()
   this->WriteXMLResult(fxml);
   this->WriteXMLLabels(fxml);
   fxml << "\t</Failure>\n";
+  std::string xml = fxml.str();
+
+  // Report to the journal of the build handler if it has one.
+  if(this->AppendToJournal(xml))
+    {
+    return;
+    }
+
+  // Name the xml file.
+  this->ComputeLogHash();
+  std::string logXML = this->LogDir;
+  logXML += this->IsError()? "error-" : "warning-";
+  logXML += this->LogHash;
+  logXML += ".xml";
+
+  // Use cmGeneratedFileStream to atomically create the report file.
+  cmGeneratedFileStream fout(logXML.c_str());
+  fout << xml;
+}
+
+//----------------------------------------------------------------------------
+bool cmCTestLaunch::AppendToJournal(std::string const& xml)
+{
+  // The journal is created by the build handler.  Each report is a
+  // header line with its type and size followed by the xml fragment.
+  // It is appended with a single write so that reports of launchers
+  // running at the same time do not interleave.
+  std::ostringstream record;
+  record << (this->IsError()? "error " : "warning ") << xml.size() << "\n"
+         << xml;
+  std::string const& data = record.str();
+  std::string journal = this->LogDir + "CTestLaunchJournal.txt";
+#ifdef _WIN32
+  HANDLE h = CreateFileW(cmsys::Encoding::ToWide(journal).c_str(),
+                         FILE_APPEND_DATA,
+                         FILE_SHARE_READ | FILE_SHARE_WRITE, 0,
+                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+  if(h == INVALID_HANDLE_VALUE)
+    {
+    return false;
+    }
+  DWORD written = 0;
+  BOOL ok = WriteFile(h, data.c_str(), static_cast<DWORD>(data.size()),
+                      &written, 0);
+  CloseHandle(h);
+  return ok && written == data.size();
+#else
+  int fd = open(journal.c_str(), O_WRONLY | O_APPEND);
+  if(fd < 0)
+    {
+    return false;
+    }
+  ssize_t written = write(fd, data.c_str(), data.size());
+  close(fd);
+  return written == static_cast<ssize_t>(data.size());
+#endif
 }
 
 //----------------------------------------------------------------------------
@@ -533,12 +589,12 @@ void cmCTestLaunch::WriteXMLResult(std::ostream& fxml)
 
   // StdOut
   fxml << "\t\t\t<StdOut>";
-  this->DumpFileToXML(fxml, this->LogOut);
+  this->DumpLogToXML(fxml, this->LogOut);
   fxml << "</StdOut>\n";
 
   // StdErr
   fxml << "\t\t\t<StdErr>";
-  this->DumpFileToXML(fxml, this->LogErr);
+  this->DumpLogToXML(fxml, this->LogErr);
   fxml << "</StdErr>\n";
 
   // ExitCondition
@@ -590,15 +646,14 @@ void cmCTestLaunch::WriteXMLLabels(std::ostream& fxml)
 }
 
 //----------------------------------------------------------------------------
-void cmCTestLaunch::DumpFileToXML(std::ostream& fxml,
-                                  std::string const& fname)
+void cmCTestLaunch::DumpLogToXML(std::ostream& fxml,
+                                 std::string const& log)
 {
-  cmsys::ifstream fin(fname.c_str(), std::ios::in | std::ios::binary);
-
   std::string line;
+  std::string::size_type pos = 0;
   const char* sep = "";
 
-  while(cmSystemTools::GetLineFromStream(fin, line))
+  while(cmCTestLaunchGetLine(log, pos, line))
     {
     if(MatchesFilterPrefix(line))
       {
@@ -626,8 +681,8 @@ bool cmCTestLaunch::CheckResults()
     }
 
   // Scrape the output logs to look for warnings.
-  if((this->HaveErr && this->ScrapeLog(this->LogErr)) ||
-     (this->HaveOut && this->ScrapeLog(this->LogOut)))
+  if((!this->LogErr.empty() && this->ScrapeLog(this->LogErr)) ||
+     (!this->LogOut.empty() && this->ScrapeLog(this->LogOut)))
     {
     return false;
     }
@@ -678,15 +733,15 @@ cmCTestLaunch
 }
 
 //----------------------------------------------------------------------------
-bool cmCTestLaunch::ScrapeLog(std::string const& fname)
+bool cmCTestLaunch::ScrapeLog(std::string const& log)
 {
   this->LoadScrapeRules();
 
-  // Look for log file lines matching warning expressions but not
+  // Look for log lines matching warning expressions but not
   // suppression expressions.
-  cmsys::ifstream fin(fname.c_str(), std::ios::in | std::ios::binary);
   std::string line;
-  while(cmSystemTools::GetLineFromStream(fin, line))
+  std::string::size_type pos = 0;
+  while(cmCTestLaunchGetLine(log, pos, line))
     {
     if(MatchesFilterPrefix(line))
       {
@@ -749,6 +804,25 @@ int cmCTestLaunch::Main(int argc, const char* const argv[])
 #include <cmsys/auto_ptr.hxx>
 void cmCTestLaunch::LoadConfig()
 {
+  // Read the plain configuration file if the build handler wrote one.
+  // This avoids creating a cmake instance to read the script below.
+  std::string config = this->LogDir;
+  config += "CTestLaunchConfig.txt";
+  cmsys::ifstream fin(config.c_str(), std::ios::in | std::ios::binary);
+  if(fin)
+    {
+    std::string line;
+    while(cmSystemTools::GetLineFromStream(fin, line))
+      {
+      if(cmHasLiteralPrefix(line, "SourceDirectory: "))
+        {
+        this->SourceDir = line.substr(17);
+        cmSystemTools::ConvertToUnixSlashes(this->SourceDir);
+        }
+      }
+    return;
+    }
+
   cmake cm;
   cmGlobalGenerator gg;
   gg.SetCMakeInstance(&cm);
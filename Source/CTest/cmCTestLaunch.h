@@ -60,17 +60,18 @@ private:
   // A hash of the real command line is unique and unlikely to collide.
   std::string LogHash;
   void ComputeFileNames();
+  void ComputeLogHash();
 
   bool Passthru;
   struct cmsysProcess_s* Process;
   int ExitCode;
 
-  // Temporary log files for stdout and stderr of real command.
+  // Directory for reports.
   std::string LogDir;
+
+  // Output of real command kept for scraping and reporting.
   std::string LogOut;
   std::string LogErr;
-  bool HaveOut;
-  bool HaveErr;
 
   // Labels associated with the build rule.
   std::set<std::string> Labels;
@@ -85,7 +86,7 @@ private:
   void LoadScrapeRules();
   void LoadScrapeRules(const char* purpose,
                        std::vector<cmsys::RegularExpression>& regexps);
-  bool ScrapeLog(std::string const& fname);
+  bool ScrapeLog(std::string const& log);
   bool Match(std::string const& line,
              std::vector<cmsys::RegularExpression>& regexps);
   bool MatchesFilterPrefix(std::string const& line) const;
@@ -96,7 +97,8 @@ private:
   void WriteXMLCommand(std::ostream& fxml);
   void WriteXMLResult(std::ostream& fxml);
   void WriteXMLLabels(std::ostream& fxml);
-  void DumpFileToXML(std::ostream& fxml, std::string const& fname);
+  void DumpLogToXML(std::ostream& fxml, std::string const& log);
+  bool AppendToJournal(std::string const& xml);
 
   // Configuration
   void LoadConfig();
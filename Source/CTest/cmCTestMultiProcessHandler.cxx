@@ -14,10 +14,12 @@
 #include "cmStandardIncludes.h"
 #include "cmCTest.h"
 #include "cmSystemTools.h"
+#include "cmFileLock.h"
+#include "cmFileLockResult.h"
 #include <stdlib.h>
 #include <stack>
-#include <list>
 #include <float.h>
+#include <math.h>
 #include <cmsys/FStream.hxx>
 
 class TestComparator
@@ -37,6 +39,30 @@ private:
   cmCTestMultiProcessHandler* Handler;
 };
 
+class TestCriticalPathComparator
+{
+public:
+  TestCriticalPathComparator(cmCTestMultiProcessHandler* handler)
+    : Handler(handler) {}
+
+  // Sorts tests in descending order of the longest chain of dependent
+  // tests, preferring tests that need more processors on ties
+  bool operator() (int index1, int index2) const
+    {
+    double cost1 = Handler->CriticalPathCost[index1];
+    double cost2 = Handler->CriticalPathCost[index2];
+    if(cost1 != cost2)
+      {
+      return cost1 > cost2;
+      }
+    return Handler->GetProcessorsUsed(index1) >
+      Handler->GetProcessorsUsed(index2);
+    }
+
+private:
+  cmCTestMultiProcessHandler* Handler;
+};
+
 cmCTestMultiProcessHandler::cmCTestMultiProcessHandler()
 {
   this->ParallelLevel = 1;
@@ -44,6 +70,11 @@ cmCTestMultiProcessHandler::cmCTestMultiProcessHandler()
   this->RunningCount = 0;
   this->StopTimePassed = false;
   this->HasCycles = false;
+  this->PredictedMakespan = 0;
+  this->ShardIndex = 1;
+  this->ShardCount = 1;
+  this->LastStartedTest = 0;
+  this->WaitTime = 0.001;
 }
 
 cmCTestMultiProcessHandler::~cmCTestMultiProcessHandler()
@@ -57,6 +88,14 @@ cmCTestMultiProcessHandler::SetTests(TestMap& tests,
 {
   this->Tests = tests;
   this->Properties = properties;
+  if(this->ShardCount > 1)
+    {
+    this->SelectShard();
+    }
+  if(!this->CTest->GetShowOnly())
+    {
+    this->ReadCostData();
+    }
   this->Total = this->Tests.size();
   // set test run map to false for all
   for(TestMap::iterator i = this->Tests.begin();
@@ -64,10 +103,14 @@ cmCTestMultiProcessHandler::SetTests(TestMap& tests,
     {
     this->TestRunningMap[i->first] = false;
     this->TestFinishMap[i->first] = false;
+    for(TestSet::const_iterator j = i->second.begin();
+        j != i->second.end(); ++j)
+      {
+      this->Dependents[*j].insert(i->first);
+      }
     }
   if(!this->CTest->GetShowOnly())
     {
-    this->ReadCostData();
     this->HasCycles = !this->CheckCycles();
     if(this->HasCycles)
       {
@@ -92,6 +135,7 @@ void cmCTestMultiProcessHandler::RunTests()
     return;
     }
   this->TestHandler->SetMaxIndex(this->FindMaxIndex());
+  double startTime = cmSystemTools::GetTime();
   this->StartNextTests();
   while(!this->Tests.empty())
     {
@@ -108,6 +152,15 @@ void cmCTestMultiProcessHandler::RunTests()
     }
   this->MarkFinished();
   this->UpdateCostData();
+
+  if(this->ParallelLevel > 1)
+    {
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+      "Predicted makespan: " << std::fixed << std::setprecision(2)
+      << this->PredictedMakespan << " sec, actual: "
+      << cmSystemTools::GetTime() - startTime << " sec" << std::endl,
+      this->Quiet);
+    }
 }
 
 //---------------------------------------------------------
@@ -133,6 +186,7 @@ void cmCTestMultiProcessHandler::StartTestProcess(int test)
   if(testRun->StartTest(this->Total))
     {
     this->RunningTests.insert(testRun);
+    this->LastStartedTest = testRun;
     }
   else if(testRun->IsStopTimePassed())
     {
@@ -142,20 +196,20 @@ void cmCTestMultiProcessHandler::StartTestProcess(int test)
     }
   else
     {
-
-    for(TestMap::iterator j = this->Tests.begin();
-      j != this->Tests.end(); ++j)
-      {
-      j->second.erase(test);
-      }
-
+    this->ReleaseDependents(test);
     this->UnlockResources(test);
     this->Completed++;
     this->TestFinishMap[test] = true;
     this->TestRunningMap[test] = false;
     this->RunningCount -= GetProcessorsUsed(test);
-    testRun->EndTest(this->Completed, this->Total, false);
-    this->Failed->push_back(this->Properties[test]->Name);
+    if(testRun->EndTest(this->Completed, this->Total, false))
+      {
+      this->Passed->push_back(this->Properties[test]->Name);
+      }
+    else
+      {
+      this->Failed->push_back(this->Properties[test]->Name);
+      }
     delete testRun;
     }
   cmSystemTools::ChangeDirectory(current_dir);
@@ -188,6 +242,25 @@ void cmCTestMultiProcessHandler::EraseTest(int test)
     std::find(this->SortedTests.begin(), this->SortedTests.end(), test));
 }
 
+//---------------------------------------------------------
+void cmCTestMultiProcessHandler::ReleaseDependents(int test)
+{
+  TestMap::const_iterator dependents = this->Dependents.find(test);
+  if(dependents == this->Dependents.end())
+    {
+    return;
+    }
+  for(TestSet::const_iterator i = dependents->second.begin();
+      i != dependents->second.end(); ++i)
+    {
+    TestMap::iterator j = this->Tests.find(*i);
+    if(j != this->Tests.end())
+      {
+      j->second.erase(test);
+      }
+    }
+}
+
 //---------------------------------------------------------
 inline size_t cmCTestMultiProcessHandler::GetProcessorsUsed(int test)
 {
@@ -273,15 +346,47 @@ bool cmCTestMultiProcessHandler::CheckOutput()
     }
   std::vector<cmCTestRunTest*> finished;
   std::string out, err;
+
+  // Collect the output of all running tests without waiting.
   for(std::set<cmCTestRunTest*>::const_iterator i = this->RunningTests.begin();
       i != this->RunningTests.end(); ++i)
     {
     cmCTestRunTest* p = *i;
-    if(!p->CheckOutput())
+    if(!p->CheckOutput(0))
       {
       finished.push_back(p);
       }
     }
+
+  // If no test finished, wait for the most recently started one, which
+  // is the most likely to finish first.  Wait longer each time nothing
+  // happens, so that long quiet tests cost little, and wait shortly
+  // again as soon as any test makes progress.
+  if(finished.empty())
+    {
+    cmCTestRunTest* p = this->LastStartedTest;
+    if(!p)
+      {
+      p = *this->RunningTests.begin();
+      }
+    double start = cmSystemTools::GetTime();
+    if(!p->CheckOutput(this->WaitTime))
+      {
+      finished.push_back(p);
+      }
+    else if(cmSystemTools::GetTime() - start >= this->WaitTime)
+      {
+      this->WaitTime = std::min(this->WaitTime * 2, 0.1);
+      }
+    else
+      {
+      this->WaitTime = 0.001;
+      }
+    }
+  else
+    {
+    this->WaitTime = 0.001;
+    }
   for( std::vector<cmCTestRunTest*>::iterator i = finished.begin();
        i != finished.end(); ++i)
     {
@@ -297,31 +402,132 @@ bool cmCTestMultiProcessHandler::CheckOutput()
       {
       this->Failed->push_back(p->GetTestProperties()->Name);
       }
-    for(TestMap::iterator j = this->Tests.begin();
-        j != this->Tests.end(); ++j)
-      {
-      j->second.erase(test);
-      }
+    this->ReleaseDependents(test);
     this->TestFinishMap[test] = true;
     this->TestRunningMap[test] = false;
     this->RunningTests.erase(p);
     this->WriteCheckpoint(test);
     this->UnlockResources(test);
     this->RunningCount -= GetProcessorsUsed(test);
+    if(p == this->LastStartedTest)
+      {
+      this->LastStartedTest = 0;
+      }
     delete p;
     }
   return true;
 }
 
+//---------------------------------------------------------
+static float cmCTestMultiProcessHandlerParseCost(std::string const& str)
+{
+  // The cost data file may be edited by hand.  Reject negative and
+  // non-finite values, which would break the ordering of tests by cost.
+  double value = atof(str.c_str());
+  if(!(value - value == 0) || value < 0 || value > FLT_MAX)
+    {
+    return 0;
+    }
+  return static_cast<float>(value);
+}
+
+//---------------------------------------------------------
+static bool cmCTestMultiProcessHandlerParseCostLine(std::string const& line,
+                                                    std::string& name,
+                                                    int& prev, float& cost,
+                                                    float& variance)
+{
+  //Format: <name> <previous_runs> <avg_cost> [<cost_variance>]
+  std::vector<cmsys::String> parts = cmSystemTools::SplitString(line, ' ');
+  if(parts.size() < 3)
+    {
+    return false;
+    }
+  name = parts[0];
+  prev = atoi(parts[1].c_str());
+  if(prev < 0)
+    {
+    prev = 0;
+    }
+  cost = cmCTestMultiProcessHandlerParseCost(parts[2]);
+  // Files written by older versions do not record the variance
+  variance = parts.size() < 4 ? 0 :
+    cmCTestMultiProcessHandlerParseCost(parts[3]);
+  return true;
+}
+
+//---------------------------------------------------------
+static void cmCTestMultiProcessHandlerLockCostData(cmCTest* ctest,
+                                                  cmFileLock& lock)
+{
+  std::string lockFile = ctest->GetCostDataFile() + ".lock";
+  cmSystemTools::Touch(lockFile, true);
+  cmFileLockResult result = lock.Lock(lockFile, 60);
+  if(!result.IsOk())
+    {
+    cmCTestLog(ctest, WARNING, "Cannot lock " << lockFile << ": "
+      << result.GetOutputMessage() << std::endl);
+    }
+}
+
+//---------------------------------------------------------
+// Read the entries of a cost data file in the order of the file.  A
+// later entry of the same name replaces an earlier one.
+static void cmCTestMultiProcessHandlerReadCostFile(
+  std::string const& fname, std::vector<std::string>& names,
+  std::map<std::string, std::string>& entries,
+  std::vector<std::string>& failed)
+{
+  cmsys::ifstream fin(fname.c_str());
+  std::string line;
+  while(std::getline(fin, line))
+    {
+    if(line == "---")
+      {
+      while(std::getline(fin, line))
+        {
+        if(!line.empty())
+          {
+          failed.push_back(line);
+          }
+        }
+      break;
+      }
+    std::string name;
+    int prev;
+    float cost;
+    float variance;
+    if(!cmCTestMultiProcessHandlerParseCostLine(line, name, prev, cost,
+                                                variance))
+      {
+      break;
+      }
+    std::ostringstream entry;
+    entry << name << " " << prev << " " << cost << " " << variance;
+    if(entries.find(name) == entries.end())
+      {
+      names.push_back(name);
+      }
+    entries[name] = entry.str();
+    }
+}
+
 //---------------------------------------------------------
 void cmCTestMultiProcessHandler::UpdateCostData()
 {
+  if(this->ShardCount > 1)
+    {
+    this->UpdateShardCostData();
+    return;
+    }
   std::string fname = this->CTest->GetCostDataFile();
   std::string tmpout = fname + ".tmp";
   cmsys::ofstream fout;
   fout.open(tmpout.c_str());
 
   PropertiesMap temp = this->Properties;
+  std::map<std::string, int> indexes;
+  this->GetTestIndexesByName(indexes);
 
   if(cmSystemTools::FileExists(fname.c_str()))
     {
@@ -332,27 +538,32 @@ void cmCTestMultiProcessHandler::UpdateCostData()
     while(std::getline(fin, line))
       {
       if(line == "---") break;
-      std::vector<cmsys::String> parts =
-        cmSystemTools::SplitString(line, ' ');
-      //Format: <name> <previous_runs> <avg_cost>
-      if(parts.size() < 3) break;
-
-      std::string name = parts[0];
-      int prev = atoi(parts[1].c_str());
-      float cost = static_cast<float>(atof(parts[2].c_str()));
+      std::string name;
+      int prev;
+      float cost;
+      float variance;
+      if(!cmCTestMultiProcessHandlerParseCostLine(line, name, prev, cost,
+                                                  variance))
+        {
+        break;
+        }
 
-      int index = this->SearchByName(name);
-      if(index == -1)
+      std::map<std::string, int>::const_iterator index =
+        indexes.find(name);
+      if(index == indexes.end())
         {
         // This test is not in memory. We just rewrite the entry
-        fout << name << " " << prev << " " << cost << "\n";
+        fout << name << " " << prev << " " << cost << " " << variance
+          << "\n";
         }
       else
         {
         // Update with our new average cost
-        fout << name << " " << this->Properties[index]->PreviousRuns << " "
-          << this->Properties[index]->Cost << "\n";
-        temp.erase(index);
+        cmCTestTestHandler::cmCTestTestProperties* p =
+          this->Properties[index->second];
+        fout << name << " " << p->PreviousRuns << " "
+          << p->Cost << " " << p->CostVariance << "\n";
+        temp.erase(index->second);
         }
       }
     fin.close();
@@ -363,7 +574,7 @@ void cmCTestMultiProcessHandler::UpdateCostData()
   for(PropertiesMap::iterator i = temp.begin(); i != temp.end(); ++i)
     {
     fout << i->second->Name << " " << i->second->PreviousRuns << " "
-      << i->second->Cost << "\n";
+      << i->second->Cost << " " << i->second->CostVariance << "\n";
     }
 
   // Write list of failed tests
@@ -377,6 +588,109 @@ void cmCTestMultiProcessHandler::UpdateCostData()
   cmSystemTools::RenameFile(tmpout.c_str(), fname.c_str());
 }
 
+//---------------------------------------------------------
+void cmCTestMultiProcessHandler::UpdateShardCostData()
+{
+  // Each shard records its results in a file of its own.  The last shard
+  // to finish merges them into the cost data file, which therefore stays
+  // the same while shards of one round start and they all compute the
+  // same partition from it.
+  std::string fname = this->CTest->GetCostDataFile();
+  cmFileLock lock;
+  cmCTestMultiProcessHandlerLockCostData(this->CTest, lock);
+
+  std::vector<std::string> shardFiles;
+  for(int s = 1; s <= this->ShardCount; ++s)
+    {
+    std::ostringstream shardFile;
+    shardFile << fname << "." << s << "of" << this->ShardCount;
+    shardFiles.push_back(shardFile.str());
+    }
+
+  std::ostringstream tmpout;
+  tmpout << fname << "." << cmSystemTools::RandomSeed() << ".tmp";
+  cmsys::ofstream fout(tmpout.str().c_str());
+  for(PropertiesMap::iterator i = this->Properties.begin();
+      i != this->Properties.end(); ++i)
+    {
+    fout << i->second->Name << " " << i->second->PreviousRuns << " "
+      << i->second->Cost << " " << i->second->CostVariance << "\n";
+    }
+  fout << "---\n";
+  for(std::vector<std::string>::iterator i = this->Failed->begin();
+      i != this->Failed->end(); ++i)
+    {
+    fout << *i << "\n";
+    }
+  fout.close();
+  cmSystemTools::RenameFile(tmpout.str().c_str(),
+                            shardFiles[this->ShardIndex - 1].c_str());
+
+  for(std::vector<std::string>::iterator f = shardFiles.begin();
+      f != shardFiles.end(); ++f)
+    {
+    if(!cmSystemTools::FileExists(f->c_str(), true))
+      {
+      return;
+      }
+    }
+
+  // All shards have finished.  Their entries replace the recorded ones,
+  // and tests that ran in none of them keep theirs.
+  std::vector<std::string> names;
+  std::map<std::string, std::string> entries;
+  std::vector<std::string> oldFailed;
+  cmCTestMultiProcessHandlerReadCostFile(fname, names, entries, oldFailed);
+  std::set<std::string> ran;
+  std::vector<std::string> failed;
+  for(std::vector<std::string>::iterator f = shardFiles.begin();
+      f != shardFiles.end(); ++f)
+    {
+    std::vector<std::string> shardNames;
+    std::map<std::string, std::string> shardEntries;
+    cmCTestMultiProcessHandlerReadCostFile(*f, shardNames, shardEntries,
+                                           failed);
+    for(std::vector<std::string>::iterator n = shardNames.begin();
+        n != shardNames.end(); ++n)
+      {
+      if(entries.find(*n) == entries.end())
+        {
+        names.push_back(*n);
+        }
+      entries[*n] = shardEntries[*n];
+      ran.insert(*n);
+      }
+    }
+  for(std::vector<std::string>::iterator i = oldFailed.begin();
+      i != oldFailed.end(); ++i)
+    {
+    if(ran.find(*i) == ran.end())
+      {
+      failed.push_back(*i);
+      }
+    }
+
+  fout.open(tmpout.str().c_str());
+  for(std::vector<std::string>::iterator n = names.begin();
+      n != names.end(); ++n)
+    {
+    fout << entries[*n] << "\n";
+    }
+  fout << "---\n";
+  for(std::vector<std::string>::iterator i = failed.begin();
+      i != failed.end(); ++i)
+    {
+    fout << *i << "\n";
+    }
+  fout.close();
+  cmSystemTools::RenameFile(tmpout.str().c_str(), fname.c_str());
+  for(std::vector<std::string>::iterator f = shardFiles.begin();
+      f != shardFiles.end(); ++f)
+    {
+    cmSystemTools::RemoveFile(*f);
+    }
+}
+
 //---------------------------------------------------------
 void cmCTestMultiProcessHandler::ReadCostData()
 {
@@ -386,27 +700,28 @@ void cmCTestMultiProcessHandler::ReadCostData()
     {
     cmsys::ifstream fin;
     fin.open(fname.c_str());
+    std::map<std::string, int> indexes;
+    this->GetTestIndexesByName(indexes);
     std::string line;
     while(std::getline(fin, line))
       {
       if(line == "---") break;
 
-      std::vector<cmsys::String> parts =
-        cmSystemTools::SplitString(line, ' ');
-
+      std::string name;
+      int prev;
+      float cost;
+      float variance;
       // Probably an older version of the file, will be fixed next run
-      if(parts.size() < 3)
+      if(!cmCTestMultiProcessHandlerParseCostLine(line, name, prev, cost,
+                                                  variance))
         {
         fin.close();
         return;
         }
 
-      std::string name = parts[0];
-      int prev = atoi(parts[1].c_str());
-      float cost = static_cast<float>(atof(parts[2].c_str()));
-
-      int index = this->SearchByName(name);
-      if(index == -1) continue;
+      std::map<std::string, int>::const_iterator found = indexes.find(name);
+      if(found == indexes.end()) continue;
+      int index = found->second;
 
       this->Properties[index]->PreviousRuns = prev;
       // When not running in parallel mode, don't use cost data
@@ -415,6 +730,7 @@ void cmCTestMultiProcessHandler::ReadCostData()
          this->Properties[index]->Cost == 0)
         {
         this->Properties[index]->Cost = cost;
+        this->Properties[index]->CostVariance = variance;
         }
       }
     // Next part of the file is the failed tests
@@ -430,19 +746,195 @@ void cmCTestMultiProcessHandler::ReadCostData()
 }
 
 //---------------------------------------------------------
-int cmCTestMultiProcessHandler::SearchByName(std::string name)
+static int cmCTestShardGroupOf(std::map<int, int>& parent, int test)
 {
-  int index = -1;
+  int root = test;
+  while(parent[root] != root)
+    {
+    root = parent[root];
+    }
+  while(parent[test] != root)
+    {
+    int next = parent[test];
+    parent[test] = root;
+    test = next;
+    }
+  return root;
+}
 
+//---------------------------------------------------------
+static void cmCTestShardJoin(std::map<int, int>& parent, int a, int b)
+{
+  a = cmCTestShardGroupOf(parent, a);
+  b = cmCTestShardGroupOf(parent, b);
+  // Use the lowest test index as the root so that the result does not
+  // depend on the order of the joins.
+  if(a < b)
+    {
+    parent[b] = a;
+    }
+  else
+    {
+    parent[a] = b;
+    }
+}
+
+//---------------------------------------------------------
+void cmCTestMultiProcessHandler::SelectShard()
+{
+  // Every process running a shard must compute the same partition.  The
+  // cost data file changes only when all shards of a round have finished,
+  // so the times recorded in it are the same for all of them.
+  std::map<std::string, float> recorded;
+  if(cmSystemTools::FileExists(this->CTest->GetCostDataFile().c_str(), true))
+    {
+    cmFileLock lock;
+    cmCTestMultiProcessHandlerLockCostData(this->CTest, lock);
+    std::vector<std::string> names;
+    std::map<std::string, std::string> entries;
+    std::vector<std::string> failed;
+    cmCTestMultiProcessHandlerReadCostFile(this->CTest->GetCostDataFile(),
+                                           names, entries, failed);
+    for(std::map<std::string, std::string>::iterator e = entries.begin();
+        e != entries.end(); ++e)
+      {
+      std::string name;
+      int prev;
+      float variance;
+      cmCTestMultiProcessHandlerParseCostLine(e->second, name, prev,
+                                              recorded[e->first], variance);
+      }
+    }
+
+  // The COST property takes precedence over the recorded time.  Unless
+  // every estimate comes from recorded times it is not in seconds.
+  bool randomCost = this->CTest->GetScheduleType() == "Random";
+  bool seconds = true;
+  std::map<int, double> estimates;
+  double knownTotal = 0;
+  int knownCount = 0;
   for(PropertiesMap::iterator i = this->Properties.begin();
       i != this->Properties.end(); ++i)
     {
-    if(i->second->Name == name)
+    double cost = randomCost ? 0 : i->second->Cost;
+    if(cost > 0)
+      {
+      seconds = false;
+      }
+    else
+      {
+      std::map<std::string, float>::const_iterator r =
+        recorded.find(i->second->Name);
+      cost = r != recorded.end() ? r->second : 0;
+      }
+    if(cost > 0)
+      {
+      estimates[i->first] = cost;
+      knownTotal += cost;
+      ++knownCount;
+      }
+    }
+  if(knownCount == 0)
+    {
+    seconds = false;
+    }
+  // Tests without a cost are assumed to take the average time.
+  double unknownCost = knownCount > 0 ? knownTotal / knownCount : 1;
+
+  // Tests that depend on each other or share a resource lock must run
+  // in the same shard.
+  std::map<int, int> parent;
+  for(TestMap::iterator i = this->Tests.begin(); i != this->Tests.end(); ++i)
+    {
+    parent[i->first] = i->first;
+    }
+  std::map<std::string, int> lockOwners;
+  for(TestMap::iterator i = this->Tests.begin(); i != this->Tests.end(); ++i)
+    {
+    for(TestSet::const_iterator d = i->second.begin();
+        d != i->second.end(); ++d)
+      {
+      if(parent.find(*d) != parent.end())
+        {
+        cmCTestShardJoin(parent, i->first, *d);
+        }
+      }
+    std::set<std::string> const& locks =
+      this->Properties[i->first]->LockedResources;
+    for(std::set<std::string>::const_iterator l = locks.begin();
+        l != locks.end(); ++l)
       {
-      index = i->first;
+      std::map<std::string, int>::iterator owner =
+        lockOwners.insert(std::make_pair(*l, i->first)).first;
+      cmCTestShardJoin(parent, i->first, owner->second);
       }
     }
-  return index;
+  std::map<int, double> groupCosts;
+  for(TestMap::iterator i = this->Tests.begin(); i != this->Tests.end(); ++i)
+    {
+    std::map<int, double>::const_iterator e = estimates.find(i->first);
+    groupCosts[cmCTestShardGroupOf(parent, i->first)] +=
+      e != estimates.end() ? e->second : unknownCost;
+    }
+
+  // Assign the most expensive groups first, each to the shard with the
+  // least work so far.  Ties go to the group with the lowest index.
+  std::vector<std::pair<double, int> > groups;
+  for(std::map<int, double>::iterator g = groupCosts.begin();
+      g != groupCosts.end(); ++g)
+    {
+    groups.push_back(std::make_pair(-g->second, g->first));
+    }
+  std::sort(groups.begin(), groups.end());
+  std::vector<double> shardCosts(this->ShardCount, 0);
+  std::map<int, int> groupShards;
+  for(std::vector<std::pair<double, int> >::iterator g = groups.begin();
+      g != groups.end(); ++g)
+    {
+    int shard = static_cast<int>(
+      std::min_element(shardCosts.begin(), shardCosts.end()) -
+      shardCosts.begin());
+    shardCosts[shard] -= g->first;
+    groupShards[g->second] = shard;
+    }
+
+  std::vector<int> shardSizes(this->ShardCount, 0);
+  size_t total = this->Tests.size();
+  for(std::map<int, int>::iterator i = parent.begin(); i != parent.end(); ++i)
+    {
+    int shard = groupShards[cmCTestShardGroupOf(parent, i->first)];
+    ++shardSizes[shard];
+    if(shard != this->ShardIndex - 1)
+      {
+      this->Tests.erase(i->first);
+      this->Properties.erase(i->first);
+      }
+    }
+
+  cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT, "Test shard "
+    << this->ShardIndex << "/" << this->ShardCount << ": "
+    << this->Tests.size() << " of " << total << " tests" << std::endl,
+    this->Quiet);
+  for(int s = 0; s < this->ShardCount; ++s)
+    {
+    cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT, "  Shard " << s + 1
+      << ": " << shardSizes[s] << " tests, predicted "
+      << (seconds ? "" : "cost ") << std::fixed << std::setprecision(2)
+      << shardCosts[s] << (seconds ? " sec" : "") << std::endl,
+      this->Quiet);
+    }
+}
+
+//---------------------------------------------------------
+void cmCTestMultiProcessHandler::GetTestIndexesByName(
+  std::map<std::string, int>& indexes)
+{
+  // Later tests take precedence over earlier ones of the same name
+  for(PropertiesMap::iterator i = this->Properties.begin();
+      i != this->Properties.end(); ++i)
+    {
+    indexes[i->second->Name] = i->first;
+    }
 }
 
 //---------------------------------------------------------
@@ -461,11 +953,7 @@ void cmCTestMultiProcessHandler::CreateTestCostList()
 //---------------------------------------------------------
 void cmCTestMultiProcessHandler::CreateParallelTestCostList()
 {
-  TestSet alreadySortedTests;
-
-  std::list<TestSet> priorityStack;
-  priorityStack.push_back(TestSet());
-  TestSet &topLevel = priorityStack.back();
+  TestList remainingTests;
 
   // In parallel test runs add previously failed tests to the front
   // of the cost list and queue other tests for further sorting
@@ -477,65 +965,96 @@ void cmCTestMultiProcessHandler::CreateParallelTestCostList()
       {
       //If the test failed last time, it should be run first.
       this->SortedTests.push_back(i->first);
-      alreadySortedTests.insert(i->first);
       }
     else
       {
-      topLevel.insert(i->first);
+      remainingTests.push_back(i->first);
       }
     }
 
-  // In parallel test runs repeatedly move dependencies of the tests on
-  // the current dependency level to the next level until no
-  // further dependencies exist.
-  while(priorityStack.back().size())
+  // Estimate the execution time of each test by its average cost plus
+  // one standard deviation so that tests with unsteady run times are
+  // started early enough.  Tests without a known cost are assumed to
+  // take as long as the average of the others.
+  std::map<int, double> estimates;
+  double knownTotal = 0;
+  size_t knownCount = 0;
+  for(TestMap::const_iterator i = this->Tests.begin();
+    i != this->Tests.end(); ++i)
     {
-    TestSet &previousSet = priorityStack.back();
-    priorityStack.push_back(TestSet());
-    TestSet &currentSet = priorityStack.back();
-
-    for(TestSet::const_iterator i = previousSet.begin();
-      i != previousSet.end(); ++i)
+    cmCTestTestHandler::cmCTestTestProperties* p = this->Properties[i->first];
+    if(p->Cost != 0)
       {
-      TestSet const& dependencies = this->Tests[*i];
-      currentSet.insert(dependencies.begin(), dependencies.end());
+      double estimate = p->Cost + sqrt(static_cast<double>(p->CostVariance));
+      estimates[i->first] = estimate;
+      knownTotal += estimate;
+      knownCount++;
       }
-
-    for(TestSet::const_iterator i = currentSet.begin();
-      i != currentSet.end(); ++i)
+    }
+  double defaultEstimate = knownCount > 0 ? knownTotal / knownCount : 1.0;
+  for(TestMap::const_iterator i = this->Tests.begin();
+    i != this->Tests.end(); ++i)
+    {
+    if(estimates.find(i->first) == estimates.end())
       {
-      previousSet.erase(*i);
+      estimates[i->first] = defaultEstimate;
       }
     }
 
-  // Remove the empty dependency level
-  priorityStack.pop_back();
-
-  // Reverse iterate over the different dependency levels (deepest first).
-  // Sort tests within each level by COST and append them to the cost list.
-  for(std::list<TestSet>::reverse_iterator i = priorityStack.rbegin();
-    i != priorityStack.rend(); ++i)
+  // Compute for each test the estimated time to run it and the longest
+  // chain of tests that depend on it.  Starting the longest chains
+  // first shortens the total run time when dependencies exist.
+  double longestPath = 0;
+  double totalWork = 0;
+  for(TestMap::const_iterator i = this->Tests.begin();
+    i != this->Tests.end(); ++i)
     {
-    TestSet const& currentSet = *i;
-    TestComparator comp(this);
+    double pathCost =
+      this->ComputeCriticalPathCost(i->first, estimates);
+    longestPath = std::max(longestPath, pathCost);
+    totalWork += std::max(estimates[i->first], 0.0) *
+      static_cast<double>(this->GetProcessorsUsed(i->first));
+    }
 
-    TestList sortedCopy;
+  // No schedule can finish before its longest chain of dependent tests,
+  // nor before all work is spread over the available processors.
+  this->PredictedMakespan = std::max(longestPath,
+    totalWork / static_cast<double>(this->ParallelLevel));
 
-    sortedCopy.insert(sortedCopy.end(),
-                      currentSet.begin(), currentSet.end());
+  TestCriticalPathComparator comp(this);
+  std::stable_sort(remainingTests.begin(), remainingTests.end(), comp);
+  this->SortedTests.insert(this->SortedTests.end(),
+                           remainingTests.begin(), remainingTests.end());
+}
 
-    std::stable_sort(sortedCopy.begin(), sortedCopy.end(), comp);
+//---------------------------------------------------------
+double cmCTestMultiProcessHandler::ComputeCriticalPathCost(
+  int test, std::map<int, double> const& estimates)
+{
+  std::map<int, double>::const_iterator cached =
+    this->CriticalPathCost.find(test);
+  if(cached != this->CriticalPathCost.end())
+    {
+    return cached->second;
+    }
 
-    for(TestList::const_iterator j = sortedCopy.begin();
-      j != sortedCopy.end(); ++j)
+  double longestDependent = 0;
+  TestMap::const_iterator dependents = this->Dependents.find(test);
+  if(dependents != this->Dependents.end())
+    {
+    for(TestSet::const_iterator i = dependents->second.begin();
+      i != dependents->second.end(); ++i)
       {
-      if(alreadySortedTests.find(*j) == alreadySortedTests.end())
-        {
-        this->SortedTests.push_back(*j);
-        alreadySortedTests.insert(*j);
-        }
+      longestDependent = std::max(longestDependent,
+        this->ComputeCriticalPathCost(*i, estimates));
       }
     }
+
+  std::map<int, double>::const_iterator estimate = estimates.find(test);
+  double pathCost = longestDependent +
+    (estimate != estimates.end()? estimate->second : 0.0);
+  this->CriticalPathCost[test] = pathCost;
+  return pathCost;
 }
 
 //---------------------------------------------------------
@@ -24,6 +24,7 @@
 class cmCTestMultiProcessHandler
 {
   friend class TestComparator;
+  friend class TestCriticalPathComparator;
 public:
   struct TestSet : public std::set<int> {};
   struct TestMap : public std::map<int, TestSet> {};
@@ -37,6 +38,12 @@ public:
   void SetTests(TestMap& tests, PropertiesMap& properties);
   // Set the max number of tests that can be run at the same time.
   void SetParallelLevel(size_t);
+  // Run only the given part (1 to count) of the tests.
+  void SetShard(int index, int count)
+    {
+    this->ShardIndex = index;
+    this->ShardCount = count;
+    }
   virtual void RunTests();
   void PrintTestList();
   void PrintLabels();
@@ -69,20 +76,28 @@ protected:
   void WriteCheckpoint(int index);
 
   void UpdateCostData();
+  // Record the results of a shard and merge those of all shards
+  void UpdateShardCostData();
   void ReadCostData();
-  // Return index of a test based on its name
-  int SearchByName(std::string name);
+  // Map the name of each test to its index
+  void GetTestIndexesByName(std::map<std::string, int>& indexes);
 
   void CreateTestCostList();
+  // Remove the tests that belong to other shards
+  void SelectShard();
 
   void GetAllTestDependencies(int test, TestList& dependencies);
   void CreateSerialTestCostList();
 
   void CreateParallelTestCostList();
+  double ComputeCriticalPathCost(int test,
+                                 std::map<int, double> const& estimates);
 
   // Removes the checkpoint file
   void MarkFinished();
   void EraseTest(int index);
+  // Remove a finished test from the depends of the tests waiting on it
+  void ReleaseDependents(int index);
   // Return true if there are still tests running
   // check all running processes for output and exit case
   bool CheckOutput();
@@ -98,6 +113,8 @@ protected:
   void UnlockResources(int index);
   // map from test number to set of depend tests
   TestMap Tests;
+  // map from test number to set of tests depending on it
+  TestMap Dependents;
   TestList SortedTests;
   //Total number of tests we'll be running
   size_t Total;
@@ -107,6 +124,11 @@ protected:
   bool StopTimePassed;
   //list of test properties (indices concurrent to the test map)
   PropertiesMap Properties;
+  // Estimated time to finish each test and all tests depending on it
+  std::map<int, double> CriticalPathCost;
+  double PredictedMakespan;
+  int ShardIndex;
+  int ShardCount;
   std::map<int, bool> TestRunningMap;
   std::map<int, bool> TestFinishMap;
   std::map<int, std::string> TestOutput;
@@ -117,6 +139,8 @@ protected:
   std::vector<cmCTestTestHandler::cmCTestTestResult>* TestResults;
   size_t ParallelLevel; // max number of process that can be run at once
   std::set<cmCTestRunTest*> RunningTests;  // current running tests
+  cmCTestRunTest* LastStartedTest;
+  double WaitTime; // time to wait for output when no test made progress
   cmCTestTestHandler * TestHandler;
   cmCTest* CTest;
   bool HasCycles;
@@ -14,6 +14,7 @@
 #include "cmCTestMemCheckHandler.h"
 #include "cmCTest.h"
 #include "cmSystemTools.h"
+#include "cmCryptoHash.h"
 #include "cm_curl.h"
 
 #include <cm_zlib.h>
@@ -33,6 +34,7 @@ cmCTestRunTest::cmCTestRunTest(cmCTestTestHandler* handler)
   this->CompressedOutput = "";
   this->CompressionRatio = 2;
   this->StopTimePassed = false;
+  this->Unchanged = false;
 }
 
 cmCTestRunTest::~cmCTestRunTest()
@@ -40,13 +42,13 @@ cmCTestRunTest::~cmCTestRunTest()
 }
 
 //----------------------------------------------------------------------------
-bool cmCTestRunTest::CheckOutput()
+bool cmCTestRunTest::CheckOutput(double timeout)
 {
-  // Read lines for up to 0.1 seconds of total time.
-  double timeout = 0.1;
-  double timeEnd = cmSystemTools::GetTime() + timeout;
+  // Wait for output for up to the given time.  Once some arrived, read
+  // the lines already available for up to 0.1 seconds of total time.
+  double timeEnd = cmSystemTools::GetTime() + (timeout > 0.1? timeout : 0.1);
   std::string line;
-  while((timeout = timeEnd - cmSystemTools::GetTime(), timeout > 0))
+  for(;;)
     {
     int p = this->TestProcess->GetNextOutputLine(line, timeout);
     if(p == cmsysProcess_Pipe_None)
@@ -62,6 +64,11 @@ bool cmCTestRunTest::CheckOutput()
                  this->GetIndex() << ": " << line << std::endl);
       this->ProcessOutput += line;
       this->ProcessOutput += "\n";
+      if(cmSystemTools::GetTime() >= timeEnd)
+        {
+        break;
+        }
+      timeout = 0;
       }
     else // if(p == cmsysProcess_Pipe_Timeout)
       {
@@ -137,14 +144,6 @@ void cmCTestRunTest::CompressOutput()
 //---------------------------------------------------------
 bool cmCTestRunTest::EndTest(size_t completed, size_t total, bool started)
 {
-  if ((!this->TestHandler->MemCheck &&
-      this->CTest->ShouldCompressTestOutput()) ||
-      (this->TestHandler->MemCheck &&
-      this->CTest->ShouldCompressMemCheckOutput()))
-    {
-    this->CompressOutput();
-    }
-
   this->WriteLogOutputTop(completed, total);
   std::string reason;
   bool passed = true;
@@ -201,7 +200,12 @@ bool cmCTestRunTest::EndTest(size_t completed, size_t total, bool started)
         }
       }
     }
-  if (res == cmsysProcess_State_Exited)
+  if (this->Unchanged)
+    {
+    reason = "Inputs unchanged since the test last passed.";
+    cmCTestLog(this->CTest, HANDLER_OUTPUT, "   Passed  (unchanged) " );
+    }
+  else if (res == cmsysProcess_State_Exited)
     {
     bool success =
       !forceFail &&  (retVal == 0 ||
@@ -345,9 +349,15 @@ bool cmCTestRunTest::EndTest(size_t completed, size_t total, bool started)
   // record the results in TestResult
   if(started)
     {
+    // Compress the output only once it has been truncated so that the
+    // size limits apply to compressed output too.
     bool compress = !this->TestHandler->MemCheck &&
-      this->CompressionRatio < 1 &&
       this->CTest->ShouldCompressTestOutput();
+    if(compress)
+      {
+      this->CompressOutput();
+      compress = this->CompressionRatio < 1;
+      }
     this->TestResult.Output = compress ? this->CompressedOutput
       : this->ProcessOutput;
     this->TestResult.CompressOutput = compress;
@@ -356,10 +366,23 @@ bool cmCTestRunTest::EndTest(size_t completed, size_t total, bool started)
     this->TestResult.ExecutionTime = this->TestProcess->GetTotalTime();
     this->MemCheckPostProcess();
     this->ComputeWeightedCost();
+    if(!this->Fingerprint.empty())
+      {
+      std::map<std::string, std::string>& fingerprints =
+        this->TestHandler->PassedFingerprints;
+      if(this->TestResult.Status == cmCTestTestHandler::COMPLETED)
+        {
+        fingerprints[this->TestProperties->Name] = this->Fingerprint;
+        }
+      else
+        {
+        fingerprints.erase(this->TestProperties->Name);
+        }
+      }
     }
   // Always push the current TestResult onto the
   // TestHandler vector
-  this->TestHandler->TestResults.push_back(this->TestResult);
+  this->TestHandler->RecordTestResult(this->TestResult);
   delete this->TestProcess;
   return passed;
 }
@@ -369,12 +392,18 @@ void cmCTestRunTest::ComputeWeightedCost()
 {
   double prev = static_cast<double>(this->TestProperties->PreviousRuns);
   double avgcost = static_cast<double>(this->TestProperties->Cost);
+  double variance = static_cast<double>(this->TestProperties->CostVariance);
   double current = this->TestResult.ExecutionTime;
 
   if(this->TestResult.Status == cmCTestTestHandler::COMPLETED)
     {
-    this->TestProperties->Cost =
-      static_cast<float>(((prev * avgcost) + current) / (prev + 1.0));
+    // Update the running mean and variance of the execution time.
+    double newcost = ((prev * avgcost) + current) / (prev + 1.0);
+    double d0 = avgcost - newcost;
+    double d1 = current - newcost;
+    this->TestProperties->Cost = static_cast<float>(newcost);
+    this->TestProperties->CostVariance = static_cast<float>(
+      (prev * (variance + d0 * d0) + d1 * d1) / (prev + 1.0));
     this->TestProperties->PreviousRuns++;
     }
 }
@@ -481,6 +510,26 @@ bool cmCTestRunTest::StartTest(size_t total)
     }
   this->StartTime = this->CTest->CurrentTime();
 
+  // Reuse the result of a previous passing run if nothing changed.
+  if(this->TestHandler->SkipUnchanged)
+    {
+    this->Fingerprint = this->ComputeFingerprint();
+    std::map<std::string, std::string>::const_iterator f =
+      this->TestHandler->PassedFingerprints.find(this->TestProperties->Name);
+    if(f != this->TestHandler->PassedFingerprints.end() &&
+       f->second == this->Fingerprint)
+      {
+      this->TestProcess = new cmProcess;
+      this->TestResult.Output =
+        "Test not run because its inputs did not change since it passed.";
+      this->TestResult.CompletionStatus = "Unchanged";
+      this->TestResult.ReturnValue = 0;
+      this->TestResult.Status = cmCTestTestHandler::COMPLETED;
+      this->Unchanged = true;
+      return false;
+      }
+    }
+
   double timeout = this->ResolveTimeout();
 
   if(this->StopTimePassed)
@@ -491,6 +540,62 @@ bool cmCTestRunTest::StartTest(size_t total)
                            &this->TestProperties->Environment);
 }
 
+//----------------------------------------------------------------------
+std::string cmCTestRunTest::ComputeFingerprint()
+{
+  cmCTestTestHandler::cmCTestTestProperties* p = this->TestProperties;
+  std::ostringstream input;
+  input << "Command: " << this->TestResult.FullCommandLine << "\n"
+        << "Directory: " << p->Directory << "\n";
+
+  // Hash the executable and any file named by full path in the
+  // arguments, such as a script given to an interpreter.
+  std::vector<std::string> files = this->Arguments;
+  files.insert(files.begin(), this->ActualCommand);
+  for(std::vector<std::string>::const_iterator i = files.begin();
+      i != files.end(); ++i)
+    {
+    if(cmSystemTools::FileIsFullPath(i->c_str()) &&
+       cmSystemTools::FileExists(i->c_str(), true))
+      {
+      input << "File: " << *i << " "
+            << this->TestHandler->GetFileHash(*i) << "\n";
+      }
+    }
+  files = p->RequiredFiles;
+  files.insert(files.end(), p->InputFiles.begin(), p->InputFiles.end());
+  for(std::vector<std::string>::const_iterator i = files.begin();
+      i != files.end(); ++i)
+    {
+    std::string file = cmSystemTools::CollapseFullPath(*i);
+    input << "File: " << file << " "
+          << this->TestHandler->GetFileHash(file) << "\n";
+    }
+
+  // Properties that decide whether the test passes.
+  for(std::vector<std::string>::const_iterator i = p->Environment.begin();
+      i != p->Environment.end(); ++i)
+    {
+    input << "Environment: " << *i << "\n";
+    }
+  std::vector<std::pair<cmsys::RegularExpression,
+    std::string> >::const_iterator r;
+  for(r = p->RequiredRegularExpressions.begin();
+      r != p->RequiredRegularExpressions.end(); ++r)
+    {
+    input << "Pass: " << r->second << "\n";
+    }
+  for(r = p->ErrorRegularExpressions.begin();
+      r != p->ErrorRegularExpressions.end(); ++r)
+    {
+    input << "Fail: " << r->second << "\n";
+    }
+  input << "WillFail: " << p->WillFail << "\n"
+        << "SkipReturnCode: " << p->SkipReturnCode << "\n"
+        << "Timeout: " << p->Timeout << "\n";
+  return cmCryptoHash::New("SHA1")->HashString(input.str());
+}
+
 //----------------------------------------------------------------------
 void cmCTestRunTest::ComputeArguments()
 {
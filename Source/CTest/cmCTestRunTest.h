@@ -44,8 +44,9 @@ public:
   cmCTestTestHandler::cmCTestTestResult GetTestResults()
   { return this->TestResult; }
 
-  // Read and store output.  Returns true if it must be called again.
-  bool CheckOutput();
+  // Read and store output, waiting for up to the given time for it to
+  // arrive.  Returns true if it must be called again.
+  bool CheckOutput(double timeout);
 
   // Compresses the output, writing to CompressedOutput
   void CompressOutput();
@@ -68,6 +69,8 @@ private:
   void WriteLogOutputTop(size_t completed, size_t total);
   //Run post processing of the process output for MemCheck
   void MemCheckPostProcess();
+  // Hash the command and inputs of the test
+  std::string ComputeFingerprint();
 
   cmCTestTestHandler::cmCTestTestProperties * TestProperties;
   //Pointer back to the "parent"; the handler that invoked this test run
@@ -92,6 +95,9 @@ private:
   std::string ActualCommand;
   std::vector<std::string> Arguments;
   bool StopTimePassed;
+  std::string Fingerprint;
+  // The test passed before with the same fingerprint and did not run
+  bool Unchanged;
 };
 
 inline int getNumWidth(size_t n)
@@ -71,6 +71,10 @@ cmCTestGenericHandler* cmCTestSubmitCommand::InitializeHandler()
     "DropSitePassword", "CTEST_DROP_SITE_PASSWORD", this->Quiet);
   this->CTest->SetCTestConfigurationFromCMakeVariable(this->Makefile,
     "ScpCommand", "CTEST_SCP_COMMAND", this->Quiet);
+  this->CTest->SetCTestConfigurationFromCMakeVariable(this->Makefile,
+    "SubmitParallelLevel", "CTEST_SUBMIT_PARALLEL_LEVEL", this->Quiet);
+  this->CTest->SetCTestConfigurationFromCMakeVariable(this->Makefile,
+    "SubmitCompression", "CTEST_SUBMIT_COMPRESSION", this->Quiet);
 
   const char* notesFilesVariable
     = this->Makefile->GetDefinition("CTEST_NOTES_FILES");
@@ -28,9 +28,14 @@
 // For curl submission
 #include "cmCurl.h"
 #include "cmCTestCurl.h"
+#include "cmAlgorithms.h"
+
+#include <cm_zlib.h>
 
 #include <sys/stat.h>
 
+#include <deque>
+
 #define SUBMIT_TIMEOUT_IN_SECONDS_DEFAULT 120
 
 typedef std::vector<char> cmCTestSubmitHandlerVectorOfChar;
@@ -326,6 +331,242 @@ bool cmCTestSubmitHandler::SubmitUsingFTP(const std::string& localprefix,
   return true;
 }
 
+//----------------------------------------------------------------------------
+// One file uploaded by SubmitUsingHTTP.
+class cmCTestSubmitHTTPUpload
+{
+public:
+  cmCTestSubmitHTTPUpload(): File(0), Offset(0), Size(0), Attempts(0),
+    StartTime(0) { this->ErrorBuffer[0] = 0; }
+  ~cmCTestSubmitHTTPUpload() { this->Close(); }
+
+  void Close()
+    {
+    if(this->File)
+      {
+      fclose(this->File);
+      this->File = 0;
+      }
+    }
+
+  std::string LocalFile;
+  std::string URL;
+  FILE* File;
+
+  // Compressed content sent in place of the file.
+  std::vector<char> Content;
+  size_t Offset;
+
+  unsigned long Size;
+  int Attempts;
+  double StartTime;
+  cmCTestSubmitHandlerVectorOfChar Chunk;
+  cmCTestSubmitHandlerVectorOfChar ChunkDebug;
+  char ErrorBuffer[CURL_ERROR_SIZE];
+};
+
+//----------------------------------------------------------------------------
+static size_t
+cmCTestSubmitHandlerReadMemoryCallback(void *ptr, size_t size, size_t nmemb,
+  void *data)
+{
+  cmCTestSubmitHTTPUpload* upload =
+    static_cast<cmCTestSubmitHTTPUpload*>(data);
+  size_t n = std::min(size * nmemb,
+                      upload->Content.size() - upload->Offset);
+  if(n > 0)
+    {
+    memcpy(ptr, &upload->Content[upload->Offset], n);
+    upload->Offset += n;
+    }
+  return n;
+}
+
+//----------------------------------------------------------------------------
+static bool cmCTestSubmitHandlerGZipFile(std::string const& file,
+                                         std::vector<char>& out)
+{
+  cmsys::ifstream fin(file.c_str(), std::ios::in | std::ios::binary);
+  if(!fin)
+    {
+    return false;
+    }
+
+  z_stream strm;
+  strm.zalloc = Z_NULL;
+  strm.zfree = Z_NULL;
+  strm.opaque = Z_NULL;
+  // Adding 16 to the window bits writes a gzip header and trailer.
+  if(deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                  Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+    return false;
+    }
+
+  char in[16384];
+  char buf[16384];
+  int flush;
+  int ret = Z_OK;
+  out.clear();
+  do
+    {
+    fin.read(in, sizeof(in));
+    strm.avail_in = static_cast<uInt>(fin.gcount());
+    strm.next_in = reinterpret_cast<Bytef*>(in);
+    flush = fin? Z_NO_FLUSH : Z_FINISH;
+    do
+      {
+      strm.avail_out = sizeof(buf);
+      strm.next_out = reinterpret_cast<Bytef*>(buf);
+      ret = deflate(&strm, flush);
+      out.insert(out.end(), buf, buf + sizeof(buf) - strm.avail_out);
+      }
+    while(strm.avail_out == 0);
+    }
+  while(flush != Z_FINISH);
+  (void)deflateEnd(&strm);
+  return ret == Z_STREAM_END;
+}
+
+//----------------------------------------------------------------------------
+CURL* cmCTestSubmitHandler::CreateHTTPUploadHandle(bool verifyPeerOff,
+                                                   bool verifyHostOff)
+{
+  /* get a curl handle */
+  CURL* curl = curl_easy_init();
+  if(!curl)
+    {
+    return 0;
+    }
+  cmCurlSetCAInfo(curl);
+  if(verifyPeerOff)
+    {
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+               "  Set CURLOPT_SSL_VERIFYPEER to off\n", this->Quiet);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0);
+    }
+  if(verifyHostOff)
+    {
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+               "  Set CURLOPT_SSL_VERIFYHOST to off\n", this->Quiet);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0);
+    }
+
+  // Using proxy
+  if ( this->HTTPProxyType > 0 )
+    {
+    curl_easy_setopt(curl, CURLOPT_PROXY, this->HTTPProxy.c_str());
+    switch (this->HTTPProxyType)
+      {
+    case 2:
+      curl_easy_setopt(curl, CURLOPT_PROXYTYPE, CURLPROXY_SOCKS4);
+      break;
+    case 3:
+      curl_easy_setopt(curl, CURLOPT_PROXYTYPE, CURLPROXY_SOCKS5);
+      break;
+    default:
+      curl_easy_setopt(curl, CURLOPT_PROXYTYPE, CURLPROXY_HTTP);
+      if (!this->HTTPProxyAuth.empty())
+        {
+        curl_easy_setopt(curl, CURLOPT_PROXYUSERPWD,
+          this->HTTPProxyAuth.c_str());
+        }
+      }
+    }
+  if(this->CTest->ShouldUseHTTP10())
+    {
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_0);
+    }
+  // enable HTTP ERROR parsing
+  curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1);
+  /* enable uploading */
+  curl_easy_setopt(curl, CURLOPT_UPLOAD, 1);
+
+  // if there is little to no activity for too long stop submitting
+  ::curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1);
+  ::curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME,
+    SUBMIT_TIMEOUT_IN_SECONDS_DEFAULT);
+
+  /* HTTP PUT please */
+  ::curl_easy_setopt(curl, CURLOPT_PUT, 1);
+  ::curl_easy_setopt(curl, CURLOPT_VERBOSE, 1);
+
+  // specify handler for output
+  ::curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION,
+    cmCTestSubmitHandlerWriteMemoryCallback);
+  ::curl_easy_setopt(curl, CURLOPT_DEBUGFUNCTION,
+    cmCTestSubmitHandlerCurlDebugCallback);
+  return curl;
+}
+
+//----------------------------------------------------------------------------
+bool cmCTestSubmitHandler::StartHTTPUpload(cmCTestSubmitHTTPUpload& upload,
+                                           CURL* curl,
+                                           struct curl_slist* headers)
+{
+  upload.Chunk.clear();
+  upload.ChunkDebug.clear();
+  upload.ErrorBuffer[0] = 0;
+
+  curl_off_t size;
+  if(headers)
+    {
+    // The file is compressed once and the same content is sent again
+    // on a retry.
+    if(upload.Content.empty() &&
+       !cmCTestSubmitHandlerGZipFile(upload.LocalFile, upload.Content))
+      {
+      cmCTestLog(this->CTest, ERROR_MESSAGE, "   Cannot compress file: "
+        << upload.LocalFile << std::endl);
+      return false;
+      }
+    upload.Offset = 0;
+    ::curl_easy_setopt(curl, CURLOPT_READFUNCTION,
+      cmCTestSubmitHandlerReadMemoryCallback);
+    ::curl_easy_setopt(curl, CURLOPT_READDATA, (void *)&upload);
+    size = static_cast<curl_off_t>(upload.Content.size());
+    }
+  else
+    {
+    upload.File = cmsys::SystemTools::Fopen(upload.LocalFile, "rb");
+    if(!upload.File)
+      {
+      cmCTestLog(this->CTest, ERROR_MESSAGE, "   Cannot open file: "
+        << upload.LocalFile << std::endl);
+      return false;
+      }
+    ::curl_easy_setopt(curl, CURLOPT_READFUNCTION, (void *)0);
+    // now specify which file to upload
+    ::curl_easy_setopt(curl, CURLOPT_INFILE, upload.File);
+    size = static_cast<curl_off_t>(upload.Size);
+    }
+  ::curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+  if(upload.Attempts == 0)
+    {
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+      "   Upload file: " << upload.LocalFile << " to "
+      << upload.URL << " Size: " << upload.Size
+      << (headers ? " Compressed: " : "")
+      << (headers ? upload.Content.size() : 0) << std::endl, this->Quiet);
+    }
+
+  // specify target
+  ::curl_easy_setopt(curl, CURLOPT_URL, upload.URL.c_str());
+
+  // and give the size of the upload
+  ::curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, size);
+
+  // and give curl the buffer for errors
+  ::curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, upload.ErrorBuffer);
+
+  /* we pass our 'chunk' struct to the callback function */
+  ::curl_easy_setopt(curl, CURLOPT_FILE, (void *)&upload.Chunk);
+  ::curl_easy_setopt(curl, CURLOPT_DEBUGDATA, (void *)&upload.ChunkDebug);
+  ::curl_easy_setopt(curl, CURLOPT_PRIVATE, (void *)&upload);
+  return true;
+}
+
 //----------------------------------------------------------------------------
 // Uploading files is simpler
 bool cmCTestSubmitHandler::SubmitUsingHTTP(const std::string& localprefix,
@@ -333,14 +574,8 @@ bool cmCTestSubmitHandler::SubmitUsingHTTP(const std::string& localprefix,
   const std::string& remoteprefix,
   const std::string& url)
 {
-  CURL *curl;
-  CURLcode res;
-  FILE* ftpfile;
-  char error_buffer[1024];
-
   /* In windows, this will init the winsock stuff */
   ::curl_global_init(CURL_GLOBAL_ALL);
-  std::string dropMethod(this->CTest->GetCTestConfiguration("DropMethod"));
   std::string curlopt(this->CTest->GetCTestConfiguration("CurlOptions"));
   std::vector<std::string> args;
   cmSystemTools::ExpandListArgument(curlopt, args);
@@ -358,163 +593,177 @@ bool cmCTestSubmitHandler::SubmitUsingHTTP(const std::string& localprefix,
       verifyHostOff = true;
       }
     }
+
+  std::string retryDelay = this->GetOption("RetryDelay") == NULL ?
+    "" : this->GetOption("RetryDelay");
+  std::string retryCount = this->GetOption("RetryCount") == NULL ?
+    "" : this->GetOption("RetryCount");
+  int delay = retryDelay == "" ? atoi(this->CTest->GetCTestConfiguration(
+    "CTestSubmitRetryDelay").c_str()) : atoi(retryDelay.c_str());
+  int count = retryCount == "" ? atoi(this->CTest->GetCTestConfiguration(
+    "CTestSubmitRetryCount").c_str()) : atoi(retryCount.c_str());
+
+  // Several files may be uploaded at once.  Handles are reused for the
+  // next file so their connections to the server are kept open.
+  int parallelLevel = atoi(this->CTest->GetCTestConfiguration(
+    "SubmitParallelLevel").c_str());
+  if(parallelLevel < 1)
+    {
+    parallelLevel = 1;
+    }
+  struct curl_slist* headers = 0;
+  if(cmSystemTools::IsOn(this->CTest->GetCTestConfiguration(
+       "SubmitCompression").c_str()))
+    {
+    headers = ::curl_slist_append(headers, "Content-Encoding: gzip");
+    }
+
   std::string::size_type kk;
+  std::vector<cmCTestSubmitHTTPUpload*> uploads;
+  std::deque<cmCTestSubmitHTTPUpload*> pending;
   cmCTest::SetOfStrings::const_iterator file;
   for ( file = files.begin(); file != files.end(); ++file )
     {
-    /* get a curl handle */
-    curl = curl_easy_init();
-    if(curl)
+    std::string local_file = *file;
+    if ( !cmSystemTools::FileExists(local_file.c_str()) )
       {
-      cmCurlSetCAInfo(curl);
-      if(verifyPeerOff)
-        {
-        cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
-                   "  Set CURLOPT_SSL_VERIFYPEER to off\n", this->Quiet);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0);
-        }
-      if(verifyHostOff)
-        {
-        cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
-                   "  Set CURLOPT_SSL_VERIFYHOST to off\n", this->Quiet);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0);
-        }
+      local_file = localprefix + "/" + *file;
+      }
+    std::string remote_file
+      = remoteprefix + cmSystemTools::GetFilenameName(*file);
 
-      // Using proxy
-      if ( this->HTTPProxyType > 0 )
-        {
-        curl_easy_setopt(curl, CURLOPT_PROXY, this->HTTPProxy.c_str());
-        switch (this->HTTPProxyType)
-          {
-        case 2:
-          curl_easy_setopt(curl, CURLOPT_PROXYTYPE, CURLPROXY_SOCKS4);
-          break;
-        case 3:
-          curl_easy_setopt(curl, CURLOPT_PROXYTYPE, CURLPROXY_SOCKS5);
-          break;
-        default:
-          curl_easy_setopt(curl, CURLOPT_PROXYTYPE, CURLPROXY_HTTP);
-          if (!this->HTTPProxyAuth.empty())
-            {
-            curl_easy_setopt(curl, CURLOPT_PROXYUSERPWD,
-              this->HTTPProxyAuth.c_str());
-            }
-          }
-        }
-      if(this->CTest->ShouldUseHTTP10())
+    *this->LogFile << "\tUpload file: " << local_file << " to "
+        << remote_file << std::endl;
+
+    std::string ofile = "";
+    for ( kk = 0; kk < remote_file.size(); kk ++ )
+      {
+      char c = remote_file[kk];
+      char hexCh[4] = { 0, 0, 0, 0 };
+      hexCh[0] = c;
+      switch ( c )
         {
-        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_0);
+      case '+':
+      case '?':
+      case '/':
+      case '\\':
+      case '&':
+      case ' ':
+      case '=':
+      case '%':
+        sprintf(hexCh, "%%%02X", (int)c);
+        ofile.append(hexCh);
+        break;
+      default:
+        ofile.append(hexCh);
         }
-      // enable HTTP ERROR parsing
-      curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1);
-      /* enable uploading */
-      curl_easy_setopt(curl, CURLOPT_UPLOAD, 1);
+      }
+    std::string upload_as
+      = url + ((url.find("?",0) == std::string::npos) ? "?" : "&")
+      + "FileName=" + ofile;
 
-      // if there is little to no activity for too long stop submitting
-      ::curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1);
-      ::curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME,
-        SUBMIT_TIMEOUT_IN_SECONDS_DEFAULT);
+    upload_as += "&MD5=";
 
-      /* HTTP PUT please */
-      ::curl_easy_setopt(curl, CURLOPT_PUT, 1);
-      ::curl_easy_setopt(curl, CURLOPT_VERBOSE, 1);
+    if( !cmSystemTools::FileExists(local_file.c_str()) )
+      {
+      cmCTestLog(this->CTest, ERROR_MESSAGE, "   Cannot find file: "
+        << local_file << std::endl);
+      cmDeleteAll(uploads);
+      ::curl_slist_free_all(headers);
+      ::curl_global_cleanup();
+      return false;
+      }
 
-      std::string local_file = *file;
-      if ( !cmSystemTools::FileExists(local_file.c_str()) )
-        {
-        local_file = localprefix + "/" + *file;
-        }
-      std::string remote_file
-        = remoteprefix + cmSystemTools::GetFilenameName(*file);
+    if(cmSystemTools::IsOn(this->GetOption("InternalTest")))
+      {
+      upload_as += "bad_md5sum";
+      }
+    else
+      {
+      char md5[33];
+      cmSystemTools::ComputeFileMD5(local_file, md5);
+      md5[32] = 0;
+      upload_as += md5;
+      }
 
-      *this->LogFile << "\tUpload file: " << local_file << " to "
-          << remote_file << std::endl;
+    cmCTestSubmitHTTPUpload* upload = new cmCTestSubmitHTTPUpload;
+    upload->LocalFile = local_file;
+    upload->URL = upload_as;
+    upload->Size = cmSystemTools::FileLength(local_file);
+    uploads.push_back(upload);
+    pending.push_back(upload);
+    }
 
-      std::string ofile = "";
-      for ( kk = 0; kk < remote_file.size(); kk ++ )
+  CURLM* multi = ::curl_multi_init();
+  std::vector<CURL*> handles;
+  std::vector<CURL*> idle;
+  int active = 0;
+  bool serverErrors = this->HasErrors;
+  bool result = multi != 0;
+  while(result && (active > 0 || !pending.empty()))
+    {
+    // Start the next uploads.  A failed upload waits for the retry
+    // delay at the end of the queue while the other files go on.
+    double now = cmSystemTools::GetTime();
+    while(result && active < parallelLevel && !pending.empty() &&
+          pending.front()->StartTime <= now)
+      {
+      cmCTestSubmitHTTPUpload* upload = pending.front();
+      pending.pop_front();
+      if(upload->Attempts > 0)
         {
-        char c = remote_file[kk];
-        char hexCh[4] = { 0, 0, 0, 0 };
-        hexCh[0] = c;
-        switch ( c )
-          {
-        case '+':
-        case '?':
-        case '/':
-        case '\\':
-        case '&':
-        case ' ':
-        case '=':
-        case '%':
-          sprintf(hexCh, "%%%02X", (int)c);
-          ofile.append(hexCh);
-          break;
-        default:
-          ofile.append(hexCh);
-          }
+        cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT,
+          "   Retry submission of " << upload->LocalFile << ": Attempt "
+          << upload->Attempts << " of " << count << std::endl, this->Quiet);
         }
-      std::string upload_as
-        = url + ((url.find("?",0) == std::string::npos) ? "?" : "&")
-        + "FileName=" + ofile;
-
-      upload_as += "&MD5=";
-
-      if(cmSystemTools::IsOn(this->GetOption("InternalTest")))
+      CURL* curl = 0;
+      if(!idle.empty())
         {
-        upload_as += "bad_md5sum";
+        curl = idle.back();
+        idle.pop_back();
         }
-      else
+      else if((curl = this->CreateHTTPUploadHandle(verifyPeerOff,
+                                                   verifyHostOff)) != 0)
         {
-        char md5[33];
-        cmSystemTools::ComputeFileMD5(local_file, md5);
-        md5[32] = 0;
-        upload_as += md5;
+        handles.push_back(curl);
         }
-
-      if( !cmSystemTools::FileExists(local_file.c_str()) )
+      if(!curl || !this->StartHTTPUpload(*upload, curl, headers))
         {
-        cmCTestLog(this->CTest, ERROR_MESSAGE, "   Cannot find file: "
-          << local_file << std::endl);
-        ::curl_easy_cleanup(curl);
-        ::curl_global_cleanup();
-        return false;
+        result = false;
+        break;
         }
-      unsigned long filelen = cmSystemTools::FileLength(local_file);
-
-      ftpfile = cmsys::SystemTools::Fopen(local_file, "rb");
-      cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
-        "   Upload file: " << local_file << " to "
-        << upload_as << " Size: " << filelen << std::endl, this->Quiet);
-
-      // specify target
-      ::curl_easy_setopt(curl,CURLOPT_URL, upload_as.c_str());
-
-      // now specify which file to upload
-      ::curl_easy_setopt(curl, CURLOPT_INFILE, ftpfile);
-
-      // and give the size of the upload (optional)
-      ::curl_easy_setopt(curl, CURLOPT_INFILESIZE,
-        static_cast<long>(filelen));
-
-      // and give curl the buffer for errors
-      ::curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, &error_buffer);
-
-      // specify handler for output
-      ::curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION,
-        cmCTestSubmitHandlerWriteMemoryCallback);
-      ::curl_easy_setopt(curl, CURLOPT_DEBUGFUNCTION,
-        cmCTestSubmitHandlerCurlDebugCallback);
-
-      /* we pass our 'chunk' struct to the callback function */
-      cmCTestSubmitHandlerVectorOfChar chunk;
-      cmCTestSubmitHandlerVectorOfChar chunkDebug;
-      ::curl_easy_setopt(curl, CURLOPT_FILE, (void *)&chunk);
-      ::curl_easy_setopt(curl, CURLOPT_DEBUGDATA, (void *)&chunkDebug);
+      ::curl_multi_add_handle(multi, curl);
+      ++active;
+      }
 
-      // Now run off and do what you've been told!
-      res = ::curl_easy_perform(curl);
+    // Now run off and do what you've been told!
+    int running;
+    while(::curl_multi_perform(multi, &running) == CURLM_CALL_MULTI_PERFORM)
+      {
+      }
 
-      if(cmSystemTools::IsOn(this->GetOption("InternalTest")) &&
+    CURLMsg* msg;
+    int left;
+    while(result && (msg = ::curl_multi_info_read(multi, &left)) != 0)
+      {
+      if(msg->msg != CURLMSG_DONE)
+        {
+        continue;
+        }
+      CURL* curl = msg->easy_handle;
+      CURLcode res = msg->data.result;
+      char* data = 0;
+      ::curl_easy_getinfo(curl, CURLINFO_PRIVATE, &data);
+      cmCTestSubmitHTTPUpload* upload =
+        reinterpret_cast<cmCTestSubmitHTTPUpload*>(data);
+      ::curl_multi_remove_handle(multi, curl);
+      idle.push_back(curl);
+      --active;
+      upload->Close();
+      ++upload->Attempts;
+
+      if(upload->Attempts == 1 &&
+         cmSystemTools::IsOn(this->GetOption("InternalTest")) &&
          cmSystemTools::VersionCompare(cmSystemTools::OP_LESS,
          this->CTest->GetCDashVersion().c_str(), "1.7"))
         {
@@ -523,10 +772,13 @@ bool cmCTestSubmitHandler::SubmitUsingHTTP(const std::string& localprefix,
           "  <status>ERROR</status>\n"
           "  <message>Checksum failed for file.</message>\n"
           "</cdash>\n";
-        chunk.clear();
-        chunk.assign(mock_output.begin(), mock_output.end());
+        upload->Chunk.clear();
+        upload->Chunk.assign(mock_output.begin(), mock_output.end());
         }
 
+      std::vector<char> const& chunk = upload->Chunk;
+      std::vector<char> const& chunkDebug = upload->ChunkDebug;
+      this->HasErrors = false;
       if (!chunk.empty())
         {
         cmCTestOptionalLog(this->CTest, DEBUG, "CURL output: ["
@@ -542,72 +794,28 @@ bool cmCTestSubmitHandler::SubmitUsingHTTP(const std::string& localprefix,
         }
 
       // If curl failed for any reason, or checksum fails, wait and retry
-      //
-      if(res != CURLE_OK || this->HasErrors)
+      // only this file.
+      if((res != CURLE_OK || this->HasErrors) && upload->Attempts <= count)
         {
-        std::string retryDelay = this->GetOption("RetryDelay") == NULL ?
-          "" : this->GetOption("RetryDelay");
-        std::string retryCount = this->GetOption("RetryCount") == NULL ?
-          "" : this->GetOption("RetryCount");
-
-        int delay = retryDelay == "" ? atoi(this->CTest->GetCTestConfiguration(
-          "CTestSubmitRetryDelay").c_str()) : atoi(retryDelay.c_str());
-        int count = retryCount == "" ? atoi(this->CTest->GetCTestConfiguration(
-          "CTestSubmitRetryCount").c_str()) : atoi(retryCount.c_str());
-
-        for(int i = 0; i < count; i++)
-          {
-          cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT,
-            "   Submit failed, waiting " << delay << " seconds...\n",
-            this->Quiet);
-
-          double stop = cmSystemTools::GetTime() + delay;
-          while(cmSystemTools::GetTime() < stop)
-            {
-            cmSystemTools::Delay(100);
-            }
-
-          cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT,
-            "   Retry submission: Attempt " << (i + 1) << " of "
-            << count << std::endl, this->Quiet);
-
-          ::fclose(ftpfile);
-          ftpfile = cmsys::SystemTools::Fopen(local_file, "rb");
-          ::curl_easy_setopt(curl, CURLOPT_INFILE, ftpfile);
-
-          chunk.clear();
-          chunkDebug.clear();
-          this->HasErrors = false;
-
-          res = ::curl_easy_perform(curl);
-
-          if (!chunk.empty())
-            {
-            cmCTestOptionalLog(this->CTest, DEBUG, "CURL output: ["
-              << cmCTestLogWrite(&*chunk.begin(), chunk.size()) << "]"
-              << std::endl, this->Quiet);
-            this->ParseResponse(chunk);
-            }
-
-          if(res == CURLE_OK && !this->HasErrors)
-            {
-            break;
-            }
-          }
+        cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT,
+          "   Submit failed, waiting " << delay << " seconds...\n",
+          this->Quiet);
+        upload->StartTime = cmSystemTools::GetTime() + delay;
+        pending.push_back(upload);
+        continue;
         }
 
-      fclose(ftpfile);
       if ( res )
         {
         cmCTestLog(this->CTest, ERROR_MESSAGE,
           "   Error when uploading file: "
-          << local_file << std::endl);
+          << upload->LocalFile << std::endl);
         cmCTestLog(this->CTest, ERROR_MESSAGE, "   Error message was: "
-          << error_buffer << std::endl);
+          << upload->ErrorBuffer << std::endl);
         *this->LogFile << "   Error when uploading file: "
-                       << local_file
+                       << upload->LocalFile
                        << std::endl
-                       << "   Error message was: " << error_buffer
+                       << "   Error message was: " << upload->ErrorBuffer
                        << std::endl;
         // avoid deref of begin for zero size array
         if(!chunk.empty())
@@ -619,18 +827,68 @@ bool cmCTestSubmitHandler::SubmitUsingHTTP(const std::string& localprefix,
                      << cmCTestLogWrite(&*chunk.begin(), chunk.size()) << "]"
                      << std::endl);
           }
-        ::curl_easy_cleanup(curl);
-        ::curl_global_cleanup();
-        return false;
+        result = false;
+        break;
         }
-      // always cleanup
-      ::curl_easy_cleanup(curl);
+      serverErrors = serverErrors || this->HasErrors;
       cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT,
-        "   Uploaded: " + local_file << std::endl, this->Quiet);
+        "   Uploaded: " + upload->LocalFile << std::endl, this->Quiet);
+      }
+
+    if(!result)
+      {
+      break;
       }
+    if(active > 0)
+      {
+#if LIBCURL_VERSION_NUM >= 0x071C00
+      int numfds;
+      ::curl_multi_wait(multi, 0, 0, 100, &numfds);
+#else
+      // curl_multi_wait needs curl 7.28 so wait on the sockets directly.
+      fd_set readSet;
+      fd_set writeSet;
+      fd_set errorSet;
+      FD_ZERO(&readSet);
+      FD_ZERO(&writeSet);
+      FD_ZERO(&errorSet);
+      int maxfd = -1;
+      ::curl_multi_fdset(multi, &readSet, &writeSet, &errorSet, &maxfd);
+      if(maxfd >= 0)
+        {
+        struct timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = 100000;
+        ::select(maxfd + 1, &readSet, &writeSet, &errorSet, &timeout);
+        }
+      else
+        {
+        cmSystemTools::Delay(100);
+        }
+#endif
+      }
+    else if(!pending.empty())
+      {
+      cmSystemTools::Delay(100);
+      }
+    }
+  this->HasErrors = serverErrors;
+
+  // always cleanup
+  for(std::vector<CURL*>::iterator h = handles.begin();
+      h != handles.end(); ++h)
+    {
+    ::curl_multi_remove_handle(multi, *h);
+    ::curl_easy_cleanup(*h);
+    }
+  if(multi)
+    {
+    ::curl_multi_cleanup(multi);
     }
+  cmDeleteAll(uploads);
+  ::curl_slist_free_all(headers);
   ::curl_global_cleanup();
-  return true;
+  return result;
 }
 
 //----------------------------------------------------------------------------
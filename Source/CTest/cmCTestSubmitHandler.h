@@ -14,6 +14,10 @@
 
 #include "cmCTestGenericHandler.h"
 
+#include "cm_curl.h"
+
+class cmCTestSubmitHTTPUpload;
+
 /** \class cmCTestSubmitHandler
  * \brief Helper class for CTest
  *
@@ -60,6 +64,9 @@ private:
                        const std::set<std::string>& files,
                        const std::string& remoteprefix,
                        const std::string& url);
+  CURL* CreateHTTPUploadHandle(bool verifyPeerOff, bool verifyHostOff);
+  bool StartHTTPUpload(cmCTestSubmitHTTPUpload& upload, CURL* curl,
+                       struct curl_slist* headers);
   bool SubmitUsingSCP(const std::string& scp_command,
                       const std::string& localprefix,
                       const std::set<std::string>& files,
@@ -17,6 +17,9 @@
 #include "cmCTestRunTest.h"
 #include "cmake.h"
 #include "cmGeneratedFileStream.h"
+#include "cmCryptoHash.h"
+#include "cmFileLock.h"
+#include "cmFileLockResult.h"
 #include <cmsys/Process.h>
 #include <cmsys/RegularExpression.hxx>
 #include <cmsys/Base64.h>
@@ -395,6 +398,11 @@ cmCTestTestHandler::cmCTestTestHandler()
   this->MemCheck = false;
 
   this->LogFile = 0;
+  this->ResultsStream = 0;
+  this->ResultsStreamLost = false;
+  this->SkipUnchanged = false;
+  this->ShardIndex = 1;
+  this->ShardCount = 1;
 
   // regex to detect <DartMeasurement>...</DartMeasurement>
   this->DartStuff.compile(
@@ -412,6 +420,8 @@ void cmCTestTestHandler::Initialize()
   this->ElapsedTestingTime = -1;
 
   this->TestResults.clear();
+  this->ResultsStreamFile = "";
+  this->ResultsStreamLost = false;
 
   this->CustomTestsIgnore.clear();
   this->StartTest = "";
@@ -524,6 +534,24 @@ int cmCTestTestHandler::ProcessHandler()
     this->SetExcludeRegExp(val);
     }
   this->SetRerunFailed(cmSystemTools::IsOn(this->GetOption("RerunFailed")));
+  this->SetSkipUnchanged(!this->MemCheck &&
+    cmSystemTools::IsOn(this->GetOption("SkipUnchanged")));
+  this->ShardIndex = 1;
+  this->ShardCount = 1;
+  val = this->GetOption("Shard");
+  if ( val )
+    {
+    char extra;
+    if(sscanf(val, "%d/%d%c", &this->ShardIndex, &this->ShardCount,
+              &extra) != 2 ||
+       this->ShardIndex < 1 || this->ShardIndex > this->ShardCount)
+      {
+      cmCTestLog(this->CTest, ERROR_MESSAGE, "Invalid test shard \""
+        << val << "\".  Expected <index>/<count> with an index from 1 "
+        "to count." << std::endl);
+      return -1;
+      }
+    }
 
   this->TestResults.clear();
 
@@ -598,10 +626,23 @@ int cmCTestTestHandler::ProcessHandler()
 
     if (!failed.empty())
       {
+      // Shards sharing a build tree keep the failures of each other.
+      cmFileLock lock;
+      std::vector<std::string> otherShardsFailed;
+      if(this->ShardCount > 1)
+        {
+        this->ReadOtherShardsFailed(lock, otherShardsFailed);
+        }
+
       cmGeneratedFileStream ofs;
       cmCTestLog(this->CTest, HANDLER_OUTPUT, std::endl
                  << "The following tests FAILED:" << std::endl);
       this->StartLogFile("TestsFailed", ofs);
+      for(std::vector<std::string>::const_iterator l =
+            otherShardsFailed.begin(); l != otherShardsFailed.end(); ++l)
+        {
+        ofs << *l << std::endl;
+        }
 
       typedef std::set<cmCTestTestHandler::cmCTestTestResult,
                        cmCTestTestResultLess> SetOfTests;
@@ -638,6 +679,11 @@ int cmCTestTestHandler::ProcessHandler()
       return 1;
       }
     this->GenerateDartOutput(xmlfile);
+    if(this->ResultsStreamLost)
+      {
+      this->LogFile = 0;
+      return -1;
+      }
     }
 
   if ( ! this->PostProcessHandler() )
@@ -1063,6 +1109,7 @@ void cmCTestTestHandler::ProcessDirectory(std::vector<std::string> &passed,
     new cmCTestBatchTestHandler : new cmCTestMultiProcessHandler;
   parallel->SetCTest(this->CTest);
   parallel->SetParallelLevel(this->CTest->GetParallelLevel());
+  parallel->SetShard(this->ShardIndex, this->ShardCount);
   parallel->SetTestHandler(this);
   parallel->SetQuiet(this->Quiet);
 
@@ -1130,7 +1177,72 @@ void cmCTestTestHandler::ProcessDirectory(std::vector<std::string> &passed,
     }
   else
     {
+    // Write each result as soon as its test finishes so that test
+    // outputs are not held in memory until the XML is generated.  The
+    // file is written in place so that the results of finished tests
+    // survive if ctest dies.  Its name is unique to this process
+    // because several ctest runs may share a build tree, for example
+    // the shards of one test suite.
+    cmsys::ofstream results;
+    this->ResultsStreamFile = "";
+    if(this->CTest->GetProduceXML() && !this->MemCheck)
+      {
+      std::ostringstream name;
+      name << this->CTest->GetBinaryDir() << "/Testing/Temporary";
+      cmSystemTools::MakeDirectory(name.str().c_str());
+      name << "/LastTestResults";
+      if(this->SubmitIndex > 0)
+        {
+        name << "_" << this->SubmitIndex;
+        }
+      if(!this->CTest->GetCurrentTag().empty())
+        {
+        name << "_" << this->CTest->GetCurrentTag();
+        }
+      name << "_" << cmSystemTools::RandomSeed() << ".xml";
+      results.open(name.str().c_str(), std::ios::out | std::ios::binary);
+      if(results)
+        {
+        this->ResultsStream = &results;
+        this->ResultsStreamFile = name.str();
+        }
+      else
+        {
+        cmCTestLog(this->CTest, ERROR_MESSAGE,
+          "Cannot create test results file: " << name.str() << std::endl);
+        }
+      }
+    if(this->SkipUnchanged)
+      {
+      this->ReadResultCache();
+      }
     parallel->RunTests();
+    if(this->ResultsStream)
+      {
+      results.close();
+      this->ResultsStream = 0;
+      }
+    if(this->SkipUnchanged)
+      {
+      std::map<std::string, std::string> fingerprints;
+      for(TestResultsVector::const_iterator r = this->TestResults.begin();
+          r != this->TestResults.end(); ++r)
+        {
+        std::map<std::string, std::string>::const_iterator f =
+          this->PassedFingerprints.find(r->Name);
+        if(f != this->PassedFingerprints.end())
+          {
+          fingerprints.insert(*f);
+          }
+        }
+      this->UpdateResultCache(fingerprints, failed);
+      }
+    else if(!failed.empty() &&
+            cmSystemTools::FileExists(this->GetResultCacheFile().c_str()))
+      {
+      // A test that fails in any run must not be skipped later.
+      this->UpdateResultCache(std::map<std::string, std::string>(), failed);
+      }
     }
   delete parallel;
   this->EndTest = this->CTest->CurrentTime();
@@ -1168,81 +1280,43 @@ void cmCTestTestHandler::GenerateDartOutput(std::ostream& os)
       << "</Test>" << std::endl;
     }
   os << "\t</TestList>\n";
-  for ( cc = 0; cc < this->TestResults.size(); cc ++ )
+  if(!this->ResultsStreamFile.empty())
     {
-    cmCTestTestResult *result = &this->TestResults[cc];
-    this->WriteTestResultHeader(os, result);
-    os << "\t\t<Results>" << std::endl;
-    if ( result->Status != cmCTestTestHandler::NOT_RUN )
+    // The test elements were written while the tests ran.
+    cmsys::ifstream fin(this->ResultsStreamFile.c_str(),
+                        std::ios::in | std::ios::binary);
+    if(!fin)
       {
-      if ( result->Status != cmCTestTestHandler::COMPLETED ||
-        result->ReturnValue )
-        {
-        os << "\t\t\t<NamedMeasurement type=\"text/string\" "
-          "name=\"Exit Code\"><Value>"
-          << cmXMLSafe(this->GetTestStatus(result->Status))
-          << "</Value>"
-          "</NamedMeasurement>\n"
-          << "\t\t\t<NamedMeasurement type=\"text/string\" "
-          "name=\"Exit Value\"><Value>"
-          << result->ReturnValue
-          << "</Value></NamedMeasurement>"
-          << std::endl;
-        }
-      os << result->RegressionImages;
-      os << "\t\t\t<NamedMeasurement type=\"numeric/double\" "
-        << "name=\"Execution Time\"><Value>"
-        << result->ExecutionTime
-        << "</Value></NamedMeasurement>\n";
-      if(!result->Reason.empty())
-        {
-        const char* reasonType = "Pass Reason";
-        if(result->Status != cmCTestTestHandler::COMPLETED &&
-           result->Status != cmCTestTestHandler::NOT_RUN)
-          {
-          reasonType = "Fail Reason";
-          }
-        os << "\t\t\t<NamedMeasurement type=\"text/string\" "
-           << "name=\"" << reasonType << "\"><Value>"
-           << cmXMLSafe(result->Reason)
-           << "</Value></NamedMeasurement>\n";
-        }
-      os
-        << "\t\t\t<NamedMeasurement type=\"text/string\" "
-        << "name=\"Completion Status\"><Value>"
-        << cmXMLSafe(result->CompletionStatus)
-        << "</Value></NamedMeasurement>\n";
+      cmCTestLog(this->CTest, ERROR_MESSAGE,
+        "Cannot read test results file: " << this->ResultsStreamFile
+        << std::endl);
+      this->ResultsStreamLost = true;
       }
-    os
-      << "\t\t\t<NamedMeasurement type=\"text/string\" "
-      << "name=\"Command Line\"><Value>"
-      << cmXMLSafe(result->FullCommandLine)
-      << "</Value></NamedMeasurement>\n";
-    std::map<std::string,std::string>::iterator measureIt;
-    for ( measureIt = result->Properties->Measurements.begin();
-      measureIt != result->Properties->Measurements.end();
-      ++ measureIt )
+    char buffer[4096];
+    while(fin)
       {
-      os
-        << "\t\t\t<NamedMeasurement type=\"text/string\" "
-        << "name=\"" << measureIt->first << "\"><Value>"
-        << cmXMLSafe(measureIt->second)
-        << "</Value></NamedMeasurement>\n";
+      fin.read(buffer, sizeof(buffer));
+      os.write(buffer, fin.gcount());
+      }
+    if(fin.bad())
+      {
+      cmCTestLog(this->CTest, ERROR_MESSAGE,
+        "Cannot read test results file: " << this->ResultsStreamFile
+        << std::endl);
+      this->ResultsStreamLost = true;
+      }
+    fin.close();
+    if(!this->ResultsStreamLost)
+      {
+      cmSystemTools::RemoveFile(this->ResultsStreamFile);
+      }
+    }
+  if(this->ResultsStreamFile.empty() || this->ResultsStreamLost)
+    {
+    for ( cc = 0; cc < this->TestResults.size(); cc ++ )
+      {
+      this->WriteTestResult(os, &this->TestResults[cc]);
       }
-    os
-      << "\t\t\t<Measurement>\n"
-      << "\t\t\t\t<Value"
-      << (result->CompressOutput ?
-      " encoding=\"base64\" compression=\"gzip\">"
-      : ">");
-    os << cmXMLSafe(result->Output);
-    os
-      << "</Value>\n"
-      << "\t\t\t</Measurement>\n"
-      << "\t\t</Results>\n";
-
-    this->AttachFiles(os, result);
-    this->WriteTestResultFooter(os, result);
     }
 
   os << "\t<EndDateTime>" << this->EndTest << "</EndDateTime>\n"
@@ -1254,6 +1328,99 @@ void cmCTestTestHandler::GenerateDartOutput(std::ostream& os)
   this->CTest->EndXML(os);
 }
 
+//----------------------------------------------------------------------------
+void cmCTestTestHandler::WriteTestResult(std::ostream& os,
+                                         cmCTestTestResult* result)
+{
+  this->WriteTestResultHeader(os, result);
+  os << "\t\t<Results>" << std::endl;
+  if ( result->Status != cmCTestTestHandler::NOT_RUN )
+    {
+    if ( result->Status != cmCTestTestHandler::COMPLETED ||
+      result->ReturnValue )
+      {
+      os << "\t\t\t<NamedMeasurement type=\"text/string\" "
+        "name=\"Exit Code\"><Value>"
+        << cmXMLSafe(this->GetTestStatus(result->Status))
+        << "</Value>"
+        "</NamedMeasurement>\n"
+        << "\t\t\t<NamedMeasurement type=\"text/string\" "
+        "name=\"Exit Value\"><Value>"
+        << result->ReturnValue
+        << "</Value></NamedMeasurement>"
+        << std::endl;
+      }
+    os << result->RegressionImages;
+    os << "\t\t\t<NamedMeasurement type=\"numeric/double\" "
+      << "name=\"Execution Time\"><Value>"
+      << result->ExecutionTime
+      << "</Value></NamedMeasurement>\n";
+    if(!result->Reason.empty())
+      {
+      const char* reasonType = "Pass Reason";
+      if(result->Status != cmCTestTestHandler::COMPLETED &&
+         result->Status != cmCTestTestHandler::NOT_RUN)
+        {
+        reasonType = "Fail Reason";
+        }
+      os << "\t\t\t<NamedMeasurement type=\"text/string\" "
+         << "name=\"" << reasonType << "\"><Value>"
+         << cmXMLSafe(result->Reason)
+         << "</Value></NamedMeasurement>\n";
+      }
+    os
+      << "\t\t\t<NamedMeasurement type=\"text/string\" "
+      << "name=\"Completion Status\"><Value>"
+      << cmXMLSafe(result->CompletionStatus)
+      << "</Value></NamedMeasurement>\n";
+    }
+  os
+    << "\t\t\t<NamedMeasurement type=\"text/string\" "
+    << "name=\"Command Line\"><Value>"
+    << cmXMLSafe(result->FullCommandLine)
+    << "</Value></NamedMeasurement>\n";
+  std::map<std::string,std::string>::iterator measureIt;
+  for ( measureIt = result->Properties->Measurements.begin();
+    measureIt != result->Properties->Measurements.end();
+    ++ measureIt )
+    {
+    os
+      << "\t\t\t<NamedMeasurement type=\"text/string\" "
+      << "name=\"" << measureIt->first << "\"><Value>"
+      << cmXMLSafe(measureIt->second)
+      << "</Value></NamedMeasurement>\n";
+    }
+  os
+    << "\t\t\t<Measurement>\n"
+    << "\t\t\t\t<Value"
+    << (result->CompressOutput ?
+    " encoding=\"base64\" compression=\"gzip\">"
+    : ">");
+  os << cmXMLSafe(result->Output);
+  os
+    << "</Value>\n"
+    << "\t\t\t</Measurement>\n"
+    << "\t\t</Results>\n";
+
+  this->AttachFiles(os, result);
+  this->WriteTestResultFooter(os, result);
+}
+
+//----------------------------------------------------------------------------
+void cmCTestTestHandler::RecordTestResult(cmCTestTestResult const& result)
+{
+  this->TestResults.push_back(result);
+  if(this->ResultsStream)
+    {
+    // Only the summary information is needed after the XML is written.
+    cmCTestTestResult& stored = this->TestResults.back();
+    this->WriteTestResult(*this->ResultsStream, &stored);
+    this->ResultsStream->flush();
+    std::string().swap(stored.Output);
+    std::string().swap(stored.RegressionImages);
+    }
+}
+
 //----------------------------------------------------------------------------
 void cmCTestTestHandler::WriteTestResultHeader(std::ostream& os,
                                                cmCTestTestResult* result)
@@ -2107,6 +2274,128 @@ bool cmCTestTestHandler::CleanTestOutput(std::string& output, size_t length)
   return true;
 }
 
+//----------------------------------------------------------------------
+std::string cmCTestTestHandler::GetFileHash(std::string const& file)
+{
+  // Many tests share an executable so hash each file once per run.
+  std::map<std::string, std::string>::iterator i =
+    this->FileHashes.find(file);
+  if(i == this->FileHashes.end())
+    {
+    std::string hash = "missing";
+    if(cmSystemTools::FileExists(file.c_str(), true))
+      {
+      hash = cmCryptoHash::New("SHA1")->HashFile(file);
+      }
+    i = this->FileHashes.insert(std::make_pair(file, hash)).first;
+    }
+  return i->second;
+}
+
+//----------------------------------------------------------------------
+void cmCTestTestHandler::ReadOtherShardsFailed(cmFileLock& lock,
+  std::vector<std::string>& lines)
+{
+  std::string fname = this->CTest->GetBinaryDir() + "/Testing/Temporary/" +
+    this->GetLogFileName("TestsFailed");
+  std::string lockFile = fname + ".lock";
+  cmSystemTools::MakeDirectory(
+    cmSystemTools::GetFilenamePath(lockFile).c_str());
+  cmSystemTools::Touch(lockFile, true);
+  cmFileLockResult result = lock.Lock(lockFile, 60);
+  if(!result.IsOk())
+    {
+    cmCTestLog(this->CTest, WARNING, "Cannot lock " << lockFile << ": "
+      << result.GetOutputMessage() << std::endl);
+    }
+
+  std::set<std::string> ran;
+  for(std::vector<cmCTestTestResult>::const_iterator r =
+        this->TestResults.begin(); r != this->TestResults.end(); ++r)
+    {
+    ran.insert(r->Name);
+    }
+  cmsys::ifstream fin(fname.c_str());
+  std::string line;
+  while(cmSystemTools::GetLineFromStream(fin, line))
+    {
+    // Format: <index>:<name>
+    std::string::size_type pos = line.find(':');
+    if(pos != std::string::npos && ran.find(line.substr(pos+1)) == ran.end())
+      {
+      lines.push_back(line);
+      }
+    }
+}
+
+//----------------------------------------------------------------------
+std::string cmCTestTestHandler::GetResultCacheFile()
+{
+  return this->CTest->GetBinaryDir() +
+    "/Testing/Temporary/CTestResultCache.txt";
+}
+
+//----------------------------------------------------------------------
+void cmCTestTestHandler::ReadResultCache()
+{
+  this->PassedFingerprints.clear();
+  this->FileHashes.clear();
+  cmsys::ifstream fin(this->GetResultCacheFile().c_str());
+  std::string line;
+  while(cmSystemTools::GetLineFromStream(fin, line))
+    {
+    // Format: <fingerprint> <name>
+    std::string::size_type pos = line.find(' ');
+    if(pos != std::string::npos)
+      {
+      this->PassedFingerprints[line.substr(pos+1)] = line.substr(0, pos);
+      }
+    }
+}
+
+//----------------------------------------------------------------------
+void cmCTestTestHandler::UpdateResultCache(
+  std::map<std::string, std::string> const& passed,
+  std::vector<std::string> const& failed)
+{
+  // Other runs in this build tree, such as the other shards of the
+  // tests, may update the cache at the same time.  Merge with the
+  // entries on disk while holding a lock.
+  std::string fname = this->GetResultCacheFile();
+  std::string lockFile = fname + ".lock";
+  cmSystemTools::Touch(lockFile, true);
+  cmFileLock lock;
+  cmFileLockResult result = lock.Lock(lockFile, 60);
+  if(!result.IsOk())
+    {
+    cmCTestLog(this->CTest, WARNING, "Cannot lock " << lockFile << ": "
+      << result.GetOutputMessage() << std::endl);
+    }
+  this->ReadResultCache();
+  for(std::map<std::string, std::string>::const_iterator p = passed.begin();
+      p != passed.end(); ++p)
+    {
+    this->PassedFingerprints[p->first] = p->second;
+    }
+  for(std::vector<std::string>::const_iterator f = failed.begin();
+      f != failed.end(); ++f)
+    {
+    this->PassedFingerprints.erase(*f);
+    }
+
+  std::ostringstream tmpout;
+  tmpout << fname << "." << cmSystemTools::RandomSeed() << ".tmp";
+  cmsys::ofstream fout(tmpout.str().c_str());
+  for(std::map<std::string, std::string>::const_iterator i =
+        this->PassedFingerprints.begin();
+      i != this->PassedFingerprints.end(); ++i)
+    {
+    fout << i->second << " " << i->first << "\n";
+    }
+  fout.close();
+  cmSystemTools::RenameFile(tmpout.str().c_str(), fname.c_str());
+}
+
 //----------------------------------------------------------------------
 bool cmCTestTestHandler::SetTestsProperties(
   const std::vector<std::string>& args)
@@ -2179,6 +2468,10 @@ bool cmCTestTestHandler::SetTestsProperties(
             {
             cmSystemTools::ExpandListArgument(val, rtit->RequiredFiles);
             }
+          if ( key == "INPUT_FILES" )
+            {
+            cmSystemTools::ExpandListArgument(val, rtit->InputFiles);
+            }
           if ( key == "RUN_SERIAL" )
             {
             rtit->RunSerial = cmSystemTools::IsOn(val.c_str());
@@ -2329,6 +2622,7 @@ bool cmCTestTestHandler::AddTest(const std::vector<std::string>& args)
   test.Timeout = 0;
   test.ExplicitTimeout = false;
   test.Cost = 0;
+  test.CostVariance = 0;
   test.Processors = 1;
   test.SkipReturnCode = -1;
   test.PreviousRuns = 0;
@@ -18,6 +18,8 @@
 #include <cmsys/RegularExpression.hxx>
 
 class cmMakefile;
+class cmGeneratedFileStream;
+class cmFileLock;
 
 /** \class cmCTestTestHandler
  * \brief A class that handles ctest -S invocations
@@ -49,6 +51,13 @@ public:
    */
   void SetRerunFailed(bool val) { this->RerunFailed = val; }
 
+  /**
+   * Set whether or not CTest should skip the tests that passed on a
+   * previous run and whose inputs did not change since.  By default
+   * this is false.
+   */
+  void SetSkipUnchanged(bool val) { this->SkipUnchanged = val; }
+
   /**
    * This method is called when reading CTest custom file
    */
@@ -91,6 +100,7 @@ public:
     std::string Directory;
     std::vector<std::string> Args;
     std::vector<std::string> RequiredFiles;
+    std::vector<std::string> InputFiles;
     std::vector<std::string> Depends;
     std::vector<std::string> AttachedFiles;
     std::vector<std::string> AttachOnFail;
@@ -102,6 +112,7 @@ public:
     bool IsInBasedOnREOptions;
     bool WillFail;
     float Cost;
+    float CostVariance;
     int PreviousRuns;
     bool RunSerial;
     double Timeout;
@@ -165,10 +176,15 @@ protected:
   int ExecuteCommands(std::vector<std::string>& vec);
 
   void WriteTestResultHeader(std::ostream& os, cmCTestTestResult* result);
+  void WriteTestResult(std::ostream& os, cmCTestTestResult* result);
   void WriteTestResultFooter(std::ostream& os, cmCTestTestResult* result);
   // Write attached test files into the xml
   void AttachFiles(std::ostream& os, cmCTestTestResult* result);
 
+  // Store the result of a finished test.  When results are streamed
+  // the result is written out right away and its output is released.
+  void RecordTestResult(cmCTestTestResult const& result);
+
   //! Clean test output to specified length
   bool CleanTestOutput(std::string& output, size_t length);
 
@@ -284,7 +300,32 @@ private:
 
   std::ostream* LogFile;
 
+  // Test elements of the results written so far.
+  std::ostream* ResultsStream;
+  std::string ResultsStreamFile;
+  bool ResultsStreamLost;
+
   bool RerunFailed;
+  int ShardIndex;
+  int ShardCount;
+  void ReadOtherShardsFailed(cmFileLock& lock,
+                             std::vector<std::string>& lines);
+
+  // Skip tests whose fingerprint matches the one they last passed with.
+  bool SkipUnchanged;
+  std::map<std::string, std::string> PassedFingerprints;
+  std::map<std::string, std::string> FileHashes;
+  std::string GetFileHash(std::string const& file);
+  std::string GetResultCacheFile();
+  void ReadResultCache();
+
+  /**
+   * Record in the result cache the fingerprints of tests that passed
+   * and forget the tests that failed.  Entries of other tests are kept
+   * as another ctest run in the same build tree may have written them.
+   */
+  void UpdateResultCache(std::map<std::string, std::string> const& passed,
+                         std::vector<std::string> const& failed);
 };
 
 #endif
@@ -48,6 +48,7 @@
 #include "cmFileCommand.cxx"
 #include "cmFindFileCommand.cxx"
 #include "cmFindLibraryCommand.cxx"
+#include "cmFindPackageCache.cxx"
 #include "cmFindPackageCommand.cxx"
 #include "cmFindPathCommand.cxx"
 #include "cmFindProgramCommand.cxx"
@@ -0,0 +1,58 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2000-2009 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#include "cmCMakeCheckBatchCommand.h"
+
+#include <cmsys/SystemInformation.hxx>
+
+// cmCMakeCheckBatchCommand
+bool cmCMakeCheckBatchCommand
+::InitialPass(std::vector<std::string> const& args, cmExecutionStatus &)
+{
+  if(args.empty() || args[0] != "RUN")
+    {
+    this->SetError("must be called with RUN.");
+    return false;
+    }
+
+  // Build as many checks at once as there are processors by default.
+  unsigned long parallel = 0;
+  for(size_t i = 1; i < args.size(); ++i)
+    {
+    long value;
+    if(args[i] == "PARALLEL_LEVEL" && i + 1 < args.size() &&
+       cmSystemTools::StringToLong(args[i + 1].c_str(), &value) &&
+       value > 0)
+      {
+      parallel = static_cast<unsigned long>(value);
+      ++i;
+      }
+    else
+      {
+      this->SetError("given invalid arguments.  "
+                     "Only PARALLEL_LEVEL <n> may follow RUN.");
+      return false;
+      }
+    }
+  if(parallel == 0)
+    {
+    cmsys::SystemInformation info;
+    info.RunCPUCheck();
+    parallel = info.GetNumberOfLogicalCPU();
+    if(parallel == 0)
+      {
+      parallel = 1;
+      }
+    }
+
+  this->RunBatch(parallel);
+  return true;
+}
@@ -0,0 +1,50 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2000-2009 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#ifndef cmCMakeCheckBatchCommand_h
+#define cmCMakeCheckBatchCommand_h
+
+#include "cmCoreTryCompile.h"
+
+/** \class cmCMakeCheckBatchCommand
+ * \brief Build the checks queued by try_compile(BATCH)
+ *
+ * cmCMakeCheckBatchCommand builds the queued checks of the current
+ * directory concurrently and reports their results in order.
+ */
+class cmCMakeCheckBatchCommand : public cmCoreTryCompile
+{
+public:
+  /**
+   * This is a virtual constructor for the command.
+   */
+  virtual cmCommand* Clone()
+    {
+    return new cmCMakeCheckBatchCommand;
+    }
+
+  /**
+   * This is called when the command is first encountered in
+   * the CMakeLists.txt file.
+   */
+  virtual bool InitialPass(std::vector<std::string> const& args,
+                           cmExecutionStatus &status);
+
+  /**
+   * The name of the command as specified in CMakeList.txt.
+   */
+  virtual std::string GetName() const { return "cmake_check_batch";}
+
+  cmTypeMacro(cmCMakeCheckBatchCommand, cmCoreTryCompile);
+};
+
+
+#endif
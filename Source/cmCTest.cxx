@@ -2190,6 +2190,19 @@ void cmCTest::HandleCommandLineArguments(size_t &i,
     this->GetHandler("test")->SetPersistentOption("RerunFailed", "true");
     this->GetHandler("memcheck")->SetPersistentOption("RerunFailed", "true");
     }
+
+  if(this->CheckArgument(arg, "--skip-unchanged"))
+    {
+    this->GetHandler("test")->SetPersistentOption("SkipUnchanged", "true");
+    }
+
+  if(this->CheckArgument(arg, "--shard") && i < args.size() - 1)
+    {
+    i++;
+    this->GetHandler("test")->SetPersistentOption("Shard", args[i].c_str());
+    this->GetHandler("memcheck")->
+      SetPersistentOption("Shard", args[i].c_str());
+    }
 }
 
 //----------------------------------------------------------------------
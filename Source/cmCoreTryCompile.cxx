@@ -16,15 +16,43 @@
 #include "cmGlobalGenerator.h"
 #include "cmExportTryCompileFileGenerator.h"
 #include <cmsys/Directory.hxx>
+#include <cmsys/FStream.hxx>
+#include <cmsys/Process.h>
+
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+# include "cmCryptoHash.h"
+# include "cmFileLockResult.h"
+#endif
 
 #include <assert.h>
 
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+//----------------------------------------------------------------------------
+// Lock an entry of the result cache.  An entry already locked by this
+// process belongs to another check of the same batch.
+static bool cmCoreTryCompileLockEntry(cmFileLockPool& lockPool,
+                                      std::string const& cacheLock)
+{
+  cmSystemTools::MakeDirectory(
+    cmSystemTools::GetFilenamePath(cacheLock).c_str());
+  FILE* lockFile = cmsys::SystemTools::Fopen(cacheLock, "w");
+  if(!lockFile)
+    {
+    return false;
+    }
+  fclose(lockFile);
+  return lockPool.LockProcessScope(cacheLock,
+                                   static_cast<unsigned long>(-1)).IsOk();
+}
+#endif
+
 int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv)
 {
   this->BinaryDirectory = argv[1].c_str();
   this->OutputFile = "";
   // which signature were we called with ?
   this->SrcFileSignature = true;
+  this->Queued = false;
 
   const char* sourceDirectory = argv[2].c_str();
   const char* projectName = 0;
@@ -35,12 +63,14 @@ int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv)
   std::string copyFile;
   std::string copyFileError;
   std::vector<cmTarget const*> targets;
+  std::vector<std::string> linkLibraries;
   std::string libsToLink = " ";
   bool useOldLinkLibs = true;
   char targetNameBuf[64];
   bool didOutputVariable = false;
   bool didCopyFile = false;
   bool didCopyFileError = false;
+  bool batch = false;
   bool useSources = argv[2] == "SOURCES";
   std::vector<std::string> sources;
 
@@ -82,6 +112,11 @@ int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv)
       doing = DoingCopyFileError;
       didCopyFileError = true;
       }
+    else if(argv[i] == "BATCH")
+      {
+      doing = DoingNone;
+      batch = true;
+      }
     else if(doing == DoingCMakeFlags)
       {
       cmakeFlags.push_back(argv[i]);
@@ -93,6 +128,7 @@ int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv)
     else if(doing == DoingLinkLibraries)
       {
       libsToLink += "\"" + cmSystemTools::TrimWhitespace(argv[i]) + "\" ";
+      linkLibraries.push_back(cmSystemTools::TrimWhitespace(argv[i]));
       if(cmTarget *tgt = this->Makefile->FindTargetToUse(argv[i]))
         {
         switch(tgt->GetType())
@@ -197,6 +233,14 @@ int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv)
     {
     this->BinaryDirectory += cmake::GetCMakeFilesDirectory();
     this->BinaryDirectory += "/CMakeTmp";
+    if(batch)
+      {
+      // A queued check keeps its own directory until the batch runs.
+      sprintf(targetNameBuf, "cmTC_%05x",
+              cmSystemTools::RandomSeed() & 0xFFFFF);
+      targetName = targetNameBuf;
+      this->BinaryDirectory += "Batch/" + targetName;
+      }
     }
   else
     {
@@ -213,6 +257,12 @@ int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv)
         "COPY_FILE specified on a srcdir type TRY_COMPILE");
       return -1;
       }
+    if (batch)
+      {
+      this->Makefile->IssueMessage(cmake::FATAL_ERROR,
+        "BATCH specified on a srcdir type TRY_COMPILE");
+      return -1;
+      }
     }
   // make sure the binary directory exists
   cmSystemTools::MakeDirectory(this->BinaryDirectory.c_str());
@@ -228,6 +278,10 @@ int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv)
     }
 
   std::string outFileName = this->BinaryDirectory + "/CMakeLists.txt";
+  std::string cacheEntry;
+  std::string cacheKey;
+  std::vector<std::string> cacheSources;
+  std::vector<std::vector<std::string> > directCommands;
   // which signature are we using? If we are using var srcfile bindir
   if (this->SrcFileSignature)
     {
@@ -374,9 +428,12 @@ int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv)
 
     /* Use a random file name to avoid rapid creation and deletion
        of the same executable name (some filesystems fail on that).  */
-    sprintf(targetNameBuf, "cmTC_%05x",
-            cmSystemTools::RandomSeed() & 0xFFFFF);
-    targetName = targetNameBuf;
+    if(targetName.empty())
+      {
+      sprintf(targetNameBuf, "cmTC_%05x",
+              cmSystemTools::RandomSeed() & 0xFFFFF);
+      targetName = targetNameBuf;
+      }
 
     if (!targets.empty())
       {
@@ -504,26 +561,161 @@ int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv)
       }
     fclose(fout);
     projectName = "CMAKE_TRY_COMPILE";
+
+    // Simple checks may be built directly with the compiler.  Queued
+    // checks build a copy of a temporary source because later checks
+    // may write the same file before the batch runs.
+    cacheSources = sources;
+    if((batch || this->Makefile->IsOn("CMAKE_TRY_COMPILE_DIRECT")) &&
+       sources.size() == 1 && testLangs.size() == 1 && targets.empty())
+      {
+      std::string source = sources[0];
+      bool copied = true;
+      if(batch && source.find("CMakeTmp") != source.npos)
+        {
+        std::string copy = this->BinaryDirectory + "/" +
+          cmSystemTools::GetFilenameName(source);
+        copied = cmSystemTools::CopyFileAlways(source, copy);
+        source = copy;
+        cacheSources[0] = copy;
+        }
+      if(!copied ||
+         !this->ComputeDirectCommands(source, *testLangs.begin(),
+                                      targetName, cmakeFlags, compileDefs,
+                                      linkLibraries, useOldLinkLibs,
+                                      directCommands))
+        {
+        directCommands.clear();
+        }
+      }
+
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+    // Name the entry of the result cache, if any.  Imported targets
+    // bring in files the cache key does not cover.
+    const char* cacheDir =
+      this->Makefile->GetDefinition("CMAKE_TRY_COMPILE_CACHE_DIR");
+    if(cacheDir && *cacheDir && targets.empty())
+      {
+      cacheEntry = cmSystemTools::CollapseFullPath(cacheDir);
+      cacheEntry += "/";
+      cacheKey = this->ComputeCacheKey(cmakeFlags, testLangs, targetName);
+      }
+#endif
     }
 
+  // Queue checks that can be built directly until the batch runs.
+  if(batch && !directCommands.empty())
+    {
+    cmTryCompileBatchCheck* check = new cmTryCompileBatchCheck;
+    check->ResultVariable = argv[0];
+    check->OutputVariable = outputVariable;
+    check->CopyFile = copyFile;
+    check->CopyFileError = copyFileError;
+    check->BinaryDirectory = this->BinaryDirectory;
+    check->TargetName = targetName;
+    check->CacheEntry = cacheEntry;
+    check->CacheKey = cacheKey;
+    check->CacheSources = cacheSources;
+    check->Commands = directCommands;
+    this->Makefile->GetTryCompileBatch().push_back(check);
+    this->Queued = true;
+    return 0;
+    }
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  if(!cacheEntry.empty())
+    {
+    cacheEntry += this->HashCacheKey(cacheKey, cacheSources);
+    }
+#endif
+
   bool erroroc = cmSystemTools::GetErrorOccuredFlag();
   cmSystemTools::ResetErrorOccuredFlag();
   std::string output;
+  int res = 1;
+  bool cached = false;
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  // Lock the cache entry so that the same check running in another
+  // build tree waits for this one and then reuses its result.
+  cmFileLockPool& lockPool = this->Makefile->GetLocalGenerator()->
+      GetGlobalGenerator()->GetFileLockPool();
+  std::string cacheLock = cacheEntry + ".lock";
+  if(!cacheEntry.empty() && cmCoreTryCompileLockEntry(lockPool, cacheLock))
+    {
+    cached = this->LoadCachedResult(cacheEntry, targetName, res, output);
+    }
+  else
+    {
+    cacheEntry = "";
+    }
+#endif
   // actually do the try compile now that everything is setup
-  int res = this->Makefile->TryCompile(sourceDirectory,
-                                       this->BinaryDirectory,
-                                       projectName,
-                                       targetName,
-                                       this->SrcFileSignature,
-                                       &cmakeFlags,
-                                       output);
+  if(!cached && !directCommands.empty())
+    {
+    res = this->RunDirectCommands(directCommands, output);
+    }
+  else if(!cached)
+    {
+    res = this->Makefile->TryCompile(sourceDirectory,
+                                     this->BinaryDirectory,
+                                     projectName,
+                                     targetName,
+                                     this->SrcFileSignature,
+                                     &cmakeFlags,
+                                     output);
+    }
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  if(!cacheEntry.empty())
+    {
+    // Results of a failure to run the test project are not kept.
+    if(!cached && !cmSystemTools::GetErrorOccuredFlag())
+      {
+      this->StoreCachedResult(cacheEntry, targetName, res, output);
+      }
+    lockPool.Release(cacheLock);
+    }
+#endif
   if ( erroroc )
     {
     cmSystemTools::SetErrorOccured();
     }
 
+  // Checks of a batch that had to be built now still report their
+  // results in order with the others.
+  if(batch)
+    {
+    cmTryCompileBatchCheck* check = new cmTryCompileBatchCheck;
+    check->ResultVariable = argv[0];
+    check->OutputVariable = outputVariable;
+    check->CopyFile = copyFile;
+    check->CopyFileError = copyFileError;
+    check->BinaryDirectory = this->BinaryDirectory;
+    check->TargetName = targetName;
+    check->Output = output;
+    check->Result = res;
+    check->Done = true;
+    this->Makefile->GetTryCompileBatch().push_back(check);
+    this->Queued = true;
+    return 0;
+    }
+
+  if(!this->ReportResult(argv[0], res, output, outputVariable, targetName,
+                         copyFile, copyFileError))
+    {
+    return -1;
+    }
+  return res;
+}
+
+//----------------------------------------------------------------------------
+bool cmCoreTryCompile::ReportResult(std::string const& resultVar, int res,
+                                    std::string const& output,
+                                    std::string const& outputVariable,
+                                    std::string const& targetName,
+                                    std::string const& copyFile,
+                                    std::string const& copyFileError)
+{
   // set the result var to the return value to indicate success or failure
-  this->Makefile->AddCacheDefinition(argv[0],
+  this->Makefile->AddCacheDefinition(resultVar,
                                      (res == 0 ? "TRUE" : "FALSE"),
                                      "Result of TRY_COMPILE",
                                      cmCacheManager::INTERNAL);
@@ -556,7 +748,7 @@ int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv)
         if(copyFileError.empty())
           {
           this->Makefile->IssueMessage(cmake::FATAL_ERROR, emsg.str());
-          return -1;
+          return false;
           }
         else
           {
@@ -571,7 +763,7 @@ int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv)
                                     copyFileErrorMessage.c_str());
       }
     }
-  return res;
+  return true;
 }
 
 void cmCoreTryCompile::CleanupFiles(const char* binDir)
@@ -689,3 +881,720 @@ void cmCoreTryCompile::FindOutputFile(const std::string& targetName)
   this->FindErrorMessage = emsg.str();
   return;
 }
+
+//----------------------------------------------------------------------------
+static void cmCoreTryCompileAppendArgs(std::vector<std::string>& args,
+                                       std::string const& flags)
+{
+#if defined(_WIN32)
+  cmSystemTools::ParseWindowsCommandLine(flags.c_str(), args);
+#else
+  cmSystemTools::ParseUnixCommandLine(flags.c_str(), args);
+#endif
+}
+
+//----------------------------------------------------------------------------
+// Expand the placeholders of a build rule into a command line.  A
+// placeholder forming a whole argument may expand to any number of
+// arguments, one inside an argument must expand to exactly one.
+// Returns false if the rule uses a placeholder that has no value.
+typedef std::map<std::string, std::vector<std::string> >
+  cmCoreTryCompileRuleValues;
+static bool
+cmCoreTryCompileExpandRule(std::string const& rule,
+                           cmCoreTryCompileRuleValues const& values,
+                           std::vector<std::string>& command)
+{
+  std::vector<std::string> tokens;
+  cmCoreTryCompileAppendArgs(tokens, rule);
+  for(std::vector<std::string>::const_iterator ti = tokens.begin();
+      ti != tokens.end(); ++ti)
+    {
+    std::string arg;
+    std::string::size_type pos = 0;
+    while(pos < ti->size())
+      {
+      std::string::size_type start = ti->find('<', pos);
+      std::string::size_type end = start == std::string::npos?
+        start : ti->find('>', start);
+      if(end == std::string::npos)
+        {
+        arg += ti->substr(pos);
+        break;
+        }
+      arg += ti->substr(pos, start - pos);
+      cmCoreTryCompileRuleValues::const_iterator vi =
+        values.find(ti->substr(start + 1, end - start - 1));
+      if(vi == values.end())
+        {
+        return false;
+        }
+      if(start == 0 && end + 1 == ti->size())
+        {
+        command.insert(command.end(), vi->second.begin(), vi->second.end());
+        break;
+        }
+      if(vi->second.size() != 1)
+        {
+        return false;
+        }
+      arg += vi->second[0];
+      pos = end + 1;
+      }
+    if(!arg.empty())
+      {
+      command.push_back(arg);
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool cmCoreTryCompile::ComputeDirectCommands(
+  std::string const& source, std::string const& lang,
+  std::string const& targetName,
+  std::vector<std::string> const& cmakeFlags,
+  std::vector<std::string> const& compileDefs,
+  std::vector<std::string> const& linkLibraries, bool useOldLinkLibs,
+  std::vector<std::vector<std::string> >& cmds)
+{
+  cmMakefile* mf = this->Makefile;
+  std::string prefix = "CMAKE_" + lang;
+
+  // Multi-configuration generators build with their own settings, and
+  // these variables change the flags the generator would use.  The test
+  // project builds the default configuration of some platforms, whose
+  // flags come from its own initial values.
+  if(mf->GetLocalGenerator()->GetGlobalGenerator()->IsMultiConfig() ||
+     *mf->GetSafeDefinition("CMAKE_TRY_COMPILE_CONFIGURATION") ||
+     *mf->GetSafeDefinition("CMAKE_BUILD_TYPE_INIT") ||
+     mf->GetDefinition("CMAKE_POSITION_INDEPENDENT_CODE") ||
+     mf->GetDefinition("CMAKE_USER_MAKE_RULES_OVERRIDE") ||
+     mf->GetDefinition("CMAKE_USER_MAKE_RULES_OVERRIDE_" + lang))
+    {
+    return false;
+    }
+
+  // Accept only the variables the generated project reads.  The
+  // project links no shared library by path so it needs no rpath.
+  std::map<std::string, std::string> vars;
+  for(std::vector<std::string>::const_iterator fi = cmakeFlags.begin();
+      fi != cmakeFlags.end(); ++fi)
+    {
+    if(fi->empty() || *fi == "CMAKE_FLAGS")
+      {
+      continue;
+      }
+    std::string::size_type eq = fi->find('=');
+    if(fi->compare(0, 2, "-D") != 0 || eq == std::string::npos)
+      {
+      return false;
+      }
+    std::string name = fi->substr(2, eq - 2);
+    name = name.substr(0, name.find(':'));
+    if(name != "COMPILE_DEFINITIONS" && name != "INCLUDE_DIRECTORIES" &&
+       name != "LINK_DIRECTORIES" && name != "LINK_LIBRARIES" &&
+       name != "EXE_LINKER_FLAGS" && name != "CMAKE_SKIP_RPATH")
+      {
+      return false;
+      }
+    vars[name] = fi->substr(eq + 1);
+    }
+
+  // Compile flags: language flags, include directories, definitions.
+  std::vector<std::string> flags;
+  cmCoreTryCompileAppendArgs(flags, mf->GetSafeDefinition(prefix + "_FLAGS"));
+  cmCoreTryCompileAppendArgs(flags, vars["COMPILE_DEFINITIONS"]);
+  std::string includeFlag = mf->GetSafeDefinition("CMAKE_INCLUDE_FLAG_"+lang);
+  std::vector<std::string> dirs;
+  cmSystemTools::ExpandListArgument(vars["INCLUDE_DIRECTORIES"], dirs);
+  if(!dirs.empty() && includeFlag.empty())
+    {
+    return false;
+    }
+  std::vector<std::string> implicitDirs;
+  cmSystemTools::ExpandListArgument(
+    mf->GetSafeDefinition(prefix + "_IMPLICIT_INCLUDE_DIRECTORIES"),
+    implicitDirs);
+  for(std::vector<std::string>::const_iterator di = dirs.begin();
+      di != dirs.end(); ++di)
+    {
+    std::string dir =
+      cmSystemTools::CollapseFullPath(*di, this->BinaryDirectory);
+    if(std::find(implicitDirs.begin(), implicitDirs.end(), dir) ==
+       implicitDirs.end())
+      {
+      flags.push_back(includeFlag + dir);
+      }
+    }
+  for(std::vector<std::string>::const_iterator di = compileDefs.begin();
+      di != compileDefs.end(); ++di)
+    {
+    cmCoreTryCompileAppendArgs(flags, *di);
+    }
+
+  // Link flags as the generated project sets them.
+  std::string linkFlagsStr;
+  if(mf->GetPolicyStatus(cmPolicies::CMP0056) == cmPolicies::NEW)
+    {
+    linkFlagsStr = mf->GetSafeDefinition("CMAKE_EXE_LINKER_FLAGS");
+    }
+  else
+    {
+    linkFlagsStr = mf->GetSafeDefinition("CMAKE_EXE_LINKER_FLAGS_INIT");
+    }
+  linkFlagsStr += " " + vars["EXE_LINKER_FLAGS"];
+  linkFlagsStr += " ";
+  linkFlagsStr += mf->GetSafeDefinition("CMAKE_CREATE_CONSOLE_EXE");
+  std::vector<std::string> linkFlags;
+  cmCoreTryCompileAppendArgs(linkFlags, linkFlagsStr);
+
+  // Libraries: plain names and flags, or static libraries by path.
+  // Shared libraries by path would need a runtime search path.
+  std::vector<std::string> linkLibs;
+  cmCoreTryCompileAppendArgs(linkLibs,
+    mf->GetSafeDefinition("CMAKE_SHARED_LIBRARY_LINK_" + lang + "_FLAGS"));
+  dirs.clear();
+  cmSystemTools::ExpandListArgument(vars["LINK_DIRECTORIES"], dirs);
+  for(std::vector<std::string>::const_iterator di = dirs.begin();
+      di != dirs.end(); ++di)
+    {
+    linkLibs.push_back(mf->GetSafeDefinition("CMAKE_LIBRARY_PATH_FLAG") +
+      cmSystemTools::CollapseFullPath(*di, this->BinaryDirectory) +
+      mf->GetSafeDefinition("CMAKE_LIBRARY_PATH_TERMINATOR"));
+    }
+  std::vector<std::string> libs;
+  if(useOldLinkLibs)
+    {
+    cmSystemTools::ExpandListArgument(vars["LINK_LIBRARIES"], libs);
+    }
+  else
+    {
+    libs = linkLibraries;
+    }
+  std::string staticSuffix =
+    mf->GetSafeDefinition("CMAKE_STATIC_LIBRARY_SUFFIX");
+  for(std::vector<std::string>::const_iterator li = libs.begin();
+      li != libs.end(); ++li)
+    {
+    std::string const& lib = *li;
+    if(lib.empty())
+      {
+      continue;
+      }
+    else if(lib[0] == '-' && lib.find(' ') == std::string::npos)
+      {
+      linkLibs.push_back(lib);
+      }
+    else if(cmSystemTools::FileIsFullPath(lib.c_str()) &&
+            !staticSuffix.empty() &&
+            cmSystemTools::StringEndsWith(lib.c_str(), staticSuffix.c_str()))
+      {
+      linkLibs.push_back(lib);
+      }
+    else if(lib.find_first_of("/\\.$<> ") == std::string::npos &&
+            lib != "debug" && lib != "optimized" && lib != "general" &&
+            !mf->FindTargetToUse(lib))
+      {
+      linkLibs.push_back(mf->GetSafeDefinition("CMAKE_LINK_LIBRARY_FLAG") +
+                         lib +
+                         mf->GetSafeDefinition("CMAKE_LINK_LIBRARY_SUFFIX"));
+      }
+    else
+      {
+      return false;
+      }
+    }
+
+  // Fill in the placeholders of the compile and link rules.
+  std::string objectDir = this->BinaryDirectory;
+  objectDir += cmake::GetCMakeFilesDirectory();
+  objectDir += "/" + targetName + ".dir";
+  std::string object = objectDir + "/";
+  object += cmSystemTools::GetFilenameName(source);
+  object += mf->GetSafeDefinition(prefix + "_OUTPUT_EXTENSION");
+  std::string exe = this->BinaryDirectory + "/" + targetName;
+  exe += mf->GetSafeDefinition("CMAKE_EXECUTABLE_SUFFIX");
+
+  cmCoreTryCompileRuleValues values;
+  std::vector<std::string>& compiler = values[prefix + "_COMPILER"];
+  compiler.push_back(mf->GetSafeDefinition(prefix + "_COMPILER"));
+  cmCoreTryCompileAppendArgs(compiler,
+                             mf->GetSafeDefinition(prefix + "_COMPILER_ARG1"));
+  cmCoreTryCompileAppendArgs(values[prefix + "_LINK_FLAGS"],
+                             mf->GetSafeDefinition(prefix + "_LINK_FLAGS"));
+  if(const char* linker = mf->GetDefinition("CMAKE_LINKER"))
+    {
+    values["CMAKE_LINKER"].push_back(linker);
+    }
+  values["DEFINES"];
+  values["INCLUDES"];
+  values["FLAGS"] = flags;
+  values["SOURCE"].push_back(source);
+  values["OBJECT"].push_back(object);
+  values["OBJECT_DIR"].push_back(objectDir);
+
+  std::vector<std::string> rules;
+  cmSystemTools::ExpandListArgument(
+    mf->GetSafeDefinition(prefix + "_COMPILE_OBJECT"), rules);
+  if(rules.empty())
+    {
+    return false;
+    }
+  for(std::vector<std::string>::const_iterator ri = rules.begin();
+      ri != rules.end(); ++ri)
+    {
+    cmds.push_back(std::vector<std::string>());
+    if(!cmCoreTryCompileExpandRule(*ri, values, cmds.back()))
+      {
+      return false;
+      }
+    }
+
+  // The link rule sees only the language flags.
+  values["FLAGS"].clear();
+  cmCoreTryCompileAppendArgs(values["FLAGS"],
+                             mf->GetSafeDefinition(prefix + "_FLAGS"));
+  values["OBJECTS"].push_back(object);
+  values["TARGET"].push_back(exe);
+  values["LINK_FLAGS"] = linkFlags;
+  values["LINK_LIBRARIES"] = linkLibs;
+  rules.clear();
+  cmSystemTools::ExpandListArgument(
+    mf->GetSafeDefinition(prefix + "_LINK_EXECUTABLE"), rules);
+  if(rules.empty())
+    {
+    return false;
+    }
+  for(std::vector<std::string>::const_iterator ri = rules.begin();
+      ri != rules.end(); ++ri)
+    {
+    cmds.push_back(std::vector<std::string>());
+    if(!cmCoreTryCompileExpandRule(*ri, values, cmds.back()))
+      {
+      return false;
+      }
+    }
+  return cmSystemTools::MakeDirectory(objectDir.c_str());
+}
+
+//----------------------------------------------------------------------------
+// A check of a batch whose build commands are running.
+struct cmCoreTryCompileRunningCheck
+{
+  cmTryCompileBatchCheck* Check;
+  size_t Command;
+  cmsysProcess* Process;
+};
+
+//----------------------------------------------------------------------------
+static bool cmCoreTryCompileStartCommand(cmCoreTryCompileRunningCheck& r)
+{
+  cmTryCompileBatchCheck* check = r.Check;
+  std::vector<std::string> const& command = check->Commands[r.Command];
+  check->Output += "\nRun Build Command:";
+  check->Output += cmSystemTools::PrintSingleCommand(command);
+  check->Output += "\n";
+
+  std::vector<const char*> argv;
+  for(std::vector<std::string>::const_iterator ai = command.begin();
+      ai != command.end(); ++ai)
+    {
+    argv.push_back(ai->c_str());
+    }
+  argv.push_back(0);
+  r.Process = cmsysProcess_New();
+  cmsysProcess_SetCommand(r.Process, &*argv.begin());
+  cmsysProcess_SetWorkingDirectory(r.Process,
+                                   check->BinaryDirectory.c_str());
+  cmsysProcess_SetOption(r.Process, cmsysProcess_Option_HideWindow, 1);
+  cmsysProcess_Execute(r.Process);
+  if(cmsysProcess_GetState(r.Process) == cmsysProcess_State_Error)
+    {
+    check->Output += cmsysProcess_GetErrorString(r.Process);
+    check->Output += "\nexecution of build command failed: " +
+      cmSystemTools::PrintSingleCommand(command) + "\n";
+    cmsysProcess_Delete(r.Process);
+    r.Process = 0;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Collect the output of a running command.  Returns true when the
+// command has finished and stores its result in the check.
+static bool cmCoreTryCompileCheckCommand(cmCoreTryCompileRunningCheck& r)
+{
+  char* data;
+  int length;
+  double timeout = 0.01;
+  int pipe = cmsysProcess_WaitForData(r.Process, &data, &length, &timeout);
+  if(pipe == cmsysProcess_Pipe_Timeout)
+    {
+    return false;
+    }
+  if(pipe != cmsysProcess_Pipe_None)
+    {
+    r.Check->Output.append(data, length);
+    return false;
+    }
+  cmsysProcess_WaitForExit(r.Process, 0);
+  r.Check->Result = 1;
+  if(cmsysProcess_GetState(r.Process) == cmsysProcess_State_Exited)
+    {
+    r.Check->Result = cmsysProcess_GetExitValue(r.Process);
+    }
+  else if(cmsysProcess_GetState(r.Process) == cmsysProcess_State_Exception)
+    {
+    r.Check->Output += cmsysProcess_GetExceptionString(r.Process);
+    r.Check->Output += "\n";
+    }
+  cmsysProcess_Delete(r.Process);
+  r.Process = 0;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Run the commands of each check in order, building up to the given
+// number of checks concurrently.
+static void
+cmCoreTryCompileRunChecks(std::vector<cmTryCompileBatchCheck*> const& checks,
+                          unsigned long parallel)
+{
+  std::vector<cmCoreTryCompileRunningCheck> running;
+  std::vector<cmTryCompileBatchCheck*>::const_iterator next = checks.begin();
+  while(next != checks.end() || !running.empty())
+    {
+    while(next != checks.end() && running.size() < parallel)
+      {
+      cmCoreTryCompileRunningCheck r;
+      r.Check = *next++;
+      r.Command = 0;
+      r.Process = 0;
+      r.Check->Output = "Change Dir: " + r.Check->BinaryDirectory + "\n";
+      r.Check->Result = 0;
+      if(r.Check->Commands.empty())
+        {
+        r.Check->Done = true;
+        }
+      else if(!cmCoreTryCompileStartCommand(r))
+        {
+        r.Check->Result = 1;
+        r.Check->Done = true;
+        }
+      else
+        {
+        running.push_back(r);
+        }
+      }
+
+    for(size_t i = 0; i < running.size();)
+      {
+      cmCoreTryCompileRunningCheck& r = running[i];
+      if(!cmCoreTryCompileCheckCommand(r))
+        {
+        ++i;
+        continue;
+        }
+      if(r.Check->Result == 0 && ++r.Command < r.Check->Commands.size())
+        {
+        if(cmCoreTryCompileStartCommand(r))
+          {
+          ++i;
+          continue;
+          }
+        r.Check->Result = 1;
+        }
+      // Some compilers do not fail on #error, as in
+      // cmGlobalGenerator::Build.
+      if(r.Check->Result == 0 &&
+         r.Check->Output.find("#error") != std::string::npos)
+        {
+        r.Check->Result = 1;
+        }
+      r.Check->Done = true;
+      running.erase(running.begin() + i);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+int cmCoreTryCompile::RunDirectCommands(
+  std::vector<std::vector<std::string> > const& cmds, std::string& output)
+{
+  cmTryCompileBatchCheck check;
+  check.BinaryDirectory = this->BinaryDirectory;
+  check.Commands = cmds;
+  cmCoreTryCompileRunChecks(
+    std::vector<cmTryCompileBatchCheck*>(1, &check), 1);
+  output += check.Output;
+  return check.Result;
+}
+
+//----------------------------------------------------------------------------
+void cmCoreTryCompile::RunBatch(unsigned long parallel)
+{
+  std::vector<cmTryCompileBatchCheck*> checks;
+  checks.swap(this->Makefile->GetTryCompileBatch());
+  this->SrcFileSignature = true;
+  this->Queued = false;
+
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  // Take the results found in the result cache and hold the entries of
+  // the other checks until their results are stored.  The entries are
+  // locked in sorted order so that batches of several build trees
+  // sharing the cache cannot wait for each other.
+  cmFileLockPool& lockPool = this->Makefile->GetLocalGenerator()->
+      GetGlobalGenerator()->GetFileLockPool();
+  std::vector<std::pair<std::string, cmTryCompileBatchCheck*> > entries;
+  for(std::vector<cmTryCompileBatchCheck*>::const_iterator
+        ci = checks.begin(); ci != checks.end(); ++ci)
+    {
+    cmTryCompileBatchCheck* check = *ci;
+    if(check->CacheEntry.empty())
+      {
+      continue;
+      }
+    // The sources are hashed now because the compiler sees them as they
+    // are when the batch runs rather than when the check was queued.
+    check->CacheEntry += this->HashCacheKey(check->CacheKey,
+                                            check->CacheSources);
+    entries.push_back(std::make_pair(check->CacheEntry, check));
+    }
+  std::sort(entries.begin(), entries.end());
+  for(std::vector<std::pair<std::string, cmTryCompileBatchCheck*> >::
+        const_iterator ei = entries.begin(); ei != entries.end(); ++ei)
+    {
+    cmTryCompileBatchCheck* check = ei->second;
+    std::string cacheLock = check->CacheEntry + ".lock";
+    if(!cmCoreTryCompileLockEntry(lockPool, cacheLock))
+      {
+      check->CacheEntry = "";
+      continue;
+      }
+    this->BinaryDirectory = check->BinaryDirectory;
+    if(this->LoadCachedResult(check->CacheEntry, check->TargetName,
+                              check->Result, check->Output))
+      {
+      check->Done = true;
+      check->CacheEntry = "";
+      lockPool.Release(cacheLock);
+      }
+    }
+#endif
+
+  std::vector<cmTryCompileBatchCheck*> pending;
+  for(std::vector<cmTryCompileBatchCheck*>::const_iterator
+        ci = checks.begin(); ci != checks.end(); ++ci)
+    {
+    if(!(*ci)->Done)
+      {
+      pending.push_back(*ci);
+      }
+    }
+  cmCoreTryCompileRunChecks(pending, parallel);
+
+  // Report the results in the order the checks were queued.
+  for(std::vector<cmTryCompileBatchCheck*>::const_iterator
+        ci = checks.begin(); ci != checks.end(); ++ci)
+    {
+    cmTryCompileBatchCheck* check = *ci;
+    this->BinaryDirectory = check->BinaryDirectory;
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+    if(!check->CacheEntry.empty())
+      {
+      this->StoreCachedResult(check->CacheEntry, check->TargetName,
+                              check->Result, check->Output);
+      lockPool.Release(check->CacheEntry + ".lock");
+      }
+#endif
+    this->ReportResult(check->ResultVariable, check->Result, check->Output,
+                       check->OutputVariable, check->TargetName,
+                       check->CopyFile, check->CopyFileError);
+    if(!this->Makefile->GetCMakeInstance()->GetDebugTryCompile())
+      {
+      this->CleanupFiles(check->BinaryDirectory.c_str());
+      cmSystemTools::RemoveADirectory(check->BinaryDirectory);
+      }
+    }
+  cmDeleteAll(checks);
+}
+
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+//----------------------------------------------------------------------------
+static bool cmCoreTryCompileReadFile(std::string const& fname,
+                                     std::string& content)
+{
+  cmsys::ifstream fin(fname.c_str(), std::ios::in | std::ios::binary);
+  if(!fin)
+    {
+    return false;
+    }
+  std::ostringstream s;
+  s << fin.rdbuf();
+  content = s.str();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+static std::string cmCoreTryCompileHashTool(std::string const& path)
+{
+  // Compilers are hashed once per cmake run unless they change.
+  static std::map<std::string, std::pair<long, std::string> > hashes;
+  std::pair<long, std::string>& entry = hashes[path];
+  long mtime = cmSystemTools::ModifiedTime(path);
+  if(entry.second.empty() || entry.first != mtime)
+    {
+    entry.first = mtime;
+    entry.second = "";
+    if(cmSystemTools::FileExists(path.c_str(), true))
+      {
+      entry.second = cmCryptoHash::New("SHA1")->HashFile(path);
+      }
+    }
+  return entry.second;
+}
+
+//----------------------------------------------------------------------------
+std::string
+cmCoreTryCompile::ComputeCacheKey(std::vector<std::string> const& cmakeFlags,
+                                  std::set<std::string> const& langs,
+                                  std::string const& targetName)
+{
+  // The generated project and flags, independent of the build tree
+  // and of the random target name.
+  std::string key;
+  cmCoreTryCompileReadFile(this->BinaryDirectory + "/CMakeLists.txt", key);
+  key += "\n";
+  for(std::vector<std::string>::const_iterator fi = cmakeFlags.begin();
+      fi != cmakeFlags.end(); ++fi)
+    {
+    key += *fi + "\n";
+    }
+  cmSystemTools::ReplaceString(key, this->BinaryDirectory.c_str(), "<bin>");
+  // Queued checks build in a per-target directory under the one shared
+  // by all checks of the build tree.
+  std::string batchDir = "Batch/" + targetName;
+  if(cmSystemTools::StringEndsWith(this->BinaryDirectory.c_str(),
+                                   batchDir.c_str()))
+    {
+    std::string tmpDir = this->BinaryDirectory.substr(
+      0, this->BinaryDirectory.size() - batchDir.size());
+    cmSystemTools::ReplaceString(key, tmpDir.c_str(), "<bin>");
+    }
+  cmSystemTools::ReplaceString(key, targetName.c_str(), "<target>");
+
+  // The identity of the toolchain.
+  key += "generator ";
+  key += this->Makefile->GetLocalGenerator()->GetGlobalGenerator()->GetName();
+  key += "\n";
+  static const char* const compilerVars[] =
+    {"_COMPILER", "_COMPILER_ARG1", "_COMPILER_ID", "_COMPILER_VERSION", 0};
+  for(std::set<std::string>::const_iterator li = langs.begin();
+      li != langs.end(); ++li)
+    {
+    for(const char* const* v = compilerVars; *v; ++v)
+      {
+      std::string var = "CMAKE_" + *li + *v;
+      key += var + "=" + this->Makefile->GetSafeDefinition(var) + "\n";
+      }
+    key += "compiler " + cmCoreTryCompileHashTool(
+      this->Makefile->GetSafeDefinition("CMAKE_" + *li + "_COMPILER")) + "\n";
+    }
+  if(const char* toolchain =
+     this->Makefile->GetDefinition("CMAKE_TOOLCHAIN_FILE"))
+    {
+    key += "toolchain " + cmCoreTryCompileHashTool(toolchain) + "\n";
+    }
+  key += "config ";
+  key += this->Makefile->GetSafeDefinition("CMAKE_TRY_COMPILE_CONFIGURATION");
+  key += "\n";
+  return key;
+}
+
+//----------------------------------------------------------------------------
+std::string
+cmCoreTryCompile::HashCacheKey(std::string key,
+                               std::vector<std::string> const& sources)
+{
+  cmsys::auto_ptr<cmCryptoHash> sha1 = cmCryptoHash::New("SHA1");
+  for(std::vector<std::string>::const_iterator si = sources.begin();
+      si != sources.end(); ++si)
+    {
+    key += "source " + sha1->HashFile(*si) + "\n";
+    }
+  return sha1->HashString(key);
+}
+
+//----------------------------------------------------------------------------
+bool cmCoreTryCompile::LoadCachedResult(std::string const& entry,
+                                        std::string const& targetName,
+                                        int& res, std::string& output)
+{
+  cmsys::ifstream fin((entry + "/result").c_str());
+  if(!fin || !(fin >> res))
+    {
+    return false;
+    }
+  cmCoreTryCompileReadFile(entry + "/output", output);
+
+  // Put the executable where the test project would have built it.
+  std::string exe = "/executable";
+  exe += this->Makefile->GetSafeDefinition("CMAKE_EXECUTABLE_SUFFIX");
+  if(cmSystemTools::FileExists((entry + exe).c_str(), true))
+    {
+    std::string dest = this->BinaryDirectory + "/" + targetName;
+    dest += this->Makefile->GetSafeDefinition("CMAKE_EXECUTABLE_SUFFIX");
+    if(!cmSystemTools::CopyFileAlways(entry + exe, dest))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void cmCoreTryCompile::StoreCachedResult(std::string const& entry,
+                                         std::string const& targetName,
+                                         int res, std::string const& output)
+{
+  if(!cmSystemTools::MakeDirectory(entry.c_str()))
+    {
+    return;
+    }
+  {
+  cmsys::ofstream fout((entry + "/output").c_str(),
+                       std::ios::out | std::ios::binary);
+  fout << output;
+  if(!fout)
+    {
+    return;
+    }
+  }
+  std::string exe = "/executable";
+  exe += this->Makefile->GetSafeDefinition("CMAKE_EXECUTABLE_SUFFIX");
+  cmSystemTools::RemoveFile(entry + exe);
+  if(res == 0)
+    {
+    this->FindOutputFile(targetName);
+    if(!this->OutputFile.empty() &&
+       !cmSystemTools::CopyFileAlways(this->OutputFile, entry + exe))
+      {
+      return;
+      }
+    }
+
+  // The result is written last so that it marks a complete entry.
+  std::string result = entry + "/result";
+  {
+  cmsys::ofstream fout((result + ".tmp").c_str());
+  fout << res << "\n";
+  if(!fout)
+    {
+    return;
+    }
+  }
+  cmSystemTools::RenameFile((result + ".tmp").c_str(), result.c_str());
+}
+#endif
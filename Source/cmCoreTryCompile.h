@@ -14,6 +14,30 @@
 
 #include "cmCommand.h"
 
+/** \class cmTryCompileBatchCheck
+ * \brief A try_compile queued by its BATCH option.
+ *
+ * The check is built when cmake_check_batch(RUN) is called and its
+ * result is then reported as try_compile would have.
+ */
+struct cmTryCompileBatchCheck
+{
+  cmTryCompileBatchCheck(): Result(1), Done(false) {}
+  std::string ResultVariable;
+  std::string OutputVariable;
+  std::string CopyFile;
+  std::string CopyFileError;
+  std::string BinaryDirectory;
+  std::string TargetName;
+  std::string CacheEntry;
+  std::string CacheKey;
+  std::vector<std::string> CacheSources;
+  std::vector<std::vector<std::string> > Commands;
+  std::string Output;
+  int Result;
+  bool Done;
+};
+
 /** \class cmCoreTryCompile
  * \brief Base class for cmTryCompileCommand and cmTryRunCommand
  *
@@ -46,6 +70,79 @@ public:
    */
   void FindOutputFile(const std::string& targetName);
 
+  /**
+   * Set the result and output variables of a try_compile and copy the
+   * executable it built as requested by COPY_FILE.  Returns false if
+   * a fatal error was reported.
+   */
+  bool ReportResult(std::string const& resultVar, int res,
+                    std::string const& output,
+                    std::string const& outputVariable,
+                    std::string const& targetName,
+                    std::string const& copyFile,
+                    std::string const& copyFileError);
+
+  /**
+   * Build the checks queued by try_compile(BATCH) in the current
+   * directory, running up to the given number of builds concurrently,
+   * and report their results in the order they were queued.
+   */
+  void RunBatch(unsigned long parallel);
+
+  /**
+   * Compute the command lines that build a single source file
+   * signature test project directly with the compiler, without a
+   * nested cmake and native build tool.  Returns false if the project
+   * needs settings only the generator knows how to apply.
+   */
+  bool ComputeDirectCommands(std::string const& source,
+                             std::string const& lang,
+                             std::string const& targetName,
+                             std::vector<std::string> const& cmakeFlags,
+                             std::vector<std::string> const& compileDefs,
+                             std::vector<std::string> const& linkLibraries,
+                             bool useOldLinkLibs,
+                             std::vector<std::vector<std::string> >& cmds);
+
+  /**
+   * Run the commands computed by ComputeDirectCommands in order and
+   * return the result of the build as TryCompile would.
+   */
+  int RunDirectCommands(std::vector<std::vector<std::string> > const& cmds,
+                        std::string& output);
+
+  /**
+   * Compute the text of the key of a source file signature try_compile
+   * in the result cache named by CMAKE_TRY_COMPILE_CACHE_DIR.  The text
+   * covers the generated project, the cmake flags and the identity of
+   * the compilers and toolchain file.
+   */
+  std::string ComputeCacheKey(std::vector<std::string> const& cmakeFlags,
+                              std::set<std::string> const& langs,
+                              std::string const& targetName);
+
+  /**
+   * Add the current text of the sources to a key computed by
+   * ComputeCacheKey and return the name of its cache entry.
+   */
+  std::string HashCacheKey(std::string key,
+                           std::vector<std::string> const& sources);
+
+  /**
+   * Load the result of a try_compile from a cache entry and put the
+   * executable it built, if any, where FindOutputFile looks for it.
+   */
+  bool LoadCachedResult(std::string const& entry,
+                        std::string const& targetName,
+                        int& res, std::string& output);
+
+  /**
+   * Store the result of a try_compile in a cache entry.
+   */
+  void StoreCachedResult(std::string const& entry,
+                         std::string const& targetName,
+                         int res, std::string const& output);
+
 
   cmTypeMacro(cmCoreTryCompile, cmCommand);
 
@@ -53,6 +150,7 @@ public:
   std::string OutputFile;
   std::string FindErrorMessage;
   bool SrcFileSignature;
+  bool Queued;
 
 };
 
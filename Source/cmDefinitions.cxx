@@ -49,7 +49,7 @@ cmDefinitions::GetInternal(const std::string& key)
 cmDefinitions::Def const&
 cmDefinitions::SetInternal(const std::string& key, Def const& def)
 {
-  if(this->Up || def.Exists)
+  if(this->Up || def.Exists())
     {
     // In lower scopes we store keys, defined or not.
     return (this->Map[key] = def);
@@ -66,14 +66,14 @@ cmDefinitions::SetInternal(const std::string& key, Def const& def)
 const char* cmDefinitions::Get(const std::string& key)
 {
   Def const& def = this->GetInternal(key);
-  return def.Exists? def.c_str() : 0;
+  return def.Exists()? def.c_str() : 0;
 }
 
 //----------------------------------------------------------------------------
 const char* cmDefinitions::Set(const std::string& key, const char* value)
 {
   Def const& def = this->SetInternal(key, Def(value));
-  return def.Exists? def.c_str() : 0;
+  return def.Exists()? def.c_str() : 0;
 }
 
 //----------------------------------------------------------------------------
@@ -84,7 +84,7 @@ std::set<std::string> cmDefinitions::LocalKeys() const
   for(MapType::const_iterator mi = this->Map.begin();
       mi != this->Map.end(); ++mi)
     {
-    if (mi->second.Exists)
+    if (mi->second.Exists())
       {
       keys.insert(mi->first);
       }
@@ -118,7 +118,7 @@ void cmDefinitions::ClosureImpl(std::set<std::string>& undefined,
     if(this->Map.find(mi->first) == this->Map.end() &&
        undefined.find(mi->first) == undefined.end())
       {
-      if(mi->second.Exists)
+      if(mi->second.Exists())
         {
         this->Map.insert(*mi);
         }
@@ -157,7 +157,7 @@ void cmDefinitions::ClosureKeys(std::set<std::string>& defined,
     if(defined.find(mi->first) == defined.end() &&
        undefined.find(mi->first) == undefined.end())
       {
-      std::set<std::string>& m = mi->second.Exists? defined : undefined;
+      std::set<std::string>& m = mi->second.Exists()? defined : undefined;
       m.insert(mi->first);
       }
     }
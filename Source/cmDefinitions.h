@@ -22,7 +22,9 @@
  *
  * This stores the state of variable definitions (set or unset) for
  * one scope.  Sets are always local.  Gets search parent scopes
- * transitively and save results locally.
+ * transitively and save results locally.  Values are immutable and
+ * shared by reference between all scopes holding them, so saving a
+ * result locally or flattening a scope does not copy any value.
  */
 class cmDefinitions
 {
@@ -54,17 +56,43 @@ public:
   std::set<std::string> ClosureKeys() const;
 
 private:
-  // String with existence boolean.
-  struct Def: public std::string
+  // Shared string value with existence boolean.
+  class Def
   {
-  private:
-    typedef std::string std_string;
   public:
-    Def(): std_string(), Exists(false) {}
-    Def(const char* v): std_string(v?v:""), Exists(v?true:false) {}
-    Def(const std_string& v): std_string(v), Exists(true) {}
-    Def(Def const& d): std_string(d), Exists(d.Exists) {}
-    bool Exists;
+    Def(): Value(0) {}
+    Def(const char* v): Value(v? new Rep(v) : 0) {}
+    Def(Def const& d): Value(d.Value) { this->Acquire(); }
+    ~Def() { this->Release(); }
+    Def& operator=(Def const& d)
+      {
+      if(this->Value != d.Value)
+        {
+        this->Release();
+        this->Value = d.Value;
+        this->Acquire();
+        }
+      return *this;
+      }
+    bool Exists() const { return this->Value != 0; }
+    const char* c_str() const { return this->Value->Value.c_str(); }
+  private:
+    // Reference-counted immutable representation.
+    struct Rep
+    {
+      Rep(const char* v): Count(1), Value(v) {}
+      unsigned int Count;
+      std::string Value;
+    };
+    Rep* Value;
+    void Acquire() { if(this->Value) { ++this->Value->Count; } }
+    void Release()
+      {
+      if(this->Value && --this->Value->Count == 0)
+        {
+        delete this->Value;
+        }
+      }
   };
   static Def NoDef;
 
@@ -11,13 +11,19 @@
 ============================================================================*/
 #include "cmDependsC.h"
 
-#include "cmFileTimeComparison.h"
 #include "cmLocalGenerator.h"
 #include "cmMakefile.h"
 #include "cmSystemTools.h"
+#include "cmake.h"
 #include <cmsys/FStream.hxx>
 
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+# include "cmFileLock.h"
+# include "cmFileLockResult.h"
+#endif
+
 #include <ctype.h> // isspace
+#include <stdio.h> // sprintf
 
 
 #define INCLUDE_REGEX_LINE \
@@ -28,9 +34,119 @@
 #define INCLUDE_REGEX_COMPLAIN_MARKER "#IncludeRegexComplain: "
 #define INCLUDE_REGEX_TRANSFORM_MARKER "#IncludeRegexTransform: "
 
+#define INCLUDE_CACHE_MAGIC "CMakeIncludeCache 2\n"
+
+//----------------------------------------------------------------------------
+static unsigned long cmDependsCHashString(std::string const& str)
+{
+  // 32-bit FNV-1a hash.
+  unsigned long h = 2166136261UL;
+  for(std::string::const_iterator c = str.begin(); c != str.end(); ++c)
+    {
+    h ^= static_cast<unsigned char>(*c);
+    h = (h * 16777619UL) & 0xFFFFFFFFUL;
+    }
+  return h;
+}
+
+//----------------------------------------------------------------------------
+// The include cache file stores integers as 8 little-endian bytes and
+// strings as their length followed by their characters.  After the
+// header come blocks of records, each preceded by its size in bytes.
+// Blocks are only ever appended, and a record replaces the records of
+// the same file found in earlier blocks.
+static void cmDependsCWriteNumber(std::string& out, unsigned long value)
+{
+  for(int i = 0; i < 8; ++i)
+    {
+    out += static_cast<char>(value & 0xFF);
+    value >>= 8;
+    }
+}
+
+static void cmDependsCWriteString(std::string& out, std::string const& str)
+{
+  cmDependsCWriteNumber(out, static_cast<unsigned long>(str.size()));
+  out += str;
+}
+
+static bool cmDependsCReadNumber(const char*& pos, const char* end,
+                                 unsigned long& value)
+{
+  if(end - pos < 8)
+    {
+    return false;
+    }
+  value = 0;
+  for(int i = 7; i >= 0; --i)
+    {
+    value = (value << 8) | static_cast<unsigned char>(pos[i]);
+    }
+  pos += 8;
+  return true;
+}
+
+static bool cmDependsCReadString(const char*& pos, const char* end,
+                                 std::string& str)
+{
+  unsigned long size;
+  if(!cmDependsCReadNumber(pos, end, size) ||
+     static_cast<unsigned long>(end - pos) < size)
+    {
+    return false;
+    }
+  str.assign(pos, size);
+  pos += size;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Check that a cache file has the given key and ends with a complete
+// block, and count the records in it, without reading the records.
+static bool cmDependsCCheckCacheFile(std::string const& fileName,
+                                     std::string const& key,
+                                     unsigned long& records)
+{
+  records = 0;
+  std::string header = INCLUDE_CACHE_MAGIC;
+  cmDependsCWriteString(header, key);
+  unsigned long length = cmSystemTools::FileLength(fileName);
+  if(length < header.size())
+    {
+    return false;
+    }
+  cmsys::ifstream fin(fileName.c_str(), std::ios::in | std::ios::binary);
+  std::string buf(header.size(), '\0');
+  if(!fin || !fin.read(&buf[0], static_cast<std::streamsize>(buf.size())) ||
+     buf != header)
+    {
+    return false;
+    }
+  unsigned long offset = static_cast<unsigned long>(header.size());
+  while(offset < length)
+    {
+    char numbers[16];
+    unsigned long size;
+    unsigned long count;
+    const char* pos = numbers;
+    if(length - offset < 16 || !fin.read(numbers, 16) ||
+       !cmDependsCReadNumber(pos, numbers + 16, size) ||
+       !cmDependsCReadNumber(pos, numbers + 16, count) ||
+       size < 8 || length - offset - 8 < size)
+      {
+      return false;
+      }
+    offset += 8 + size;
+    records += count;
+    fin.seekg(static_cast<std::streamoff>(size - 8), std::ios::cur);
+    }
+  return true;
+}
+
 //----------------------------------------------------------------------------
 cmDependsC::cmDependsC()
 : ValidDeps(0)
+, CacheModified(false)
 {
 }
 
@@ -41,6 +157,7 @@ cmDependsC::cmDependsC(cmLocalGenerator* lg,
                    const std::map<std::string, DependencyVector>* validDeps)
 : cmDepends(lg, targetDir)
 , ValidDeps(validDeps)
+, CacheModified(false)
 {
   cmMakefile* mf = lg->GetMakefile();
 
@@ -78,10 +195,21 @@ cmDependsC::cmDependsC(cmLocalGenerator* lg,
 
   this->SetupTransforms();
 
-  this->CacheFileName = this->TargetDirectory;
-  this->CacheFileName += "/";
-  this->CacheFileName += lang;
-  this->CacheFileName += ".includecache";
+  // The include lines recorded for a file depend only on the
+  // expressions selecting and transforming them.  All targets scanning
+  // with the same expressions share one cache file in the build tree.
+  this->CacheKey = this->IncludeRegexLineString;
+  this->CacheKey += "\n";
+  this->CacheKey += this->IncludeRegexScanString;
+  this->CacheKey += "\n";
+  this->CacheKey += this->IncludeRegexTransformString;
+  char hash[16];
+  sprintf(hash, "%08lx", cmDependsCHashString(this->CacheKey));
+  this->CacheFileName = mf->GetHomeOutputDirectory();
+  this->CacheFileName += cmake::GetCMakeFilesDirectory();
+  this->CacheFileName += "/CMakeIncludeCache-";
+  this->CacheFileName += hash;
+  this->CacheFileName += ".bin";
 
   this->ReadCacheFile();
 }
@@ -158,13 +286,13 @@ bool cmDependsC::WriteDependencies(const std::set<std::string>& sources,
       if((srcFiles>0)
          || cmSystemTools::FileIsFullPath(current.FileName.c_str()))
         {
-        if(cmSystemTools::FileExists(current.FileName.c_str(), true))
+        if(this->FileExists(current.FileName))
           {
           fullName = current.FileName;
           }
         }
       else if(!current.QuotedLocation.empty() &&
-              cmSystemTools::FileExists(current.QuotedLocation.c_str(), true))
+              this->FileExists(current.QuotedLocation))
         {
         // The include statement producing this entry was a double-quote
         // include and the included file is present in the directory of
@@ -179,22 +307,28 @@ bool cmDependsC::WriteDependencies(const std::set<std::string>& sources,
           {
           fullName=headerLocationIt->second;
           }
-        else for(std::vector<std::string>::const_iterator i =
-              this->IncludePath.begin(); i != this->IncludePath.end(); ++i)
+        else
           {
-          // Construct the name of the file as if it were in the current
-          // include directory.  Avoid using a leading "./".
+          for(std::vector<std::string>::const_iterator i =
+                this->IncludePath.begin(); i != this->IncludePath.end(); ++i)
+            {
+            // Construct the name of the file as if it were in the current
+            // include directory.  Avoid using a leading "./".
 
-          tempPathStr =
-            cmSystemTools::CollapseCombinedPath(*i, current.FileName);
+            tempPathStr =
+              cmSystemTools::CollapseCombinedPath(*i, current.FileName);
 
-          // Look for the file in this location.
-          if(cmSystemTools::FileExists(tempPathStr.c_str(), true))
-            {
-            fullName = tempPathStr;
-            HeaderLocationCache[current.FileName]=fullName;
-            break;
+            // Look for the file in this location.
+            if(this->FileExists(tempPathStr))
+              {
+              fullName = tempPathStr;
+              break;
+              }
             }
+
+          // Remember the result even if the file was not found so that
+          // other sources including it do not search the path again.
+          this->HeaderLocationCache[current.FileName]=fullName;
           }
         }
 
@@ -217,9 +351,15 @@ bool cmDependsC::WriteDependencies(const std::set<std::string>& sources,
         // Check whether this file is already in the cache
         std::map<std::string, cmIncludeLines*>::iterator fileIt=
           this->FileCache.find(fullName);
+        if (fileIt!=this->FileCache.end() && !fileIt->second->Checked &&
+            !this->CheckCacheEntry(fullName, *fileIt->second))
+          {
+          delete fileIt->second;
+          this->FileCache.erase(fileIt);
+          fileIt=this->FileCache.end();
+          }
         if (fileIt!=this->FileCache.end())
           {
-          fileIt->second->Used=true;
           dependencies.insert(fullName);
           for (std::vector<UnscannedEntry>::const_iterator incIt=
                 fileIt->second->UnscannedEntries.begin();
@@ -289,131 +429,241 @@ void cmDependsC::ReadCacheFile()
     {
     return;
     }
-  cmsys::ifstream fin(this->CacheFileName.c_str());
+  cmsys::ifstream fin(this->CacheFileName.c_str(),
+                      std::ios::in | std::ios::binary);
   if(!fin)
     {
     return;
     }
 
-  std::string line;
-  cmIncludeLines* cacheEntry=0;
-  bool haveFileName=false;
+  // Read the whole file at once and decode it from memory.
+  std::ostringstream contents;
+  contents << fin.rdbuf();
+  std::string const& data = contents.str();
+  const char* pos = data.c_str();
+  const char* end = pos + data.size();
+
+  // Reject files of another format or for other regular expressions.
+  std::string magic = INCLUDE_CACHE_MAGIC;
+  std::string key;
+  if(data.compare(0, magic.size(), magic) != 0)
+    {
+    return;
+    }
+  pos += magic.size();
+  if(!cmDependsCReadString(pos, end, key) || key != this->CacheKey)
+    {
+    return;
+    }
 
-  while(cmSystemTools::GetLineFromStream(fin, line))
+  // Entries are checked against the files they describe only when
+  // they are used.  A block still being appended by another target is
+  // incomplete and ignored.
+  std::string fileName;
+  unsigned long blockSize;
+  while(cmDependsCReadNumber(pos, end, blockSize) &&
+        static_cast<unsigned long>(end - pos) >= blockSize)
     {
-    if (line.empty())
+    const char* blockEnd = pos + blockSize;
+    unsigned long count;
+    if(!cmDependsCReadNumber(pos, blockEnd, count))
       {
-      cacheEntry=0;
-      haveFileName=false;
-      continue;
+      return;
       }
-    //the first line after an empty line is the name of the parsed file
-    if (haveFileName==false)
+    for(unsigned long i = 0; i < count; ++i)
       {
-      haveFileName=true;
-      int newer=0;
-      cmFileTimeComparison comp;
-      bool res=comp.FileTimeCompare(this->CacheFileName.c_str(),
-                                    line.c_str(), &newer);
-
-      if ((res==true) && (newer==1)) //cache is newer than the parsed file
+      unsigned long mtime;
+      unsigned long size;
+      unsigned long lines;
+      if(!cmDependsCReadString(pos, blockEnd, fileName) ||
+         !cmDependsCReadNumber(pos, blockEnd, mtime) ||
+         !cmDependsCReadNumber(pos, blockEnd, size) ||
+         !cmDependsCReadNumber(pos, blockEnd, lines))
         {
-        cacheEntry=new cmIncludeLines;
-        this->FileCache[line]=cacheEntry;
+        return;
         }
-      // file doesn't exist, check that the regular expressions
-      // haven't changed
-      else if (res==false)
+      cmIncludeLines* entry = new cmIncludeLines;
+      entry->ModifiedTime = static_cast<long int>(mtime);
+      entry->Size = size;
+      entry->Stored = true;
+      for(unsigned long j = 0; j < lines; ++j)
         {
-        if (line.find(INCLUDE_REGEX_LINE_MARKER) == 0)
-          {
-          if (line != this->IncludeRegexLineString)
-            {
-            return;
-            }
-          }
-        else if (line.find(INCLUDE_REGEX_SCAN_MARKER) == 0)
+        UnscannedEntry line;
+        if(!cmDependsCReadString(pos, blockEnd, line.FileName) ||
+           !cmDependsCReadString(pos, blockEnd, line.QuotedLocation))
           {
-          if (line != this->IncludeRegexScanString)
-            {
-            return;
-            }
-          }
-        else if (line.find(INCLUDE_REGEX_COMPLAIN_MARKER) == 0)
-          {
-          if (line != this->IncludeRegexComplainString)
-            {
-            return;
-            }
-          }
-        else if (line.find(INCLUDE_REGEX_TRANSFORM_MARKER) == 0)
-          {
-          if (line != this->IncludeRegexTransformString)
-            {
-            return;
-            }
+          delete entry;
+          return;
           }
+        entry->UnscannedEntries.push_back(line);
         }
-      }
-    else if (cacheEntry!=0)
-      {
-      UnscannedEntry entry;
-      entry.FileName = line;
-      if (cmSystemTools::GetLineFromStream(fin, line))
+      // Entries checked by this instance are more recent than any
+      // record in the file.
+      cmIncludeLines*& e = this->FileCache[fileName];
+      if(e && e->Checked)
         {
-        if (line!="-")
-          {
-          entry.QuotedLocation=line;
-          }
-        cacheEntry->UnscannedEntries.push_back(entry);
+        delete entry;
+        continue;
         }
+      delete e;
+      e = entry;
       }
+    pos = blockEnd;
     }
 }
 
 //----------------------------------------------------------------------------
-void cmDependsC::WriteCacheFile() const
+void cmDependsC::WriteCacheFile()
 {
-  if(this->CacheFileName.empty())
+  if(this->CacheFileName.empty() || !this->CacheModified)
     {
     return;
     }
-  cmsys::ofstream cacheOut(this->CacheFileName.c_str());
+
+  // Other targets may be scanned concurrently.  Take turns updating
+  // the file, but go without the cache rather than wait for long.
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  std::string lockFile = this->CacheFileName + ".lock";
+  cmSystemTools::Touch(lockFile, true);
+  cmFileLock lock;
+  if(!lock.Lock(lockFile, 10).IsOk())
+    {
+    return;
+    }
+#else
+  // The bootstrap build cannot lock files.
+  return;
+#endif
+
+  // Usually the entries scanned by this target are appended to the
+  // file.  Rewrite it from the merged entries of all targets when it
+  // is damaged or holds more replaced records than current ones.
+  unsigned long records = 0;
+  bool valid = cmDependsCCheckCacheFile(this->CacheFileName,
+                                        this->CacheKey, records);
+  std::string block;
+  unsigned long count = this->WriteCacheEntries(block, false);
+  if(count == 0)
+    {
+    return;
+    }
+  if(valid && records + count <= 2 * this->FileCache.size())
+    {
+    std::string data;
+    cmDependsCWriteNumber(data, static_cast<unsigned long>(block.size()));
+    data += block;
+    cmsys::ofstream cacheOut(this->CacheFileName.c_str(),
+                             std::ios::out | std::ios::app |
+                             std::ios::binary);
+    cacheOut.write(data.c_str(), static_cast<std::streamsize>(data.size()));
+    return;
+    }
+  if(valid)
+    {
+    this->ReadCacheFile();
+    }
+  block = "";
+  this->WriteCacheEntries(block, true);
+  std::string data = INCLUDE_CACHE_MAGIC;
+  cmDependsCWriteString(data, this->CacheKey);
+  cmDependsCWriteNumber(data, static_cast<unsigned long>(block.size()));
+  data += block;
+
+  // Write a temporary file and move it into place so that readers
+  // never see a partial file.
+  char suffix[32];
+  sprintf(suffix, ".%08x.tmp", cmSystemTools::RandomSeed());
+  std::string tmpFile = this->CacheFileName + suffix;
+  {
+  cmsys::ofstream cacheOut(tmpFile.c_str(),
+                           std::ios::out | std::ios::binary);
   if(!cacheOut)
     {
     return;
     }
+  cacheOut.write(data.c_str(), static_cast<std::streamsize>(data.size()));
+  if(!cacheOut)
+    {
+    cacheOut.close();
+    cmSystemTools::RemoveFile(tmpFile);
+    return;
+    }
+  }
+  if(!cmSystemTools::RenameFile(tmpFile.c_str(),
+                                this->CacheFileName.c_str()))
+    {
+    cmSystemTools::RemoveFile(tmpFile);
+    }
+}
 
-  cacheOut << this->IncludeRegexLineString << "\n\n";
-  cacheOut << this->IncludeRegexScanString << "\n\n";
-  cacheOut << this->IncludeRegexComplainString << "\n\n";
-  cacheOut << this->IncludeRegexTransformString << "\n\n";
-
+//----------------------------------------------------------------------------
+unsigned long cmDependsC::WriteCacheEntries(std::string& block, bool all)
+{
+  std::string entries;
+  unsigned long count = 0;
   for (std::map<std::string, cmIncludeLines*>::const_iterator fileIt=
          this->FileCache.begin();
        fileIt!=this->FileCache.end(); ++fileIt)
     {
-    if (fileIt->second->Used)
+    cmIncludeLines const* e = fileIt->second;
+    if((!all && e->Stored) || e->ModifiedTime == 0 ||
+       !cmSystemTools::IsModifiedTimeSettled(e->ModifiedTime))
       {
-      cacheOut<<fileIt->first.c_str()<<std::endl;
-
-      for (std::vector<UnscannedEntry>::const_iterator
-             incIt=fileIt->second->UnscannedEntries.begin();
-           incIt!=fileIt->second->UnscannedEntries.end(); ++incIt)
-        {
-        cacheOut<<incIt->FileName.c_str()<<std::endl;
-        if (incIt->QuotedLocation.empty())
-          {
-          cacheOut<<"-"<<std::endl;
-          }
-        else
-          {
-          cacheOut<<incIt->QuotedLocation.c_str()<<std::endl;
-          }
-        }
-      cacheOut<<std::endl;
+      continue;
+      }
+    // Drop entries of files that were renamed or removed.
+    if(!e->Checked && !cmSystemTools::FileExists(fileIt->first.c_str(), true))
+      {
+      continue;
       }
-   }
+    cmDependsCWriteString(entries, fileIt->first);
+    cmDependsCWriteNumber(entries,
+                          static_cast<unsigned long>(e->ModifiedTime));
+    cmDependsCWriteNumber(entries, e->Size);
+    cmDependsCWriteNumber(entries,
+      static_cast<unsigned long>(e->UnscannedEntries.size()));
+    for (std::vector<UnscannedEntry>::const_iterator
+           incIt=e->UnscannedEntries.begin();
+         incIt!=e->UnscannedEntries.end(); ++incIt)
+      {
+      cmDependsCWriteString(entries, incIt->FileName);
+      cmDependsCWriteString(entries, incIt->QuotedLocation);
+      }
+    ++count;
+    }
+  cmDependsCWriteNumber(block, count);
+  block += entries;
+  return count;
+}
+
+//----------------------------------------------------------------------------
+bool cmDependsC::CheckCacheEntry(std::string const& fullName,
+                                 cmIncludeLines& entry)
+{
+  // A cached entry is valid while the file keeps its time and size.
+  entry.Checked = true;
+  if(cmSystemTools::ModifiedTime(fullName) == entry.ModifiedTime &&
+     cmSystemTools::FileLength(fullName) == entry.Size)
+    {
+    return true;
+    }
+  this->CacheModified = true;
+  return false;
+}
+
+//----------------------------------------------------------------------------
+bool cmDependsC::FileExists(std::string const& path)
+{
+  // Many sources include the same headers.  Check each location once.
+  std::map<std::string, bool>::iterator i =
+    this->FileExistsCache.find(path);
+  if(i == this->FileExistsCache.end())
+    {
+    bool exists = cmSystemTools::FileExists(path.c_str(), true);
+    i = this->FileExistsCache.insert(
+      std::map<std::string, bool>::value_type(path, exists)).first;
+    }
+  return i->second;
 }
 
 //----------------------------------------------------------------------------
@@ -421,8 +671,11 @@ void cmDependsC::Scan(std::istream& is, const char* directory,
   const std::string& fullName)
 {
   cmIncludeLines* newCacheEntry=new cmIncludeLines;
-  newCacheEntry->Used=true;
+  newCacheEntry->ModifiedTime=cmSystemTools::ModifiedTime(fullName);
+  newCacheEntry->Size=cmSystemTools::FileLength(fullName);
+  newCacheEntry->Checked=true;
   this->FileCache[fullName]=newCacheEntry;
+  this->CacheModified=true;
 
   // Read one line at a time.
   std::string line;
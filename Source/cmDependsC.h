@@ -73,9 +73,13 @@ public:
 
   struct cmIncludeLines
   {
-    cmIncludeLines(): Used(false) {}
+    cmIncludeLines(): ModifiedTime(0), Size(0), Checked(false),
+                      Stored(false) {}
     std::vector<UnscannedEntry> UnscannedEntries;
-    bool Used;
+    long int ModifiedTime;
+    unsigned long Size;
+    bool Checked;
+    bool Stored;
   };
 protected:
   const std::map<std::string, DependencyVector>* ValidDeps;
@@ -84,11 +88,21 @@ protected:
 
   std::map<std::string, cmIncludeLines *> FileCache;
   std::map<std::string, std::string> HeaderLocationCache;
+  std::map<std::string, bool> FileExistsCache;
 
+  // The include cache is shared by all targets of the build tree that
+  // scan with the same regular expressions and transforms.
   std::string CacheFileName;
+  std::string CacheKey;
+  bool CacheModified;
 
-  void WriteCacheFile() const;
+  void WriteCacheFile();
   void ReadCacheFile();
+  unsigned long WriteCacheEntries(std::string& block, bool all);
+  bool CheckCacheEntry(std::string const& fullName, cmIncludeLines& entry);
+
+  // Check whether a file exists, probing each path only once.
+  bool FileExists(std::string const& path);
 private:
   cmDependsC(cmDependsC const&); // Purposely not implemented.
   void operator=(cmDependsC const&); // Purposely not implemented.
@@ -131,6 +131,43 @@ bool cmFileTimeComparison::FileTimesDiffer(const char* f1, const char* f2)
   return this->Internals->FileTimesDiffer(f1, f2);
 }
 
+//----------------------------------------------------------------------------
+bool cmFileTimeComparison::GetFileTimeAndSize(const char* fname,
+                                              cmIML_INT_int64_t* time,
+                                              cmIML_INT_int64_t* size)
+{
+#if !defined(_WIN32) || defined(__CYGWIN__)
+  struct stat st;
+  if(::stat(fname, &st) != 0)
+    {
+    return false;
+    }
+# if cmsys_STAT_HAS_ST_MTIM
+  *time = static_cast<cmIML_INT_int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+    st.st_mtim.tv_nsec;
+# else
+  *time = static_cast<cmIML_INT_int64_t>(st.st_mtime);
+# endif
+  *size = static_cast<cmIML_INT_int64_t>(st.st_size);
+#else
+  WIN32_FILE_ATTRIBUTE_DATA fdata;
+  if(!GetFileAttributesExW(cmsys::Encoding::ToWide(fname).c_str(),
+                           GetFileExInfoStandard, &fdata))
+    {
+    return false;
+    }
+  LARGE_INTEGER t;
+  t.LowPart = fdata.ftLastWriteTime.dwLowDateTime;
+  t.HighPart = fdata.ftLastWriteTime.dwHighDateTime;
+  *time = t.QuadPart;
+  LARGE_INTEGER s;
+  s.LowPart = fdata.nFileSizeLow;
+  s.HighPart = fdata.nFileSizeHigh;
+  *size = s.QuadPart;
+#endif
+  return true;
+}
+
 //----------------------------------------------------------------------------
 int cmFileTimeComparisonInternal::Compare(cmFileTimeComparison_Type* s1,
                                           cmFileTimeComparison_Type* s2)
@@ -41,6 +41,14 @@ public:
    */
   bool FileTimesDiffer(const char* f1, const char* f2);
 
+  /**
+   *  Get the modification time of a file, in units of the best
+   *  resolution available, and its size.  Return false if the file
+   *  does not exist.  The result is not cached.
+   */
+  bool GetFileTimeAndSize(const char* f, cmIML_INT_int64_t* time,
+                          cmIML_INT_int64_t* size);
+
 protected:
 
   cmFileTimeComparisonInternal* Internals;
@@ -77,6 +77,10 @@ bool cmFindBase::ParseArguments(std::vector<std::string> const& argsIn)
     }
   this->AlreadyInCache = false;
 
+  // Directories cached before this command may have changed.
+  this->Makefile->GetLocalGenerator()->GetGlobalGenerator()
+    ->CheckDirectoryContentAgain();
+
   // Find the current root path mode.
   this->SelectDefaultRootPathMode();
 
@@ -350,7 +350,8 @@ bool cmFindLibraryHelper::CheckDirectoryForName(std::string const& path,
     {
     this->TestPath = path;
     this->TestPath += name.Raw;
-    if(cmSystemTools::FileExists(this->TestPath.c_str(), true))
+    if(this->GG->FileMayExist(this->TestPath) &&
+       cmSystemTools::FileExists(this->TestPath.c_str(), true))
       {
       this->BestPath =
         cmSystemTools::CollapseFullPath(this->TestPath);
@@ -0,0 +1,287 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2000-2009 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#include "cmFindPackageCache.h"
+
+#include "cmGlobalGenerator.h"
+#include "cmGeneratedFileStream.h"
+#include "cmSystemTools.h"
+
+#include <cmsys/FStream.hxx>
+
+#include <stdlib.h>
+
+//----------------------------------------------------------------------------
+bool cmFindPackageCache::GetVersionResult(std::string const& versionFile,
+                                          std::string const& request,
+                                          VersionResult& result)
+{
+  VersionMapType::const_iterator i =
+    this->Versions.find(std::make_pair(versionFile, request));
+  if(i != this->Versions.end() &&
+     i->second.ModifiedTime == cmSystemTools::ModifiedTime(versionFile) &&
+     i->second.Size == cmSystemTools::FileLength(versionFile))
+    {
+    ++this->Stats.VersionHits;
+    result = i->second.Result;
+    return true;
+    }
+  ++this->Stats.VersionMisses;
+  return false;
+}
+
+//----------------------------------------------------------------------------
+void cmFindPackageCache::StoreVersionResult(std::string const& versionFile,
+                                            std::string const& request,
+                                            VersionResult const& result)
+{
+  std::pair<std::string, std::string> key(versionFile, request);
+  long mtime = cmSystemTools::ModifiedTime(versionFile);
+  if(mtime == 0 || !cmSystemTools::IsModifiedTimeSettled(mtime))
+    {
+    this->Versions.erase(key);
+    return;
+    }
+  VersionEntry& e = this->Versions[key];
+  e.ModifiedTime = mtime;
+  e.Size = cmSystemTools::FileLength(versionFile);
+  e.Result = result;
+}
+
+//----------------------------------------------------------------------------
+bool cmFindPackageCache::IsKnownMissing(cmGlobalGenerator* gg,
+                                        std::string const& request,
+                                        std::vector<ConsideredConfig>& cfgs)
+{
+  // A package may be created in the same second a search for it failed
+  // without a visible change in any time stamp.  Only trust failures
+  // recorded at least one configure ago.
+  MissingMapType::const_iterator i = this->Missing.find(request);
+  if(i == this->Missing.end() || !i->second.Loaded)
+    {
+    ++this->Stats.MissingMisses;
+    return false;
+    }
+  MissingEntry const& e = i->second;
+  for(std::map<std::string, long>::const_iterator
+        di = e.Directories.begin(); di != e.Directories.end(); ++di)
+    {
+    if(gg->GetDirectoryContentTime(di->first) != di->second)
+      {
+      ++this->Stats.MissingMisses;
+      return false;
+      }
+    }
+  for(std::map<std::string, long>::const_iterator
+        fi = e.Files.begin(); fi != e.Files.end(); ++fi)
+    {
+    if(cmSystemTools::ModifiedTime(fi->first) != fi->second)
+      {
+      ++this->Stats.MissingMisses;
+      return false;
+      }
+    }
+  ++this->Stats.MissingHits;
+  cfgs = e.Considered;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void cmFindPackageCache::StoreMissing(std::string const& request,
+                               std::map<std::string, long> const& directories,
+                               std::map<std::string, long> const& files,
+                               std::vector<ConsideredConfig> const& cfgs)
+{
+  // Every time stamp must be trustworthy for the answer to be checked.
+  for(std::map<std::string, long>::const_iterator
+        di = directories.begin(); di != directories.end(); ++di)
+    {
+    if(!cmSystemTools::IsModifiedTimeSettled(di->second))
+      {
+      this->Missing.erase(request);
+      return;
+      }
+    }
+  for(std::map<std::string, long>::const_iterator
+        fi = files.begin(); fi != files.end(); ++fi)
+    {
+    if(fi->second == 0 || !cmSystemTools::IsModifiedTimeSettled(fi->second))
+      {
+      this->Missing.erase(request);
+      return;
+      }
+    }
+  MissingEntry& e = this->Missing[request];
+  e.Loaded = false;
+  e.Directories = directories;
+  e.Files = files;
+  e.Considered = cfgs;
+}
+
+//----------------------------------------------------------------------------
+void cmFindPackageCache::ForgetMissing(std::string const& request)
+{
+  this->Missing.erase(request);
+}
+
+//----------------------------------------------------------------------------
+void cmFindPackageCache::Load(std::string const& fname)
+{
+  cmsys::ifstream fin(fname.c_str());
+  if(!fin)
+    {
+    return;
+    }
+
+  // A version file result is written as the lines
+  //   V <mtime> <size> <exact><compatible><unsuitable> <file>
+  //   R <request>
+  //   P <version>
+  // and a failed search as a line "N <request>" followed by lines
+  // "D <mtime> <dir>", "F <mtime> <file>", and "C <file>" each followed
+  // by "c <version>".
+  std::string line;
+  VersionEntry version;
+  std::string versionFile;
+  std::string versionRequest;
+  MissingEntry* missing = 0;
+  while(cmSystemTools::GetLineFromStream(fin, line))
+    {
+    if(line.size() < 2 || line[1] != ' ')
+      {
+      continue;
+      }
+    std::string value = line.substr(2);
+    switch(line[0])
+      {
+      case 'V':
+        {
+        missing = 0;
+        versionFile = "";
+        std::vector<std::string> fields;
+        std::string::size_type pos = 0;
+        for(int f = 0; f < 3 && pos != std::string::npos; ++f)
+          {
+          std::string::size_type end = value.find(' ', pos);
+          fields.push_back(value.substr(pos, end == std::string::npos?
+                                             end : end - pos));
+          pos = end == std::string::npos? end : end + 1;
+          }
+        if(pos == std::string::npos || fields[2].size() != 3)
+          {
+          continue;
+          }
+        version = VersionEntry();
+        version.ModifiedTime = atol(fields[0].c_str());
+        version.Size = strtoul(fields[1].c_str(), 0, 10);
+        version.Result.Exact = fields[2][0] == '1';
+        version.Result.Compatible = fields[2][1] == '1';
+        version.Result.Unsuitable = fields[2][2] == '1';
+        versionFile = value.substr(pos);
+        } break;
+      case 'R':
+        versionRequest = value;
+        break;
+      case 'P':
+        if(!versionFile.empty())
+          {
+          version.Result.Version = value;
+          this->Versions[std::make_pair(versionFile, versionRequest)] =
+            version;
+          versionFile = "";
+          }
+        break;
+      case 'N':
+        versionFile = "";
+        missing = &this->Missing[value];
+        missing->Loaded = true;
+        break;
+      case 'D':
+      case 'F':
+        if(missing)
+          {
+          std::string::size_type pos = value.find(' ');
+          if(pos != std::string::npos)
+            {
+            std::map<std::string, long>& m =
+              line[0] == 'D'? missing->Directories : missing->Files;
+            m[value.substr(pos+1)] = atol(value.substr(0, pos).c_str());
+            }
+          }
+        break;
+      case 'C':
+        if(missing)
+          {
+          ConsideredConfig cfg;
+          cfg.File = value;
+          missing->Considered.push_back(cfg);
+          }
+        break;
+      case 'c':
+        if(missing && !missing->Considered.empty())
+          {
+          missing->Considered.back().Version = value;
+          }
+        break;
+      default:
+        break;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void cmFindPackageCache::Save(std::string const& fname) const
+{
+  cmGeneratedFileStream fout(fname.c_str());
+  fout << "# Results of find_package kept for the next configure.\n";
+  for(VersionMapType::const_iterator vi = this->Versions.begin();
+      vi != this->Versions.end(); ++vi)
+    {
+    VersionResult const& r = vi->second.Result;
+    if(vi->first.first.find('\n') != std::string::npos ||
+       vi->first.second.find('\n') != std::string::npos ||
+       r.Version.find('\n') != std::string::npos)
+      {
+      continue;
+      }
+    fout << "V " << vi->second.ModifiedTime << " " << vi->second.Size << " "
+         << (r.Exact? "1":"0") << (r.Compatible? "1":"0")
+         << (r.Unsuitable? "1":"0") << " " << vi->first.first << "\n";
+    fout << "R " << vi->first.second << "\n";
+    fout << "P " << r.Version << "\n";
+    }
+  for(MissingMapType::const_iterator mi = this->Missing.begin();
+      mi != this->Missing.end(); ++mi)
+    {
+    if(mi->first.find('\n') != std::string::npos)
+      {
+      continue;
+      }
+    fout << "N " << mi->first << "\n";
+    MissingEntry const& e = mi->second;
+    for(std::map<std::string, long>::const_iterator
+          di = e.Directories.begin(); di != e.Directories.end(); ++di)
+      {
+      fout << "D " << di->second << " " << di->first << "\n";
+      }
+    for(std::map<std::string, long>::const_iterator
+          fi = e.Files.begin(); fi != e.Files.end(); ++fi)
+      {
+      fout << "F " << fi->second << " " << fi->first << "\n";
+      }
+    for(std::vector<ConsideredConfig>::const_iterator
+          ci = e.Considered.begin(); ci != e.Considered.end(); ++ci)
+      {
+      fout << "C " << ci->File << "\n";
+      fout << "c " << ci->Version << "\n";
+      }
+    }
+}
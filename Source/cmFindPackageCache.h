@@ -0,0 +1,114 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2000-2009 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#ifndef cmFindPackageCache_h
+#define cmFindPackageCache_h
+
+#include "cmStandardIncludes.h"
+
+class cmGlobalGenerator;
+
+/** \class cmFindPackageCache
+ * \brief Results of find_package kept from one configure to the next.
+ *
+ * cmFindPackageCache remembers the outputs of package version files and
+ * the packages that were searched for without success, together with
+ * the time stamps of the files and directories the answers were derived
+ * from.  A later configure validates an answer by checking these time
+ * stamps instead of repeating the search and the version checks.
+ */
+class cmFindPackageCache
+{
+public:
+  /** Output variables set by a package version file.  */
+  struct VersionResult
+  {
+    VersionResult(): Exact(false), Compatible(false), Unsuitable(false) {}
+    std::string Version;
+    bool Exact;
+    bool Compatible;
+    bool Unsuitable;
+  };
+
+  /** A configuration file that was considered but not accepted.  */
+  struct ConsideredConfig
+  {
+    std::string File;
+    std::string Version;
+  };
+
+  /** Get the result of a version file for the given request, which
+      describes the input variables of the version file.  Returns false
+      if the result is not known or the file changed.  */
+  bool GetVersionResult(std::string const& versionFile,
+                        std::string const& request,
+                        VersionResult& result);
+  void StoreVersionResult(std::string const& versionFile,
+                          std::string const& request,
+                          VersionResult const& result);
+
+  /** Check whether a search described by 'request' failed in the
+      previous configure and none of the directories and files it looked
+      at changed since.  Failures recorded during this configure are not
+      used before the next one.  */
+  bool IsKnownMissing(cmGlobalGenerator* gg, std::string const& request,
+                      std::vector<ConsideredConfig>& considered);
+
+  /** Record that a search failed after looking at the given directories
+      and files with the given modification times.  */
+  void StoreMissing(std::string const& request,
+                    std::map<std::string, long> const& directories,
+                    std::map<std::string, long> const& files,
+                    std::vector<ConsideredConfig> const& considered);
+  void ForgetMissing(std::string const& request);
+
+  void Load(std::string const& fname);
+  void Save(std::string const& fname) const;
+
+  /** Counters describing how often a cached answer was used.  */
+  struct Statistics
+  {
+    Statistics(): VersionHits(0), VersionMisses(0),
+                  MissingHits(0), MissingMisses(0) {}
+    unsigned long VersionHits;
+    unsigned long VersionMisses;
+    unsigned long MissingHits;
+    unsigned long MissingMisses;
+  };
+  Statistics const& GetStatistics() const { return this->Stats; }
+
+private:
+  struct VersionEntry
+  {
+    VersionEntry(): ModifiedTime(0), Size(0) {}
+    long ModifiedTime;
+    unsigned long Size;
+    VersionResult Result;
+  };
+  typedef std::map<std::pair<std::string, std::string>, VersionEntry>
+    VersionMapType;
+  VersionMapType Versions;
+
+  struct MissingEntry
+  {
+    MissingEntry(): Loaded(false) {}
+    bool Loaded;
+    std::map<std::string, long> Directories;
+    std::map<std::string, long> Files;
+    std::vector<ConsideredConfig> Considered;
+  };
+  typedef std::map<std::string, MissingEntry> MissingMapType;
+  MissingMapType Missing;
+
+  Statistics Stats;
+};
+
+#endif
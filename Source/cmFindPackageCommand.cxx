@@ -45,6 +45,7 @@ cmFindPackageCommand::cmFindPackageCommand()
   this->UseConfigFiles = true;
   this->UseFindModules = true;
   this->DebugMode = false;
+  this->SearchedFiles = 0;
   this->UseLib64Paths = false;
   this->PolicyScope = true;
   this->VersionMajor = 0;
@@ -639,6 +640,10 @@ bool cmFindPackageCommand::HandlePackageMode()
 {
   this->ConsideredConfigs.clear();
 
+  // Directories cached before this command may have changed.
+  this->Makefile->GetLocalGenerator()->GetGlobalGenerator()
+    ->CheckDirectoryContentAgain();
+
   // Support old capitalization behavior.
   std::string upperDir = cmSystemTools::UpperCase(this->Name);
   std::string upperFound = cmSystemTools::UpperCase(this->Name);
@@ -897,6 +902,46 @@ bool cmFindPackageCommand::FindConfig()
   // Compute the set of search prefixes.
   this->ComputePrefixes();
 
+  // A search that failed before is not repeated if none of the
+  // directories and version files it looked at changed.  Frameworks and
+  // application bundles are searched without the directory content
+  // cache so their searches are always repeated.
+  cmGlobalGenerator* gg =
+    this->Makefile->GetLocalGenerator()->GetGlobalGenerator();
+  cmFindPackageCache* cache = gg->GetFindPackageCache();
+  bool useCache = !this->DebugMode &&
+    !this->SearchFrameworkFirst && !this->SearchFrameworkOnly &&
+    !this->SearchFrameworkLast && !this->SearchAppBundleFirst &&
+    !this->SearchAppBundleOnly && !this->SearchAppBundleLast;
+  std::string request;
+  std::vector<ConfigFileInfo>::size_type consideredBefore =
+    this->ConsideredConfigs.size();
+  std::map<std::string, long> searchedDirectories;
+  std::map<std::string, long> searchedFiles;
+  if(useCache)
+    {
+    request = this->GetSearchRequest();
+    std::vector<cmFindPackageCache::ConsideredConfig> considered;
+    if(cache->IsKnownMissing(gg, request, considered))
+      {
+      for(std::vector<cmFindPackageCache::ConsideredConfig>::const_iterator
+            ci = considered.begin(); ci != considered.end(); ++ci)
+        {
+        ConfigFileInfo configFileInfo;
+        configFileInfo.filename = ci->File;
+        configFileInfo.version = ci->Version;
+        this->ConsideredConfigs.push_back(configFileInfo);
+        }
+      this->Makefile->AddCacheDefinition(this->Variable,
+                                         (this->Variable + "-NOTFOUND").c_str(),
+                                         this->GetVariableHelp().c_str(),
+                                         cmCacheManager::PATH, true);
+      return false;
+      }
+    gg->SetDirectoryContentRecord(&searchedDirectories);
+    this->SearchedFiles = &searchedFiles;
+    }
+
   // Look for the project's configuration file.
   bool found = false;
 
@@ -930,6 +975,31 @@ bool cmFindPackageCommand::FindConfig()
     found = this->FindAppBundleConfig();
     }
 
+  if(useCache)
+    {
+    gg->SetDirectoryContentRecord(0);
+    this->SearchedFiles = 0;
+    if(found)
+      {
+      cache->ForgetMissing(request);
+      }
+    else
+      {
+      std::vector<cmFindPackageCache::ConsideredConfig> considered;
+      for(std::vector<ConfigFileInfo>::const_iterator
+            ci = this->ConsideredConfigs.begin() + consideredBefore;
+          ci != this->ConsideredConfigs.end(); ++ci)
+        {
+        cmFindPackageCache::ConsideredConfig cfg;
+        cfg.File = ci->filename;
+        cfg.Version = ci->version;
+        considered.push_back(cfg);
+        }
+      cache->StoreMissing(request, searchedDirectories, searchedFiles,
+                          considered);
+      }
+    }
+
   // Store the entry in the cache so it can be set by the user.
   std::string init;
   if(found)
@@ -940,17 +1010,58 @@ bool cmFindPackageCommand::FindConfig()
     {
     init = this->Variable + "-NOTFOUND";
     }
-  std::string help =
-    "The directory containing a CMake configuration file for ";
-  help += this->Name;
-  help += ".";
   // We force the value since we do not get here if it was already set.
   this->Makefile->AddCacheDefinition(this->Variable,
-                                     init.c_str(), help.c_str(),
+                                     init.c_str(),
+                                     this->GetVariableHelp().c_str(),
                                      cmCacheManager::PATH, true);
   return found;
 }
 
+//----------------------------------------------------------------------------
+std::string cmFindPackageCommand::GetVariableHelp() const
+{
+  std::string help =
+    "The directory containing a CMake configuration file for ";
+  help += this->Name;
+  help += ".";
+  return help;
+}
+
+//----------------------------------------------------------------------------
+std::string cmFindPackageCommand::GetSearchRequest() const
+{
+  // Describe everything that determines the outcome of the search
+  // other than the content of the searched directories.
+  std::ostringstream request;
+  request << this->GetVersionRequest()
+          << "\t" << (this->VersionExact? "EXACT" : "")
+          << "\t" << cmJoin(this->Names, ";")
+          << "\t" << cmJoin(this->Configs, ";")
+          << "\t" << cmJoin(this->SearchPathSuffixes, ";")
+          << "\t" << cmJoin(this->SearchPaths, ";")
+          << "\t" << cmJoin(this->IgnoredPaths, ";")
+          << "\t" << this->LibraryArchitecture
+          << "\t" << (this->UseLib64Paths? "lib64" : "");
+  return request.str();
+}
+
+//----------------------------------------------------------------------------
+std::string cmFindPackageCommand::GetVersionRequest() const
+{
+  // Version files see only the requested version and, by convention,
+  // the size of a pointer on the target architecture.  The result is
+  // cached per version file and checked against its time and size.
+  std::string request = this->Name;
+  request += "\t";
+  request += this->Version;
+  request += "\t";
+  request += this->VersionExact? "EXACT" : "";
+  request += "\t";
+  request += this->Makefile->GetSafeDefinition("CMAKE_SIZEOF_VOID_P");
+  return request;
+}
+
 //----------------------------------------------------------------------------
 bool cmFindPackageCommand::FindPrefixedConfig()
 {
@@ -1542,6 +1653,8 @@ bool cmFindPackageCommand::FindConfigFile(std::string const& dir,
     return false;
     }
 
+  cmGlobalGenerator* gg =
+    this->Makefile->GetLocalGenerator()->GetGlobalGenerator();
   for(std::vector<std::string>::const_iterator ci = this->Configs.begin();
       ci != this->Configs.end(); ++ci)
     {
@@ -1552,7 +1665,8 @@ bool cmFindPackageCommand::FindConfigFile(std::string const& dir,
       {
       fprintf(stderr, "Checking file [%s]\n", file.c_str());
       }
-    if(cmSystemTools::FileExists(file.c_str(), true) &&
+    if(gg->FileMayExist(file) &&
+       cmSystemTools::FileExists(file.c_str(), true) &&
        this->CheckVersion(file))
       {
       return true;
@@ -1564,6 +1678,8 @@ bool cmFindPackageCommand::FindConfigFile(std::string const& dir,
 //----------------------------------------------------------------------------
 bool cmFindPackageCommand::CheckVersion(std::string const& config_file)
 {
+  cmGlobalGenerator* gg =
+    this->Makefile->GetLocalGenerator()->GetGlobalGenerator();
   bool result = false; // by default, assume the version is not ok.
   bool haveResult = false;
   std::string version = "unknown";
@@ -1575,7 +1691,7 @@ bool cmFindPackageCommand::CheckVersion(std::string const& config_file)
   // Look for foo-config-version.cmake
   std::string version_file = version_file_base;
   version_file += "-version.cmake";
-  if ((haveResult == false)
+  if ((haveResult == false) && gg->FileMayExist(version_file)
        && (cmSystemTools::FileExists(version_file.c_str(), true)))
     {
     result = this->CheckVersionFile(version_file, version);
@@ -1585,7 +1701,7 @@ bool cmFindPackageCommand::CheckVersion(std::string const& config_file)
   // Look for fooConfigVersion.cmake
   version_file = version_file_base;
   version_file += "Version.cmake";
-  if ((haveResult == false)
+  if ((haveResult == false) && gg->FileMayExist(version_file)
        && (cmSystemTools::FileExists(version_file.c_str(), true)))
     {
     result = this->CheckVersionFile(version_file, version);
@@ -1612,55 +1728,41 @@ bool cmFindPackageCommand::CheckVersion(std::string const& config_file)
 bool cmFindPackageCommand::CheckVersionFile(std::string const& version_file,
                                             std::string& result_version)
 {
-  // The version file will be loaded in an isolated scope.
-  cmMakefile::ScopePushPop varScope(this->Makefile);
-  cmMakefile::PolicyPushPop polScope(this->Makefile);
-  static_cast<void>(varScope);
-  static_cast<void>(polScope);
-
-  // Clear the output variables.
-  this->Makefile->RemoveDefinition("PACKAGE_VERSION");
-  this->Makefile->RemoveDefinition("PACKAGE_VERSION_UNSUITABLE");
-  this->Makefile->RemoveDefinition("PACKAGE_VERSION_COMPATIBLE");
-  this->Makefile->RemoveDefinition("PACKAGE_VERSION_EXACT");
-
-  // Set the input variables.
-  this->Makefile->AddDefinition("PACKAGE_FIND_NAME", this->Name.c_str());
-  this->Makefile->AddDefinition("PACKAGE_FIND_VERSION",
-                                this->Version.c_str());
-  char buf[64];
-  sprintf(buf, "%u", this->VersionMajor);
-  this->Makefile->AddDefinition("PACKAGE_FIND_VERSION_MAJOR", buf);
-  sprintf(buf, "%u", this->VersionMinor);
-  this->Makefile->AddDefinition("PACKAGE_FIND_VERSION_MINOR", buf);
-  sprintf(buf, "%u", this->VersionPatch);
-  this->Makefile->AddDefinition("PACKAGE_FIND_VERSION_PATCH", buf);
-  sprintf(buf, "%u", this->VersionTweak);
-  this->Makefile->AddDefinition("PACKAGE_FIND_VERSION_TWEAK", buf);
-  sprintf(buf, "%u", this->VersionCount);
-  this->Makefile->AddDefinition("PACKAGE_FIND_VERSION_COUNT", buf);
+  // A version file whose result is known for the same request and
+  // which did not change since need not be loaded again.
+  cmFindPackageCache* cache = this->Makefile->GetLocalGenerator()
+    ->GetGlobalGenerator()->GetFindPackageCache();
+  std::string request = this->GetVersionRequest();
+  cmFindPackageCache::VersionResult vr;
+  bool haveResult = cache->GetVersionResult(version_file, request, vr);
+  if(!haveResult && this->ReadVersionFile(version_file, vr))
+    {
+    cache->StoreVersionResult(version_file, request, vr);
+    haveResult = true;
+    }
+  if(this->SearchedFiles)
+    {
+    (*this->SearchedFiles)[version_file] =
+      cmSystemTools::ModifiedTime(version_file);
+    }
 
-  // Load the version check file.  Pass NoPolicyScope because we do
-  // our own policy push/pop independent of CMP0011.
   bool suitable = false;
-  if(this->ReadListFile(version_file.c_str(), NoPolicyScope))
+  if(haveResult)
     {
     // Check the output variables.
-    bool okay = this->Makefile->IsOn("PACKAGE_VERSION_EXACT");
-    bool unsuitable = this->Makefile->IsOn("PACKAGE_VERSION_UNSUITABLE");
+    bool okay = vr.Exact;
     if(!okay && !this->VersionExact)
       {
-      okay = this->Makefile->IsOn("PACKAGE_VERSION_COMPATIBLE");
+      okay = vr.Compatible;
       }
 
     // The package is suitable if the version is okay and not
     // explicitly unsuitable.
-    suitable = !unsuitable && (okay || this->Version.empty());
+    suitable = !vr.Unsuitable && (okay || this->Version.empty());
     if(suitable)
       {
       // Get the version found.
-      this->VersionFound =
-        this->Makefile->GetSafeDefinition("PACKAGE_VERSION");
+      this->VersionFound = vr.Version;
 
       // Try to parse the version number and store the results that were
       // successfully parsed.
@@ -1683,7 +1785,7 @@ bool cmFindPackageCommand::CheckVersionFile(std::string const& version_file,
       }
     }
 
-  result_version = this->Makefile->GetSafeDefinition("PACKAGE_VERSION");
+  result_version = vr.Version;
   if (result_version.empty())
     {
     result_version = "unknown";
@@ -1693,6 +1795,52 @@ bool cmFindPackageCommand::CheckVersionFile(std::string const& version_file,
   return suitable;
 }
 
+//----------------------------------------------------------------------------
+bool cmFindPackageCommand::ReadVersionFile(std::string const& version_file,
+                               cmFindPackageCache::VersionResult& result)
+{
+  // The version file will be loaded in an isolated scope.
+  cmMakefile::ScopePushPop varScope(this->Makefile);
+  cmMakefile::PolicyPushPop polScope(this->Makefile);
+  static_cast<void>(varScope);
+  static_cast<void>(polScope);
+
+  // Clear the output variables.
+  this->Makefile->RemoveDefinition("PACKAGE_VERSION");
+  this->Makefile->RemoveDefinition("PACKAGE_VERSION_UNSUITABLE");
+  this->Makefile->RemoveDefinition("PACKAGE_VERSION_COMPATIBLE");
+  this->Makefile->RemoveDefinition("PACKAGE_VERSION_EXACT");
+
+  // Set the input variables.
+  this->Makefile->AddDefinition("PACKAGE_FIND_NAME", this->Name.c_str());
+  this->Makefile->AddDefinition("PACKAGE_FIND_VERSION",
+                                this->Version.c_str());
+  char buf[64];
+  sprintf(buf, "%u", this->VersionMajor);
+  this->Makefile->AddDefinition("PACKAGE_FIND_VERSION_MAJOR", buf);
+  sprintf(buf, "%u", this->VersionMinor);
+  this->Makefile->AddDefinition("PACKAGE_FIND_VERSION_MINOR", buf);
+  sprintf(buf, "%u", this->VersionPatch);
+  this->Makefile->AddDefinition("PACKAGE_FIND_VERSION_PATCH", buf);
+  sprintf(buf, "%u", this->VersionTweak);
+  this->Makefile->AddDefinition("PACKAGE_FIND_VERSION_TWEAK", buf);
+  sprintf(buf, "%u", this->VersionCount);
+  this->Makefile->AddDefinition("PACKAGE_FIND_VERSION_COUNT", buf);
+
+  // Load the version check file.  Pass NoPolicyScope because we do
+  // our own policy push/pop independent of CMP0011.
+  bool loaded = this->ReadListFile(version_file.c_str(), NoPolicyScope);
+  if(loaded)
+    {
+    // Collect the output variables.
+    result.Exact = this->Makefile->IsOn("PACKAGE_VERSION_EXACT");
+    result.Compatible = this->Makefile->IsOn("PACKAGE_VERSION_COMPATIBLE");
+    result.Unsuitable = this->Makefile->IsOn("PACKAGE_VERSION_UNSUITABLE");
+    }
+  result.Version = this->Makefile->GetSafeDefinition("PACKAGE_VERSION");
+  return loaded;
+}
+
 //----------------------------------------------------------------------------
 void cmFindPackageCommand::StoreVersionFound()
 {
@@ -1746,7 +1894,7 @@ private:
 class cmFileList
 {
 public:
-  cmFileList(): First(), Last(0) {}
+  cmFileList(cmGlobalGenerator* gg): First(), Last(0), GG(gg) {}
   virtual ~cmFileList() {}
   cmFileList& operator/(cmFileListGeneratorBase const& rhs)
     {
@@ -1769,11 +1917,19 @@ public:
       }
     return false;
     }
+  // Get the entries of a directory named with a trailing slash.
+  std::set<std::string> const& GetDirectoryContent(std::string const& dir)
+    {
+    std::string d = dir;
+    cmSystemTools::ConvertToUnixSlashes(d);
+    return this->GG->GetDirectoryContent(d);
+    }
 private:
   virtual bool Visit(std::string const& fullPath) = 0;
   friend class cmFileListGeneratorBase;
   cmsys::auto_ptr<cmFileListGeneratorBase> First;
   cmFileListGeneratorBase* Last;
+  cmGlobalGenerator* GG;
 };
 
 class cmFindPackageFileList: public cmFileList
@@ -1781,7 +1937,8 @@ class cmFindPackageFileList: public cmFileList
 public:
   cmFindPackageFileList(cmFindPackageCommand* fpc,
                         bool use_suffixes = true):
-    cmFileList(), FPC(fpc), UseSuffixes(use_suffixes) {}
+    cmFileList(fpc->GetMakefile()->GetLocalGenerator()->GetGlobalGenerator()),
+    FPC(fpc), UseSuffixes(use_suffixes) {}
 private:
   bool Visit(std::string const& fullPath)
     {
@@ -1887,16 +2044,11 @@ private:
     {
     // Construct a list of matches.
     std::vector<std::string> matches;
-    cmsys::Directory d;
-    d.Load(parent);
-    for(unsigned long i=0; i < d.GetNumberOfFiles(); ++i)
+    std::set<std::string> const& files = lister.GetDirectoryContent(parent);
+    for(std::set<std::string>::const_iterator fi = files.begin();
+        fi != files.end(); ++fi)
       {
-      const char* fname = d.GetFile(i);
-      if(strcmp(fname, ".") == 0 ||
-         strcmp(fname, "..") == 0)
-        {
-        continue;
-        }
+      const char* fname = fi->c_str();
       for(std::vector<std::string>::const_iterator ni = this->Names.begin();
           ni != this->Names.end(); ++ni)
         {
@@ -1941,16 +2093,11 @@ private:
     {
     // Construct a list of matches.
     std::vector<std::string> matches;
-    cmsys::Directory d;
-    d.Load(parent);
-    for(unsigned long i=0; i < d.GetNumberOfFiles(); ++i)
+    std::set<std::string> const& files = lister.GetDirectoryContent(parent);
+    for(std::set<std::string>::const_iterator fi = files.begin();
+        fi != files.end(); ++fi)
       {
-      const char* fname = d.GetFile(i);
-      if(strcmp(fname, ".") == 0 ||
-         strcmp(fname, "..") == 0)
-        {
-        continue;
-        }
+      const char* fname = fi->c_str();
       for(std::vector<std::string>::const_iterator ni = this->Names.begin();
           ni != this->Names.end(); ++ni)
         {
@@ -1994,17 +2141,11 @@ private:
   virtual bool Search(std::string const& parent, cmFileList& lister)
     {
     // Look for matching files.
-    std::vector<std::string> matches;
-    cmsys::Directory d;
-    d.Load(parent);
-    for(unsigned long i=0; i < d.GetNumberOfFiles(); ++i)
+    std::set<std::string> const& files = lister.GetDirectoryContent(parent);
+    for(std::set<std::string>::const_iterator fi = files.begin();
+        fi != files.end(); ++fi)
       {
-      const char* fname = d.GetFile(i);
-      if(strcmp(fname, ".") == 0 ||
-         strcmp(fname, "..") == 0)
-        {
-        continue;
-        }
+      const char* fname = fi->c_str();
       if(cmsysString_strcasecmp(fname, this->String.c_str()) == 0)
         {
         if(this->Consider(parent + fname, lister))
@@ -2076,7 +2217,9 @@ bool cmFindPackageCommand::SearchPrefix(std::string const& prefix_in)
     }
 
   // Skip this if the prefix does not exist.
-  if(!cmSystemTools::FileIsDirectory(prefix_in))
+  if(!this->Makefile->GetLocalGenerator()->GetGlobalGenerator()
+     ->FileMayExist(prefix_in.substr(0, prefix_in.size()-1)) ||
+     !cmSystemTools::FileIsDirectory(prefix_in))
     {
     return false;
     }
@@ -13,6 +13,7 @@
 #define cmFindPackageCommand_h
 
 #include "cmFindCommon.h"
+#include "cmFindPackageCache.h"
 
 class cmFindPackageFileList;
 
@@ -106,6 +107,11 @@ private:
   bool CheckVersion(std::string const& config_file);
   bool CheckVersionFile(std::string const& version_file,
                         std::string& result_version);
+  bool ReadVersionFile(std::string const& version_file,
+                       cmFindPackageCache::VersionResult& result);
+  std::string GetVersionRequest() const;
+  std::string GetSearchRequest() const;
+  std::string GetVariableHelp() const;
   bool SearchPrefix(std::string const& prefix);
   bool SearchFrameworkPrefix(std::string const& prefix_in);
   bool SearchAppBundlePrefix(std::string const& prefix_in);
@@ -147,6 +153,9 @@ private:
   std::vector<std::string> Configs;
   std::set<std::string> IgnoredPaths;
 
+  // Version files consulted by the current search, if it is recorded.
+  std::map<std::string, long>* SearchedFiles;
+
   struct ConfigFileInfo { std::string filename; std::string version; };
   std::vector<ConfigFileInfo> ConsideredConfigs;
 };
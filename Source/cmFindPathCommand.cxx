@@ -150,6 +150,8 @@ cmFindPathCommand::FindHeaderInFramework(std::string const& file,
 //----------------------------------------------------------------------------
 std::string cmFindPathCommand::FindNormalHeader()
 {
+  cmGlobalGenerator* gg =
+    this->Makefile->GetLocalGenerator()->GetGlobalGenerator();
   std::string tryPath;
   for(std::vector<std::string>::const_iterator ni = this->Names.begin();
       ni != this->Names.end() ; ++ni)
@@ -160,7 +162,8 @@ std::string cmFindPathCommand::FindNormalHeader()
       {
       tryPath = *p;
       tryPath += *ni;
-      if(cmSystemTools::FileExists(tryPath.c_str()))
+      if(gg->FileMayExist(tryPath) &&
+         cmSystemTools::FileExists(tryPath.c_str()))
         {
         if(this->IncludeFileInPath)
           {
@@ -70,7 +70,7 @@ std::string cmFindProgramCommand::FindProgram(std::vector<std::string> names)
     }
   if(program.empty() && !this->SearchAppBundleOnly)
     {
-    program = cmSystemTools::FindProgram(names, this->SearchPaths, true);
+    program = this->FindNormalProgram(names);
     }
 
   if(program.empty() && this->SearchAppBundleLast)
@@ -80,6 +80,35 @@ std::string cmFindProgramCommand::FindProgram(std::vector<std::string> names)
   return program;
 }
 
+std::string cmFindProgramCommand
+::FindNormalProgram(std::vector<std::string> const& names)
+{
+  cmGlobalGenerator* gg =
+    this->Makefile->GetLocalGenerator()->GetGlobalGenerator();
+  std::vector<std::string> paths;
+  for(std::vector<std::string>::const_iterator name = names.begin();
+      name != names.end() ; ++name)
+    {
+    // Skip directories whose cached content has no entry starting with
+    // the name.  This also covers names with an executable extension.
+    paths.clear();
+    for(std::vector<std::string>::const_iterator
+          p = this->SearchPaths.begin(); p != this->SearchPaths.end(); ++p)
+      {
+      if(gg->FileMayExist(*p + *name, true))
+        {
+        paths.push_back(*p);
+        }
+      }
+    std::string program = cmSystemTools::FindProgram(*name, paths, true);
+    if(!program.empty())
+      {
+      return program;
+      }
+    }
+  return "";
+}
+
 std::string cmFindProgramCommand
 ::FindAppBundle(std::vector<std::string> names)
 {
@@ -56,6 +56,7 @@ protected:
   std::string FindProgram(std::vector<std::string> names);
 
 private:
+  std::string FindNormalProgram(std::vector<std::string> const& names);
   std::string FindAppBundle(std::vector<std::string> names);
   std::string GetBundleExecutable(std::string bundlePath);
 
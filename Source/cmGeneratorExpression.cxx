@@ -20,6 +20,49 @@
 #include "cmGeneratorExpressionParser.h"
 #include "cmGeneratorExpressionDAGChecker.h"
 
+//----------------------------------------------------------------------------
+// The lexed and parsed form of an input string.  The evaluators refer to
+// the text of the input they were parsed from and do not depend on the
+// context of any evaluation, so one instance is shared by all compiled
+// expressions with the same input.
+struct cmCompiledGeneratorExpression::ParsedInput
+{
+  ParsedInput(std::string const& input)
+    : Input(input), NeedsEvaluation(false), RefCount(1) {}
+  ~ParsedInput() { cmDeleteAll(this->Evaluators); }
+
+  void Release()
+    {
+    if (--this->RefCount == 0)
+      {
+      delete this;
+      }
+    }
+
+  const std::string Input;
+  std::vector<cmGeneratorExpressionEvaluator*> Evaluators;
+  bool NeedsEvaluation;
+  unsigned int RefCount;
+};
+
+//----------------------------------------------------------------------------
+// Parsed inputs by their text.  The same property values are evaluated
+// for every consuming target and every configuration, so each distinct
+// input is lexed and parsed only once.
+struct cmCompiledGeneratorExpression::ParseCache
+{
+  typedef std::map<std::string, ParsedInput*> MapType;
+  ~ParseCache()
+    {
+    for (MapType::iterator it = this->Entries.begin();
+         it != this->Entries.end(); ++it)
+      {
+      it->second->Release();
+      }
+    }
+  MapType Entries;
+};
+
 //----------------------------------------------------------------------------
 cmGeneratorExpression::cmGeneratorExpression(
   cmListFileBacktrace const* backtrace):
@@ -72,7 +115,7 @@ const char *cmCompiledGeneratorExpression::Evaluate(
   cmGeneratorExpressionDAGChecker *dagChecker,
   std::string const& language) const
 {
-  if (!this->NeedsEvaluation)
+  if (!this->Parsed || !this->Parsed->NeedsEvaluation)
     {
     return this->Input.c_str();
     }
@@ -80,9 +123,9 @@ const char *cmCompiledGeneratorExpression::Evaluate(
   this->Output = "";
 
   std::vector<cmGeneratorExpressionEvaluator*>::const_iterator it
-                                                  = this->Evaluators.begin();
+                                          = this->Parsed->Evaluators.begin();
   const std::vector<cmGeneratorExpressionEvaluator*>::const_iterator end
-                                                  = this->Evaluators.end();
+                                          = this->Parsed->Evaluators.end();
 
   cmGeneratorExpressionContext context;
   context.Makefile = mf;
@@ -126,23 +169,53 @@ const char *cmCompiledGeneratorExpression::Evaluate(
   return this->Output.c_str();
 }
 
+//----------------------------------------------------------------------------
+cmCompiledGeneratorExpression::ParsedInput*
+cmCompiledGeneratorExpression::ParseInput(std::string const& input)
+{
+  cmGeneratorExpression::Statistics& stats =
+    cmGeneratorExpression::GetStatistics();
+  ++stats.Parses;
+
+  static ParseCache cache;
+  ParseCache::MapType::iterator it = cache.Entries.lower_bound(input);
+  if (it != cache.Entries.end() && it->first == input)
+    {
+    ++stats.ParseCacheHits;
+    ++it->second->RefCount;
+    return it->second;
+    }
+
+  ParsedInput* parsed = new ParsedInput(input);
+  cmGeneratorExpressionLexer l;
+  std::vector<cmGeneratorExpressionToken> tokens =
+                                              l.Tokenize(parsed->Input);
+  parsed->NeedsEvaluation = l.GetSawGeneratorExpression();
+
+  if (parsed->NeedsEvaluation)
+    {
+    cmGeneratorExpressionParser p(tokens);
+    p.Parse(parsed->Evaluators);
+    }
+
+  cache.Entries.insert(it, ParseCache::MapType::value_type(input, parsed));
+  ++parsed->RefCount;
+  return parsed;
+}
+
+//----------------------------------------------------------------------------
 cmCompiledGeneratorExpression::cmCompiledGeneratorExpression(
               cmListFileBacktrace const& backtrace,
               const std::string& input)
-  : Backtrace(backtrace), Input(input),
+  : Backtrace(backtrace), Parsed(0), Input(input),
     HadContextSensitiveCondition(false),
     HadHeadSensitiveCondition(false),
     EvaluateForBuildsystem(false)
 {
-  cmGeneratorExpressionLexer l;
-  std::vector<cmGeneratorExpressionToken> tokens =
-                                              l.Tokenize(this->Input);
-  this->NeedsEvaluation = l.GetSawGeneratorExpression();
-
-  if (this->NeedsEvaluation)
+  // Plain strings, the most common input, need no lexing at all.
+  if (this->Input.find("$<") != std::string::npos)
     {
-    cmGeneratorExpressionParser p(tokens);
-    p.Parse(this->Evaluators);
+    this->Parsed = ParseInput(this->Input);
     }
 }
 
@@ -150,7 +223,17 @@ cmCompiledGeneratorExpression::cmCompiledGeneratorExpression(
 //----------------------------------------------------------------------------
 cmCompiledGeneratorExpression::~cmCompiledGeneratorExpression()
 {
-  cmDeleteAll(this->Evaluators);
+  if (this->Parsed)
+    {
+    this->Parsed->Release();
+    }
+}
+
+//----------------------------------------------------------------------------
+cmGeneratorExpression::Statistics& cmGeneratorExpression::GetStatistics()
+{
+  static Statistics stats;
+  return stats;
 }
 
 //----------------------------------------------------------------------------
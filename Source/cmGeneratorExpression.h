@@ -66,6 +66,17 @@ public:
   static bool IsValidTargetName(const std::string &input);
 
   static std::string StripEmptyListElements(const std::string &input);
+
+  /** Counters describing how often parsing and evaluation work was
+   *  saved by reusing earlier results.  */
+  struct Statistics
+  {
+    Statistics(): Parses(0), ParseCacheHits(0), ConstantResultsReused(0) {}
+    unsigned long Parses;
+    unsigned long ParseCacheHits;
+    unsigned long ConstantResultsReused;
+  };
+  static Statistics& GetStatistics();
 private:
   cmGeneratorExpression(const cmGeneratorExpression &);
   void operator=(const cmGeneratorExpression &);
@@ -139,10 +150,13 @@ private:
   cmCompiledGeneratorExpression(const cmCompiledGeneratorExpression &);
   void operator=(const cmCompiledGeneratorExpression &);
 
+  struct ParsedInput;
+  struct ParseCache;
+  static ParsedInput* ParseInput(std::string const& input);
+
   cmListFileBacktrace Backtrace;
-  std::vector<cmGeneratorExpressionEvaluator*> Evaluators;
+  ParsedInput* Parsed;
   const std::string Input;
-  bool NeedsEvaluation;
 
   mutable std::set<cmTarget*> DependTargets;
   mutable std::set<cmTarget const*> AllTargetsSeen;
@@ -62,6 +62,10 @@ struct cmGeneratorExpressionNode
 
   virtual int NumExpectedParameters() const { return 1; }
 
+  // Whether the result depends only on the parameters and not on the
+  // evaluation context, so that it may be computed once and reused.
+  virtual bool IsContextIndependent() const { return false; }
+
   virtual std::string Evaluate(const std::vector<std::string> &parameters,
                                cmGeneratorExpressionContext *context,
                                const GeneratorExpressionContent *content,
@@ -108,6 +112,8 @@ static const struct ZeroNode : public cmGeneratorExpressionNode
 {
   ZeroNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   virtual bool GeneratesContent() const { return false; }
 
   virtual bool AcceptsArbitraryContentParameter() const { return true; }
@@ -126,6 +132,8 @@ static const struct OneNode : public cmGeneratorExpressionNode
 {
   OneNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   virtual bool AcceptsArbitraryContentParameter() const { return true; }
 
   std::string Evaluate(const std::vector<std::string> &parameters,
@@ -149,6 +157,7 @@ static const struct OP ## Node : public cmGeneratorExpressionNode \
 { \
   OP ## Node () {} \
   virtual int NumExpectedParameters() const { return OneOrMoreParameters; } \
+  virtual bool IsContextIndependent() const { return true; } \
  \
   std::string Evaluate(const std::vector<std::string> &parameters, \
                        cmGeneratorExpressionContext *context, \
@@ -184,6 +193,8 @@ static const struct NotNode : public cmGeneratorExpressionNode
 {
   NotNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   std::string Evaluate(const std::vector<std::string> &parameters,
                        cmGeneratorExpressionContext *context,
                        const GeneratorExpressionContent *content,
@@ -204,6 +215,8 @@ static const struct BoolNode : public cmGeneratorExpressionNode
 {
   BoolNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   virtual int NumExpectedParameters() const { return 1; }
 
   std::string Evaluate(const std::vector<std::string> &parameters,
@@ -220,6 +233,8 @@ static const struct StrEqualNode : public cmGeneratorExpressionNode
 {
   StrEqualNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   virtual int NumExpectedParameters() const { return 2; }
 
   std::string Evaluate(const std::vector<std::string> &parameters,
@@ -236,6 +251,8 @@ static const struct EqualNode : public cmGeneratorExpressionNode
 {
   EqualNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   virtual int NumExpectedParameters() const { return 2; }
 
   std::string Evaluate(const std::vector<std::string> &parameters,
@@ -322,6 +339,8 @@ static const struct LowerCaseNode : public cmGeneratorExpressionNode
 {
   LowerCaseNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   bool AcceptsArbitraryContentParameter() const { return true; }
 
   std::string Evaluate(const std::vector<std::string> &parameters,
@@ -338,6 +357,8 @@ static const struct UpperCaseNode : public cmGeneratorExpressionNode
 {
   UpperCaseNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   bool AcceptsArbitraryContentParameter() const { return true; }
 
   std::string Evaluate(const std::vector<std::string> &parameters,
@@ -354,6 +375,8 @@ static const struct MakeCIdentifierNode : public cmGeneratorExpressionNode
 {
   MakeCIdentifierNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   bool AcceptsArbitraryContentParameter() const { return true; }
 
   std::string Evaluate(const std::vector<std::string> &parameters,
@@ -370,6 +393,8 @@ static const struct Angle_RNode : public cmGeneratorExpressionNode
 {
   Angle_RNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   virtual int NumExpectedParameters() const { return 0; }
 
   std::string Evaluate(const std::vector<std::string> &,
@@ -386,6 +411,8 @@ static const struct CommaNode : public cmGeneratorExpressionNode
 {
   CommaNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   virtual int NumExpectedParameters() const { return 0; }
 
   std::string Evaluate(const std::vector<std::string> &,
@@ -402,6 +429,8 @@ static const struct SemicolonNode : public cmGeneratorExpressionNode
 {
   SemicolonNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   virtual int NumExpectedParameters() const { return 0; }
 
   std::string Evaluate(const std::vector<std::string> &,
@@ -638,6 +667,8 @@ static const struct VersionGreaterNode : public cmGeneratorExpressionNode
 {
   VersionGreaterNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   virtual int NumExpectedParameters() const { return 2; }
 
   std::string Evaluate(const std::vector<std::string> &parameters,
@@ -656,6 +687,8 @@ static const struct VersionLessNode : public cmGeneratorExpressionNode
 {
   VersionLessNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   virtual int NumExpectedParameters() const { return 2; }
 
   std::string Evaluate(const std::vector<std::string> &parameters,
@@ -674,6 +707,8 @@ static const struct VersionEqualNode : public cmGeneratorExpressionNode
 {
   VersionEqualNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   virtual int NumExpectedParameters() const { return 2; }
 
   std::string Evaluate(const std::vector<std::string> &parameters,
@@ -793,6 +828,8 @@ static const struct JoinNode : public cmGeneratorExpressionNode
 {
   JoinNode() {}
 
+  virtual bool IsContextIndependent() const { return true; }
+
   virtual int NumExpectedParameters() const { return 2; }
 
   virtual bool AcceptsArbitraryContentParameter() const { return true; }
@@ -1917,7 +1954,9 @@ cmGeneratorExpressionNode* GetNode(const std::string &identifier)
 GeneratorExpressionContent::GeneratorExpressionContent(
                                                     const char *startContent,
                                                     size_t length)
-  : StartContent(startContent), ContentLength(length)
+  : StartContent(startContent), ContentLength(length),
+    ContextIndependence(ContextIndependenceUnknown),
+    HaveConstantResult(false)
 {
 
 }
@@ -1979,10 +2018,82 @@ std::string GeneratorExpressionContent::ProcessArbitraryContent(
   return result;
 }
 
+//----------------------------------------------------------------------------
+bool GeneratorExpressionContent::IsContextIndependent() const
+{
+  if (this->ContextIndependence == ContextIndependenceUnknown)
+    {
+    this->ContextIndependence = this->ComputeContextIndependence()
+                              ? ContextIndependent : ContextDependent;
+    }
+  return this->ContextIndependence == ContextIndependent;
+}
+
+//----------------------------------------------------------------------------
+bool GeneratorExpressionContent::ComputeContextIndependence() const
+{
+  // The identifier must be literal text naming a node that does not
+  // query the context.  Text evaluates without a context.
+  std::string identifier;
+  std::vector<cmGeneratorExpressionEvaluator*>::const_iterator it
+                                          = this->IdentifierChildren.begin();
+  for ( ; it != this->IdentifierChildren.end(); ++it)
+    {
+    if ((*it)->GetType() != cmGeneratorExpressionEvaluator::Text)
+      {
+      return false;
+      }
+    identifier += (*it)->Evaluate(0, 0);
+    }
+  const cmGeneratorExpressionNode *node = GetNode(identifier);
+  if (!node || !node->IsContextIndependent())
+    {
+    return false;
+    }
+
+  std::vector<std::vector<cmGeneratorExpressionEvaluator*> >::const_iterator
+                                        pit = this->ParamChildren.begin();
+  for ( ; pit != this->ParamChildren.end(); ++pit)
+    {
+    for (it = pit->begin(); it != pit->end(); ++it)
+      {
+      if (!(*it)->IsContextIndependent())
+        {
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
 //----------------------------------------------------------------------------
 std::string GeneratorExpressionContent::Evaluate(
                             cmGeneratorExpressionContext *context,
                             cmGeneratorExpressionDAGChecker *dagChecker) const
+{
+  if (!this->IsContextIndependent())
+    {
+    return this->EvaluateContent(context, dagChecker);
+    }
+  if (this->HaveConstantResult)
+    {
+    ++cmGeneratorExpression::GetStatistics().ConstantResultsReused;
+    return this->ConstantResult;
+    }
+  std::string result = this->EvaluateContent(context, dagChecker);
+  // Errors are reported again by each evaluation, so keep only results.
+  if (!context->HadError)
+    {
+    this->ConstantResult = result;
+    this->HaveConstantResult = true;
+    }
+  return result;
+}
+
+//----------------------------------------------------------------------------
+std::string GeneratorExpressionContent::EvaluateContent(
+                            cmGeneratorExpressionContext *context,
+                            cmGeneratorExpressionDAGChecker *dagChecker) const
 {
   std::string identifier;
   {
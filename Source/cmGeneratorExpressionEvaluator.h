@@ -67,6 +67,9 @@ struct cmGeneratorExpressionEvaluator
   virtual std::string Evaluate(cmGeneratorExpressionContext *context,
                               cmGeneratorExpressionDAGChecker *) const = 0;
 
+  // Whether the result is the same in every context it is evaluated in.
+  virtual bool IsContextIndependent() const = 0;
+
 private:
   cmGeneratorExpressionEvaluator(const cmGeneratorExpressionEvaluator &);
   void operator=(const cmGeneratorExpressionEvaluator &);
@@ -91,6 +94,11 @@ struct TextContent : public cmGeneratorExpressionEvaluator
     return cmGeneratorExpressionEvaluator::Text;
   }
 
+  bool IsContextIndependent() const
+  {
+    return true;
+  }
+
   void Extend(size_t length)
   {
     this->Length += length;
@@ -129,11 +137,18 @@ struct GeneratorExpressionContent : public cmGeneratorExpressionEvaluator
   std::string Evaluate(cmGeneratorExpressionContext *context,
                        cmGeneratorExpressionDAGChecker *) const;
 
+  bool IsContextIndependent() const;
+
   std::string GetOriginalExpression() const;
 
   ~GeneratorExpressionContent();
 
 private:
+  std::string EvaluateContent(cmGeneratorExpressionContext *context,
+                              cmGeneratorExpressionDAGChecker *) const;
+
+  bool ComputeContextIndependence() const;
+
   std::string EvaluateParameters(const cmGeneratorExpressionNode *node,
                                  const std::string &identifier,
                                  cmGeneratorExpressionContext *context,
@@ -153,6 +168,18 @@ private:
   std::vector<std::vector<cmGeneratorExpressionEvaluator*> > ParamChildren;
   const char *StartContent;
   size_t ContentLength;
+
+  // Expressions with literal content that do not query the context are
+  // evaluated once and their result is reused.
+  enum ContextIndependenceEnum
+  {
+    ContextIndependenceUnknown,
+    ContextDependent,
+    ContextIndependent
+  };
+  mutable ContextIndependenceEnum ContextIndependence;
+  mutable bool HaveConstantResult;
+  mutable std::string ConstantResult;
 };
 
 #endif
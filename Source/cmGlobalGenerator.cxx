@@ -28,10 +28,12 @@
 #include "cmComputeTargetDepends.h"
 #include "cmGeneratedFileStream.h"
 #include "cmGeneratorTarget.h"
+#include "cmProfiler.h"
 #include "cmGeneratorExpression.h"
 #include "cmGeneratorExpressionEvaluationFile.h"
 #include "cmExportBuildFileGenerator.h"
 #include "cmCPackPropertiesGenerator.h"
+#include "cmFindPackageCache.h"
 
 #include <cmsys/Directory.hxx>
 #include <cmsys/FStream.hxx>
@@ -69,12 +71,16 @@ cmGlobalGenerator::cmGlobalGenerator()
   this->ExtraGenerator = 0;
   this->CurrentLocalGenerator = 0;
   this->TryCompileOuterMakefile = 0;
+  this->DirectoryContentEpoch = 1;
+  this->DirectoryContentRecord = 0;
+  this->FindPackageCache = new cmFindPackageCache;
 }
 
 cmGlobalGenerator::~cmGlobalGenerator()
 {
   this->ClearGeneratorMembers();
   delete this->ExtraGenerator;
+  delete this->FindPackageCache;
 }
 
 bool cmGlobalGenerator::SetGeneratorPlatform(std::string const& p,
@@ -1105,9 +1111,51 @@ void cmGlobalGenerator::Configure()
 
   this->BinaryDirectories.insert(mf->GetStartOutputDirectory());
 
+  bool persistDirectoryContent =
+    !this->CMakeInstance->GetIsInTryCompile() &&
+    this->CMakeInstance->GetWorkingMode() == cmake::NORMAL_MODE;
+  std::string findPackageCacheFile =
+    this->CMakeInstance->GetHomeOutputDirectory();
+  findPackageCacheFile += this->CMakeInstance->GetCMakeFilesDirectory();
+  findPackageCacheFile += "/CMakeFindPackageCache.txt";
+  if(persistDirectoryContent)
+    {
+    this->LoadDirectoryContent();
+    this->FindPackageCache->Load(findPackageCacheFile);
+    }
+
   // now do it
   lg->Configure();
 
+  if(persistDirectoryContent && !cmSystemTools::GetErrorOccuredFlag())
+    {
+    this->SaveDirectoryContent();
+    this->FindPackageCache->Save(findPackageCacheFile);
+    }
+  if(this->CMakeInstance->GetDebugOutput())
+    {
+    DirectoryContentStatistics const& stats = this->DirectoryContentStats;
+    std::ostringstream msg;
+    msg << "Directory content cache: "
+        << stats.ProbesSaved << " file checks and "
+        << stats.LoadsSaved << " directory listings saved, "
+        << stats.Loads << " directories listed, "
+        << stats.Checks << " directory time stamps checked";
+    cmSystemTools::Message(msg.str().c_str());
+
+    cmFindPackageCache::Statistics const& fpStats =
+      this->FindPackageCache->GetStatistics();
+    std::ostringstream fpMsg;
+    fpMsg << "find_package cache: "
+          << fpStats.VersionHits << " of "
+          << (fpStats.VersionHits + fpStats.VersionMisses)
+          << " version checks and "
+          << fpStats.MissingHits << " of "
+          << (fpStats.MissingHits + fpStats.MissingMisses)
+          << " searches answered from the cache";
+    cmSystemTools::Message(fpMsg.str().c_str());
+    }
+
   // update the cache entry for the number of local generators, this is used
   // for progress
   char num[100];
@@ -1198,8 +1246,47 @@ void cmGlobalGenerator::DoGenerate()
   this->Generate();
 }
 
+//----------------------------------------------------------------------------
+// Record the time spent in successive phases of the generate step.
+class cmGlobalGeneratorPhaseTimes
+{
+public:
+  cmGlobalGeneratorPhaseTimes(cmProfiler* profiler):
+    Profiler(profiler), Start(cmSystemTools::GetTime()) {}
+  void Mark(const char* phase)
+    {
+    double now = cmSystemTools::GetTime();
+    if(this->Profiler)
+      {
+      this->Profiler->AddEvent("generate", phase, this->Start, now, "");
+      }
+    this->Phases.push_back(std::make_pair(phase, now - this->Start));
+    this->Start = now;
+    }
+  void Report() const
+    {
+    std::ostringstream msg;
+    msg << "Generate step timing:";
+    for(std::vector<std::pair<const char*, double> >::const_iterator
+          it = this->Phases.begin(); it != this->Phases.end(); ++it)
+      {
+      msg << "\n  " << it->first << ": " << it->second << "s";
+      }
+    cmSystemTools::Message(msg.str().c_str());
+    }
+private:
+  cmProfiler* Profiler;
+  double Start;
+  std::vector<std::pair<const char*, double> > Phases;
+};
+
 void cmGlobalGenerator::Generate()
 {
+  cmGlobalGeneratorPhaseTimes phaseTimes(this->CMakeInstance->GetProfiler());
+
+  // Files may have been created since the last find command.
+  this->CheckDirectoryContentAgain();
+
   // Check whether this generator is allowed to run.
   if(!this->CheckALLOW_DUPLICATE_CUSTOM_TARGETS())
     {
@@ -1250,6 +1337,8 @@ void cmGlobalGenerator::Generate()
     }
 #endif
 
+  phaseTimes.Mark("target setup");
+
   // Trace the dependencies, after that no custom commands should be added
   // because their dependencies might not be handled correctly
   for (i = 0; i < this->LocalGenerators.size(); ++i)
@@ -1266,12 +1355,14 @@ void cmGlobalGenerator::Generate()
     }
 
   this->ProcessEvaluationFiles();
+  phaseTimes.Mark("dependency tracing");
 
   // Compute the inter-target dependencies.
   if(!this->ComputeTargetDepends())
     {
     return;
     }
+  phaseTimes.Mark("target dependencies");
 
   // Create a map from local generator to the complete set of targets
   // it builds by default.
@@ -1282,6 +1373,9 @@ void cmGlobalGenerator::Generate()
     {
     this->LocalGenerators[i]->GetMakefile()->SetGeneratingBuildSystem();
     this->SetCurrentLocalGenerator(this->LocalGenerators[i]);
+    cmProfiler::Scope profileScope(this->CMakeInstance->GetProfiler(),
+      "generate",
+      this->LocalGenerators[i]->GetMakefile()->GetStartOutputDirectory());
     this->LocalGenerators[i]->Generate();
     if(!this->LocalGenerators[i]->GetMakefile()->IsOn(
       "CMAKE_SKIP_INSTALL_RULES"))
@@ -1294,6 +1388,7 @@ void cmGlobalGenerator::Generate()
        static_cast<float>(this->LocalGenerators.size()));
     }
   this->SetCurrentLocalGenerator(0);
+  phaseTimes.Mark("project files");
 
   if(!this->GenerateCPackPropertiesFile())
     {
@@ -1341,6 +1436,33 @@ void cmGlobalGenerator::Generate()
     this->GetCMakeInstance()->IssueMessage(cmake::AUTHOR_WARNING, w.str());
     }
 
+  phaseTimes.Mark("exports and summaries");
+
+  if(this->CMakeInstance->GetDebugOutput())
+    {
+    phaseTimes.Report();
+
+    cmTarget::UsageRequirementsStatistics const& usage =
+      cmTarget::GetUsageRequirementsStatistics();
+    std::ostringstream umsg;
+    umsg << "Usage requirements: " << usage.Computed << " computed, "
+         << usage.Reused << " reused";
+    cmSystemTools::Message(umsg.str().c_str());
+
+    cmGeneratorExpression::Statistics const& stats =
+      cmGeneratorExpression::GetStatistics();
+    std::ostringstream msg;
+    msg << "Generator expressions: " << stats.Parses << " parsed, "
+        << stats.ParseCacheHits << " reused from the parse cache";
+    if(stats.Parses > 0)
+      {
+      msg << " (" << (100 * stats.ParseCacheHits / stats.Parses) << "%)";
+      }
+    msg << ", " << stats.ConstantResultsReused
+        << " constant results reused";
+    cmSystemTools::Message(msg.str().c_str());
+    }
+
   this->CMakeInstance->UpdateProgress("Generating done", -1);
 }
 
@@ -2685,17 +2807,34 @@ std::set<std::string> const&
 cmGlobalGenerator::GetDirectoryContent(std::string const& dir, bool needDisk)
 {
   DirectoryContent& dc = this->DirectoryContentMap[dir];
-  if(needDisk)
+  if(needDisk && dc.Epoch != this->DirectoryContentEpoch)
     {
+    bool firstCheck = dc.Epoch == 0;
+    dc.Epoch = this->DirectoryContentEpoch;
+    ++this->DirectoryContentStats.Checks;
     long mt = cmSystemTools::ModifiedTime(dir);
-    if (mt != dc.LastDiskTime)
+    // A listing taken within the resolution of the modification time
+    // may miss entries created later in the same second.
+    if (mt != dc.LastDiskTime || !dc.Persistent)
       {
       // Reset to non-loaded directory content.
       dc.All = dc.Generated;
+#if defined(_WIN32) || defined(__APPLE__)
+      dc.Lower.clear();
+      for(std::set<std::string>::const_iterator gi = dc.Generated.begin();
+          gi != dc.Generated.end(); ++gi)
+        {
+        dc.Lower.insert(cmSystemTools::LowerCase(*gi));
+        }
+#endif
 
       // Load the directory content from disk.
+      ++this->DirectoryContentStats.Loads;
       cmsys::Directory d;
-      if(d.Load(dir))
+      // A directory that exists but cannot be listed may still allow
+      // access to the files in it.
+      dc.Unlisted = mt != 0 && !d.Load(dir);
+      if(!dc.Unlisted)
         {
         unsigned long n = d.GetNumberOfFiles();
         for(unsigned long i = 0; i < n; ++i)
@@ -2704,15 +2843,152 @@ cmGlobalGenerator::GetDirectoryContent(std::string const& dir, bool needDisk)
           if(strcmp(f, ".") != 0 && strcmp(f, "..") != 0)
             {
             dc.All.insert(f);
+#if defined(_WIN32) || defined(__APPLE__)
+            dc.Lower.insert(cmSystemTools::LowerCase(f));
+#endif
             }
           }
         }
       dc.LastDiskTime = mt;
+      dc.Persistent =
+        !dc.Unlisted && cmSystemTools::IsModifiedTimeSettled(mt);
+      }
+    else if(firstCheck && dc.LastDiskTime != -1)
+      {
+      // Content loaded from the previous run is still up to date.
+      ++this->DirectoryContentStats.LoadsSaved;
       }
     }
+  if(needDisk && this->DirectoryContentRecord)
+    {
+    (*this->DirectoryContentRecord)[dir] = dc.LastDiskTime;
+    }
   return dc.All;
 }
 
+//----------------------------------------------------------------------------
+long cmGlobalGenerator::GetDirectoryContentTime(std::string const& dir)
+{
+  this->GetDirectoryContent(dir);
+  return this->DirectoryContentMap[dir].LastDiskTime;
+}
+
+//----------------------------------------------------------------------------
+bool cmGlobalGenerator::FileMayExist(std::string const& path, bool prefix)
+{
+  std::string::size_type slash = path.rfind('/');
+  if(slash == std::string::npos || slash == 0 ||
+     path.find('"') != std::string::npos)
+    {
+    return true;
+    }
+  std::string dir = path.substr(0, slash);
+  std::string name = path.substr(slash+1);
+  if(name.empty() || name == "." || name == "..")
+    {
+    return true;
+    }
+  cmSystemTools::ConvertToUnixSlashes(dir);
+
+  std::set<std::string> const& files = this->GetDirectoryContent(dir);
+  if(this->DirectoryContentMap[dir].Unlisted)
+    {
+    // Let the caller look for the file directly.
+    return true;
+    }
+#if defined(_WIN32) || defined(__APPLE__)
+  // The file system may not be case sensitive.
+  std::set<std::string> const& names =
+    this->DirectoryContentMap[dir].Lower;
+  name = cmSystemTools::LowerCase(name);
+#else
+  std::set<std::string> const& names = files;
+#endif
+  static_cast<void>(files);
+  std::set<std::string>::const_iterator i = names.lower_bound(name);
+  if(i != names.end() &&
+     (prefix? i->compare(0, name.size(), name) == 0 : *i == name))
+    {
+    return true;
+    }
+  ++this->DirectoryContentStats.ProbesSaved;
+  return false;
+}
+
+//----------------------------------------------------------------------------
+std::string cmGlobalGenerator::GetDirectoryContentFile() const
+{
+  std::string f = this->CMakeInstance->GetHomeOutputDirectory();
+  f += this->CMakeInstance->GetCMakeFilesDirectory();
+  f += "/CMakeDirectoryContent.txt";
+  return f;
+}
+
+//----------------------------------------------------------------------------
+void cmGlobalGenerator::LoadDirectoryContent()
+{
+  cmsys::ifstream fin(this->GetDirectoryContentFile().c_str());
+  if(!fin)
+    {
+    return;
+    }
+
+  // Each directory is written as a line "D <mtime> <dir>" followed by
+  // one line "F <name>" for each of its entries.
+  std::string line;
+  DirectoryContent* dc = 0;
+  while(cmSystemTools::GetLineFromStream(fin, line))
+    {
+    if(cmHasLiteralPrefix(line, "D "))
+      {
+      dc = 0;
+      std::string::size_type pos = line.find(' ', 2);
+      if(pos == std::string::npos)
+        {
+        continue;
+        }
+      long mt = atol(line.substr(2, pos-2).c_str());
+      dc = &this->DirectoryContentMap[line.substr(pos+1)];
+      dc->LastDiskTime = mt;
+      dc->Persistent = true;
+      }
+    else if(dc && cmHasLiteralPrefix(line, "F "))
+      {
+      dc->All.insert(line.substr(2));
+#if defined(_WIN32) || defined(__APPLE__)
+      dc->Lower.insert(cmSystemTools::LowerCase(line.substr(2)));
+#endif
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void cmGlobalGenerator::SaveDirectoryContent()
+{
+  cmGeneratedFileStream fout(this->GetDirectoryContentFile().c_str());
+  fout << "# Directory content cached by the find commands.\n";
+  for(std::map<std::string, DirectoryContent>::const_iterator
+        di = this->DirectoryContentMap.begin();
+      di != this->DirectoryContentMap.end(); ++di)
+    {
+    DirectoryContent const& dc = di->second;
+    if(!dc.Persistent || di->first.find('\n') != std::string::npos)
+      {
+      continue;
+      }
+    fout << "D " << dc.LastDiskTime << " " << di->first << "\n";
+    for(std::set<std::string>::const_iterator fi = dc.All.begin();
+        fi != dc.All.end(); ++fi)
+      {
+      if(dc.Generated.find(*fi) == dc.Generated.end() &&
+         fi->find('\n') == std::string::npos)
+        {
+        fout << "F " << *fi << "\n";
+        }
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 void
 cmGlobalGenerator::AddRuleHash(const std::vector<std::string>& outputs,
@@ -37,6 +37,7 @@ class cmTarget;
 class cmInstallTargetGenerator;
 class cmInstallFilesGenerator;
 class cmExportBuildFileGenerator;
+class cmFindPackageCache;
 class cmQtAutoGenerators;
 
 /** \class cmGlobalGenerator
@@ -263,6 +264,45 @@ public:
   std::set<std::string> const& GetDirectoryContent(std::string const& dir,
                                                    bool needDisk = true);
 
+  /** Check the content cached for each directory against its
+      modification time again before its next use.  Until then the
+      cached content is trusted so that a find command checks each
+      directory once no matter how many names it looks up in it.  */
+  void CheckDirectoryContentAgain() { ++this->DirectoryContentEpoch; }
+
+  /** Return false if the cached content of the directory containing
+      the given path shows that it has no entry named like the last
+      component of the path or, with 'prefix', no entry whose name starts
+      with it.  Otherwise the file may exist and must be checked.  */
+  bool FileMayExist(std::string const& path, bool prefix = false);
+
+  /** Return the modification time of a directory as checked by the
+      directory content cache.  */
+  long GetDirectoryContentTime(std::string const& dir);
+
+  /** While set, the modification time of every directory whose content
+      is read from the cache is recorded in the given map.  */
+  void SetDirectoryContentRecord(std::map<std::string, long>* record)
+    { this->DirectoryContentRecord = record; }
+
+  /** Results of find_package kept from one configure to the next.  */
+  cmFindPackageCache* GetFindPackageCache()
+    { return this->FindPackageCache; }
+
+  /** Counters describing the file system calls saved by the directory
+      content cache.  */
+  struct DirectoryContentStatistics
+  {
+    DirectoryContentStatistics():
+      Checks(0), Loads(0), LoadsSaved(0), ProbesSaved(0) {}
+    unsigned long Checks;
+    unsigned long Loads;
+    unsigned long LoadsSaved;
+    unsigned long ProbesSaved;
+  };
+  DirectoryContentStatistics const& GetDirectoryContentStatistics() const
+    { return this->DirectoryContentStats; }
+
   void AddTarget(cmTarget* t);
 
   static bool IsReservedTarget(std::string const& name);
@@ -314,6 +354,11 @@ public:
       i.e. "Can I build Debug and Release in the same tree?" */
   virtual bool IsMultiConfig() { return false; }
 
+  /** Get the file read by "cmake --check-build-system" to decide whether
+      the build system is up to date, or an empty string if the build
+      system does not use that check.  */
+  virtual std::string GetBuildSystemCheckFile() { return std::string(); }
+
   std::string GetSharedLibFlagsForLanguage(std::string const& lang) const;
 
   /** Generate an <output>.rule file path for a given command output.  */
@@ -486,17 +531,43 @@ private:
 
   virtual const char* GetBuildIgnoreErrorsFlag() const { return 0; }
 
-  // Cache directory content and target files to be built.
+  // Cache directory content and target files to be built.  A listing
+  // is Persistent when it was taken long enough after the last change
+  // of the directory to be trusted while the time stamp is unchanged.
   struct DirectoryContent
   {
     long LastDiskTime;
+    unsigned long Epoch;
+    bool Persistent;
+    bool Unlisted;
     std::set<std::string> All;
     std::set<std::string> Generated;
-    DirectoryContent(): LastDiskTime(-1) {}
+#if defined(_WIN32) || defined(__APPLE__)
+    std::set<std::string> Lower;
+#endif
+    DirectoryContent(): LastDiskTime(-1), Epoch(0), Persistent(false),
+                        Unlisted(false) {}
     DirectoryContent(DirectoryContent const& dc):
-      LastDiskTime(dc.LastDiskTime), All(dc.All), Generated(dc.Generated) {}
+      LastDiskTime(dc.LastDiskTime), Epoch(dc.Epoch),
+      Persistent(dc.Persistent), Unlisted(dc.Unlisted), All(dc.All),
+      Generated(dc.Generated)
+#if defined(_WIN32) || defined(__APPLE__)
+      , Lower(dc.Lower)
+#endif
+      {}
   };
   std::map<std::string, DirectoryContent> DirectoryContentMap;
+  unsigned long DirectoryContentEpoch;
+  DirectoryContentStatistics DirectoryContentStats;
+  std::map<std::string, long>* DirectoryContentRecord;
+
+  cmFindPackageCache* FindPackageCache;
+
+  // Keep the directory content read from disk in the build tree so that
+  // the next configure reads unchanged directories only once.
+  std::string GetDirectoryContentFile() const;
+  void LoadDirectoryContent();
+  void SaveDirectoryContent();
 
   // Set of binary directories on disk.
   std::set<std::string> BinaryDirectories;
@@ -168,6 +168,7 @@ void cmGlobalUnixMakefileGenerator3::Generate()
   // write the main makefile
   this->WriteMainMakefile2();
   this->WriteMainCMakefile();
+  this->TargetClosures.clear();
 
   if (this->CommandDatabase != NULL) {
     *this->CommandDatabase << std::endl << "]";
@@ -403,6 +404,16 @@ void cmGlobalUnixMakefileGenerator3::WriteMainCMakefile()
                                         this->LocalGenerators);
 }
 
+//----------------------------------------------------------------------------
+std::string cmGlobalUnixMakefileGenerator3::GetBuildSystemCheckFile()
+{
+  std::string cmakefileName =
+    this->GetCMakeInstance()->GetHomeOutputDirectory();
+  cmakefileName += cmake::GetCMakeFilesDirectory();
+  cmakefileName += "/Makefile.cmake";
+  return cmakefileName;
+}
+
 void cmGlobalUnixMakefileGenerator3
 ::WriteMainCMakefileLanguageRules(cmGeneratedFileStream& cmakefileStream,
                                   std::vector<cmLocalGenerator *> &lGenerators
@@ -824,9 +835,8 @@ cmGlobalUnixMakefileGenerator3
                               cmLocalGenerator::FULL,
                               cmLocalGenerator::SHELL);
       //
-      std::set<cmTarget const*> emitted;
       progCmd << " "
-              << this->CountProgressMarksInTarget(gtarget->Target, emitted);
+              << this->CountProgressMarksInTarget(gtarget->Target);
       commands.push_back(progCmd.str());
       }
       std::string tmp = cmake::GetCMakeFilesDirectoryPostSlash();
@@ -902,42 +912,131 @@ cmGlobalUnixMakefileGenerator3
 //----------------------------------------------------------------------------
 size_t
 cmGlobalUnixMakefileGenerator3
-::CountProgressMarksInTarget(cmTarget const* target,
-                             std::set<cmTarget const*>& emitted)
+::CountProgressMarks(std::vector<cmTarget const*> const& targets,
+                     std::set<cmTarget const*>& emitted)
 {
+  // Merge the closures of the largest dependencies first.  Any target
+  // already emitted had its whole closure emitted along with it, so
+  // most of the remaining closures can be skipped without a walk.
   size_t count = 0;
-  if(emitted.insert(target).second)
+  std::vector<std::pair<size_t, TargetClosure const*> > closures;
+  for(std::vector<cmTarget const*>::const_iterator ti = targets.begin();
+      ti != targets.end(); ++ti)
     {
-    count = this->ProgressMap[target].Marks.size();
-    TargetDependSet const& depends = this->GetTargetDirectDepends(*target);
-    for(TargetDependSet::const_iterator di = depends.begin();
-        di != depends.end(); ++di)
+    if(this->ClosuresInProgress.find(*ti) !=
+       this->ClosuresInProgress.end())
       {
-      if ((*di)->GetType() == cmTarget::INTERFACE_LIBRARY)
+      // A dependency cycle leads back to a closure being computed.
+      // Count the target alone like the old recursive walk did.
+      if(emitted.insert(*ti).second)
         {
-        continue;
+        ProgressMapType::const_iterator pmi = this->ProgressMap.find(*ti);
+        if(pmi != this->ProgressMap.end())
+          {
+          count += pmi->second.Marks.size();
+          }
+        }
+      continue;
+      }
+    TargetClosure const& tc = this->GetTargetClosure(*ti);
+    closures.push_back(std::make_pair(tc.Targets.size(), &tc));
+    }
+  std::stable_sort(closures.begin(), closures.end(),
+                   cmGlobalUnixMakefileGenerator3::ClosureSizeGreater);
+
+  for(std::vector<std::pair<size_t, TargetClosure const*> >::const_iterator
+        ci = closures.begin(); ci != closures.end(); ++ci)
+    {
+    std::vector<cmTarget const*> const& closure = ci->second->Targets;
+    if(emitted.find(closure.front()) != emitted.end())
+      {
+      continue;
+      }
+    for(std::vector<cmTarget const*>::const_iterator ti = closure.begin();
+        ti != closure.end(); ++ti)
+      {
+      if(emitted.insert(*ti).second)
+        {
+        ProgressMapType::const_iterator pmi = this->ProgressMap.find(*ti);
+        if(pmi != this->ProgressMap.end())
+          {
+          count += pmi->second.Marks.size();
+          }
         }
-      count += this->CountProgressMarksInTarget(*di, emitted);
       }
     }
   return count;
 }
 
+//----------------------------------------------------------------------------
+cmGlobalUnixMakefileGenerator3::TargetClosure const&
+cmGlobalUnixMakefileGenerator3::GetTargetClosure(cmTarget const* target)
+{
+  TargetClosureMapType::iterator i = this->TargetClosures.find(target);
+  if(i != this->TargetClosures.end())
+    {
+    return i->second;
+    }
+
+  // The final target dependency graph is acyclic because
+  // cmComputeTargetDepends linearizes strongly connected components and
+  // rejects the cycles it cannot break.  Still guard against re-entry.
+  this->ClosuresInProgress.insert(target);
+  std::vector<cmTarget const*> depends;
+  TargetDependSet const& ds = this->GetTargetDirectDepends(*target);
+  for(TargetDependSet::const_iterator di = ds.begin(); di != ds.end(); ++di)
+    {
+    if ((*di)->GetType() == cmTarget::INTERFACE_LIBRARY)
+      {
+      continue;
+      }
+    depends.push_back(*di);
+    }
+
+  std::set<cmTarget const*> emitted;
+  TargetClosure tc;
+  tc.Targets.push_back(target);
+  emitted.insert(target);
+  ProgressMapType::const_iterator pmi = this->ProgressMap.find(target);
+  if(pmi != this->ProgressMap.end())
+    {
+    tc.NumberOfMarks = pmi->second.Marks.size();
+    }
+  tc.NumberOfMarks += this->CountProgressMarks(depends, emitted);
+  this->ClosuresInProgress.erase(target);
+  for(std::set<cmTarget const*>::const_iterator ei = emitted.begin();
+      ei != emitted.end(); ++ei)
+    {
+    if(*ei != target)
+      {
+      tc.Targets.push_back(*ei);
+      }
+    }
+
+  TargetClosure& result = this->TargetClosures[target];
+  result.Targets.swap(tc.Targets);
+  result.NumberOfMarks = tc.NumberOfMarks;
+  return result;
+}
+
+//----------------------------------------------------------------------------
+size_t
+cmGlobalUnixMakefileGenerator3
+::CountProgressMarksInTarget(cmTarget const* target)
+{
+  return this->GetTargetClosure(target).NumberOfMarks;
+}
+
 //----------------------------------------------------------------------------
 size_t
 cmGlobalUnixMakefileGenerator3
 ::CountProgressMarksInAll(cmLocalUnixMakefileGenerator3* lg)
 {
-  size_t count = 0;
-  std::set<cmTarget const*> emitted;
   std::set<cmTarget const*> const& targets
                                         = this->LocalGeneratorToTargetMap[lg];
-  for(std::set<cmTarget const*>::const_iterator t = targets.begin();
-      t != targets.end(); ++t)
-    {
-    count += this->CountProgressMarksInTarget(*t, emitted);
-    }
-  return count;
+  std::vector<cmTarget const*> targetList(targets.begin(), targets.end());
+  std::set<cmTarget const*> emitted;
+  return this->CountProgressMarks(targetList, emitted);
 }
 
 //----------------------------------------------------------------------------
@@ -128,6 +128,9 @@ public:
   /** Does the make tool tolerate .NOTPARALLEL? */
   virtual bool AllowNotParallel() const { return true; }
 
+  /** Get the Makefile.cmake file checked before each build.  */
+  virtual std::string GetBuildSystemCheckFile();
+
   virtual void ComputeTargetObjectDirectory(cmGeneratorTarget* gt) const;
 protected:
   void WriteMainMakefile2();
@@ -189,8 +192,29 @@ protected:
                    cmStrictTargetComparison> ProgressMapType;
   ProgressMapType ProgressMap;
 
-  size_t CountProgressMarksInTarget(cmTarget const* target,
-                                    std::set<cmTarget const*>& emitted);
+  // Transitive closure of the dependencies of a target, including the
+  // target itself, and the number of progress marks in it.  Each
+  // closure is computed once and reused by the targets and directories
+  // depending on it, but building it still visits every target in it,
+  // so a long chain of targets costs time quadratic in its length.
+  struct TargetClosure
+  {
+    TargetClosure(): NumberOfMarks(0) {}
+    std::vector<cmTarget const*> Targets;
+    size_t NumberOfMarks;
+  };
+  typedef std::map<cmTarget const*, TargetClosure> TargetClosureMapType;
+  TargetClosureMapType TargetClosures;
+  std::set<cmTarget const*> ClosuresInProgress;
+  TargetClosure const& GetTargetClosure(cmTarget const* target);
+  static bool ClosureSizeGreater(
+    std::pair<size_t, TargetClosure const*> const& l,
+    std::pair<size_t, TargetClosure const*> const& r)
+    { return l.first > r.first; }
+  size_t CountProgressMarks(std::vector<cmTarget const*> const& targets,
+                            std::set<cmTarget const*>& emitted);
+
+  size_t CountProgressMarksInTarget(cmTarget const* target);
   size_t CountProgressMarksInAll(cmLocalUnixMakefileGenerator3* lg);
 
   cmGeneratedFileStream *CommandDatabase;
@@ -35,13 +35,14 @@ struct cmListFileParser
   cmListFileLexer* Lexer;
   cmListFileFunction Function;
   enum { SeparationOkay, SeparationWarning, SeparationError} Separation;
+  bool IssuedWarning;
 };
 
 //----------------------------------------------------------------------------
 cmListFileParser::cmListFileParser(cmListFile* lf, cmMakefile* mf,
                                    const char* filename):
   ListFile(lf), Makefile(mf), FileName(filename),
-  Lexer(cmListFileLexer_New())
+  Lexer(cmListFileLexer_New()), IssuedWarning(false)
 {
 }
 
@@ -147,11 +148,31 @@ bool cmListFile::ParseFile(const char* filename,
 
   bool parseError = false;
   this->ModifiedTime = cmSystemTools::ModifiedTime(filename);
+  unsigned long size = cmSystemTools::FileLength(filename);
 
-  {
-  cmListFileParser parser(this, mf, filename);
-  parseError = !parser.ParseFile();
-  }
+  // Only files named by their canonical full path are cached so that
+  // the file names recorded in the parsed arguments stay the same.
+  bool cacheable = cmSystemTools::FileIsFullPath(filename) &&
+    cmSystemTools::CollapseFullPath(filename) == filename;
+
+  if(std::vector<cmListFileFunction> const* functions = cacheable?
+     cmListFileCache::Find(filename, this->ModifiedTime, size) : 0)
+    {
+    this->Functions = *functions;
+    }
+  else
+    {
+    cmListFileParser parser(this, mf, filename);
+    parseError = !parser.ParseFile();
+
+    // Files whose parsing produced diagnostics are not cached so that
+    // the diagnostics are reported again each time they are read.
+    if(cacheable && !parseError && !parser.IssuedWarning)
+      {
+      cmListFileCache::Store(filename, this->ModifiedTime, size,
+                             this->Functions);
+      }
+    }
 
   if(parseError)
     {
@@ -402,10 +423,95 @@ bool cmListFileParser::AddArgument(cmListFileLexer_Token* token,
   else
     {
     this->Makefile->IssueMessage(cmake::AUTHOR_WARNING, m.str());
+    this->IssuedWarning = true;
     return true;
     }
 }
 
+//----------------------------------------------------------------------------
+namespace
+{
+struct cmListFileCacheEntry
+{
+  cmListFileCacheEntry(): ModifiedTime(0), Size(0) {}
+  long int ModifiedTime;
+  unsigned long Size;
+  std::vector<cmListFileFunction> Functions;
+};
+typedef std::map<std::string, cmListFileCacheEntry> cmListFileCacheMap;
+
+cmListFileCacheMap cmListFileCacheEntries;
+unsigned long cmListFileCacheHits = 0;
+unsigned long cmListFileCacheMisses = 0;
+}
+
+//----------------------------------------------------------------------------
+std::vector<cmListFileFunction> const*
+cmListFileCache::Find(std::string const& path, long int mtime,
+                      unsigned long size)
+{
+  cmListFileCacheMap::const_iterator i = cmListFileCacheEntries.find(path);
+  if(i != cmListFileCacheEntries.end() &&
+     i->second.ModifiedTime == mtime && i->second.Size == size)
+    {
+    ++cmListFileCacheHits;
+    return &i->second.Functions;
+    }
+  ++cmListFileCacheMisses;
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+void cmListFileCache::Store(std::string const& path, long int mtime,
+                            unsigned long size,
+                            std::vector<cmListFileFunction> const& functions)
+{
+  if(mtime == 0 || !cmSystemTools::IsModifiedTimeSettled(mtime))
+    {
+    cmListFileCacheEntries.erase(path);
+    return;
+    }
+
+  cmListFileCacheMap::iterator i =
+    cmListFileCacheEntries.insert(
+      cmListFileCacheMap::value_type(path, cmListFileCacheEntry())).first;
+  cmListFileCacheEntry& e = i->second;
+  e.ModifiedTime = mtime;
+  e.Size = size;
+  e.Functions = functions;
+
+  // The arguments refer to the file name they came from.  Point them
+  // at the key of the entry which lives as long as the process.
+  const char* filePath = i->first.c_str();
+  for(std::vector<cmListFileFunction>::iterator fi = e.Functions.begin();
+      fi != e.Functions.end(); ++fi)
+    {
+    for(std::vector<cmListFileArgument>::iterator ai =
+          fi->Arguments.begin(); ai != fi->Arguments.end(); ++ai)
+      {
+      ai->FilePath = filePath;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+unsigned long cmListFileCache::GetNumberOfHits()
+{
+  return cmListFileCacheHits;
+}
+
+//----------------------------------------------------------------------------
+unsigned long cmListFileCache::GetNumberOfMisses()
+{
+  return cmListFileCacheMisses;
+}
+
+//----------------------------------------------------------------------------
+unsigned long cmListFileCache::GetNumberOfEntries()
+{
+  return static_cast<unsigned long>(cmListFileCacheEntries.size());
+}
+
 //----------------------------------------------------------------------------
 void cmListFileBacktrace::MakeRelative()
 {
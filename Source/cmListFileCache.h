@@ -15,14 +15,6 @@
 #include "cmStandardIncludes.h"
 
 class cmLocalGenerator;
-
-/** \class cmListFileCache
- * \brief A class to cache list file contents.
- *
- * cmListFileCache is a class used to cache the contents of parsed
- * cmake list files.
- */
-
 class cmMakefile;
 
 struct cmListFileArgument
@@ -97,6 +89,36 @@ struct cmListFile
   std::vector<cmListFileFunction> Functions;
 };
 
+/** \class cmListFileCache
+ * \brief A class to cache list file contents.
+ *
+ * cmListFileCache is a process-wide cache of the contents of parsed
+ * cmake list files.  Modules such as CMakeParseArguments.cmake are
+ * included many times during a single configure step, so the parsed
+ * functions of each file are kept and re-used as long as the full
+ * path, modification time and size of the file remain unchanged.
+ */
+class cmListFileCache
+{
+public:
+  /** Return the cached functions of the given file, or 0 if the file
+      has not been cached or has changed since it was parsed.  */
+  static std::vector<cmListFileFunction> const*
+  Find(std::string const& path, long int mtime, unsigned long size);
+
+  /** Store the functions of a successfully parsed file.  Files that
+      may still be changing (modified within the last second) are not
+      cached.  */
+  static void Store(std::string const& path, long int mtime,
+                    unsigned long size,
+                    std::vector<cmListFileFunction> const& functions);
+
+  /** Hit/miss statistics for diagnostic output.  */
+  static unsigned long GetNumberOfHits();
+  static unsigned long GetNumberOfMisses();
+  static unsigned long GetNumberOfEntries();
+};
+
 struct cmValueWithOrigin {
   cmValueWithOrigin(const std::string &value,
                           const cmListFileBacktrace &bt)
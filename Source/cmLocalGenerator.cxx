@@ -19,6 +19,7 @@
 #include "cmInstallScriptGenerator.h"
 #include "cmInstallTargetGenerator.h"
 #include "cmMakefile.h"
+#include "cmProfiler.h"
 #include "cmSourceFile.h"
 #include "cmTest.h"
 #include "cmTestGenerator.h"
@@ -99,6 +100,11 @@ void cmLocalGenerator::Configure()
   cmLocalGeneratorCurrent clg(this);
   static_cast<void>(clg);
 
+  // Time the directory and its subdirectories if profiling.
+  cmProfiler::Scope profileScope(
+    this->Makefile->GetCMakeInstance()->GetProfiler(), "configure",
+    this->Makefile->GetStartOutputDirectory());
+
   // make sure the CMakeFiles dir is there
   std::string filesDir = this->Makefile->GetStartOutputDirectory();
   filesDir += cmake::GetCMakeFilesDirectory();
@@ -106,6 +112,7 @@ void cmLocalGenerator::Configure()
 
   // find & read the list file
   this->ReadInputFile();
+  this->Makefile->DiscardTryCompileBatch();
 
   // at the end of the ReadListFile handle any old style subdirs
   // first get all the subdirectories
@@ -21,6 +21,8 @@
 #include "cmCacheManager.h"
 #include "cmFunctionBlocker.h"
 #include "cmListFileCache.h"
+#include "cmProfiler.h"
+#include "cmCoreTryCompile.h"
 #include "cmCommandArgumentParserHelper.h"
 #include "cmGeneratorExpression.h"
 #include "cmTest.h"
@@ -122,6 +124,7 @@ cmMakefile::cmMakefile(const cmMakefile& mf): Internal(new Internals)
   this->ProjectName = mf.ProjectName;
   this->Targets = mf.Targets;
   this->SourceFiles = mf.SourceFiles;
+  this->SourceFileSearchIndex = mf.SourceFileSearchIndex;
   this->Tests = mf.Tests;
   this->LinkDirectories = mf.LinkDirectories;
   this->SystemIncludeDirectories = mf.SystemIncludeDirectories;
@@ -203,6 +206,7 @@ cmMakefile::~cmMakefile()
   cmDeleteAll(this->FinalPassCommands);
   cmDeleteAll(this->FunctionBlockers);
   this->FunctionBlockers.clear();
+  cmDeleteAll(this->TryCompileBatch);
   if (this->PolicyStack.size() != 1)
   {
     cmSystemTools::Error("Internal CMake Error, Policy Stack has not been"
@@ -358,6 +362,10 @@ bool cmMakefile::ExecuteCommand(const cmListFileFunction& lff,
   cmMakefileCall stack_manager(this, lff, status);
   static_cast<void>(stack_manager);
 
+  // Time the call if profiling.
+  cmProfiler::Scope profileScope(this->GetCMakeInstance()->GetProfiler(),
+                                 lff);
+
   // Lookup the command prototype.
   if(cmCommand* proto = this->GetCMakeInstance()->GetCommand(name))
     {
@@ -621,6 +629,10 @@ bool cmMakefile::ReadListFile(const char* filename_in,
       }
     }
 
+  // Time reading and running the file if profiling.
+  cmProfiler::Scope profileScope(this->GetCMakeInstance()->GetProfiler(),
+                                 "listfile", filenametoread);
+
   // push the listfile onto the stack
   this->ListFileStack.push_back(filenametoread);
   if(fullPath!=0)
@@ -3499,13 +3511,32 @@ void cmMakefile::SetArgcArgv(const std::vector<std::string>& args)
   }
 }
 
+//----------------------------------------------------------------------------
+std::string cmMakefile::GetSourceFileSearchKey(std::string const& name)
+{
+  // A name with an ambiguous extension matches a name extended by a
+  // known extension, so only the part before the first '.' can be used.
+  std::string key = cmSystemTools::GetFilenameWithoutExtension(name);
+#if defined(_WIN32) || defined(__APPLE__)
+  // Source file names are compared case-insensitively on these hosts.
+  key = cmSystemTools::LowerCase(key);
+#endif
+  return key;
+}
+
 //----------------------------------------------------------------------------
 cmSourceFile* cmMakefile::GetSource(const std::string& sourceName) const
 {
   cmSourceFileLocation sfl(this, sourceName);
+  SourceFileMap::const_iterator i =
+    this->SourceFileSearchIndex.find(
+      GetSourceFileSearchKey(sfl.GetName()));
+  if(i == this->SourceFileSearchIndex.end())
+    {
+    return 0;
+    }
   for(std::vector<cmSourceFile*>::const_iterator
-        sfi = this->SourceFiles.begin();
-      sfi != this->SourceFiles.end(); ++sfi)
+        sfi = i->second.begin(); sfi != i->second.end(); ++sfi)
     {
     cmSourceFile* sf = *sfi;
     if(sf->Matches(sfl))
@@ -3526,6 +3557,8 @@ cmSourceFile* cmMakefile::CreateSource(const std::string& sourceName,
     sf->SetProperty("GENERATED", "1");
     }
   this->SourceFiles.push_back(sf);
+  this->SourceFileSearchIndex[
+    GetSourceFileSearchKey(sf->GetLocation().GetName())].push_back(sf);
   return sf;
 }
 
@@ -4772,6 +4805,32 @@ void cmMakefile::StoreMatches(cmsys::RegularExpression& re)
   this->MarkVariableAsUsed(nMatchesVariable);
 }
 
+//----------------------------------------------------------------------------
+void cmMakefile::DiscardTryCompileBatch()
+{
+  if(this->TryCompileBatch.empty())
+    {
+    return;
+    }
+  std::ostringstream e;
+  e << "try_compile was called with BATCH but cmake_check_batch(RUN) "
+    << "was not called afterwards in this directory to build the checks "
+    << "with result variables:\n";
+  for(std::vector<cmTryCompileBatchCheck*>::const_iterator
+        ci = this->TryCompileBatch.begin();
+      ci != this->TryCompileBatch.end(); ++ci)
+    {
+    e << "  " << (*ci)->ResultVariable << "\n";
+    if(!this->GetCMakeInstance()->GetDebugTryCompile())
+      {
+      cmSystemTools::RemoveADirectory((*ci)->BinaryDirectory);
+      }
+    }
+  this->IssueMessage(cmake::FATAL_ERROR, e.str());
+  cmDeleteAll(this->TryCompileBatch);
+  this->TryCompileBatch.clear();
+}
+
 //----------------------------------------------------------------------------
 cmPolicies::PolicyStatus
 cmMakefile::GetPolicyStatus(cmPolicies::PolicyID id) const
@@ -49,6 +49,7 @@ class cmVariableWatch;
 class cmake;
 class cmMakefileCall;
 class cmCMakePolicyCommand;
+struct cmTryCompileBatchCheck;
 
 /** \class cmMakefile
  * \brief Process the input CMakeLists.txt file.
@@ -969,6 +970,20 @@ public:
   void ClearMatches();
   void StoreMatches(cmsys::RegularExpression& re);
 
+  /**
+   * Get the checks queued by try_compile(BATCH) in this directory until
+   * cmake_check_batch(RUN) builds them.
+   */
+  std::vector<cmTryCompileBatchCheck*>& GetTryCompileBatch()
+    { return this->TryCompileBatch; }
+
+  /**
+   * Report the checks queued by try_compile(BATCH) that no call to
+   * cmake_check_batch(RUN) built before the end of this directory, and
+   * drop them.
+   */
+  void DiscardTryCompileBatch();
+
 protected:
   // add link libraries and directories to the target
   void AddGlobalLinkInformation(const std::string& name, cmTarget& target);
@@ -1065,6 +1080,8 @@ private:
 
   std::stack<int> LoopBlockCounter;
 
+  std::vector<cmTryCompileBatchCheck*> TryCompileBatch;
+
   std::vector<std::string> MacrosList;
 
   std::map<std::string, bool> SubDirectoryOrder;
@@ -1173,6 +1190,19 @@ private:
   void UpdateOutputToSourceMap(std::string const& output,
                                cmSourceFile* source);
 
+  // Source files indexed by their name up to the first '.'.  All
+  // names a source file may be referenced by share this key, so a
+  // lookup only needs to check the few files in the matching bucket.
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  typedef cmsys::hash_map<std::string, std::vector<cmSourceFile*> >
+    SourceFileMap;
+#else
+  typedef std::map<std::string, std::vector<cmSourceFile*> > SourceFileMap;
+#endif
+  SourceFileMap SourceFileSearchIndex;
+
+  static std::string GetSourceFileSearchKey(std::string const& name);
+
   std::vector<cmSourceFile*> QtUiFilesWithOptions;
 
   bool AddRequiredTargetCFeature(cmTarget *target,
@@ -0,0 +1,153 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2000-2009 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#include "cmProfiler.h"
+
+#include "cmListFileCache.h"
+#include "cmSystemTools.h"
+
+//----------------------------------------------------------------------------
+cmProfiler::cmProfiler(): Stream(0), Origin(0), First(true)
+{
+}
+
+//----------------------------------------------------------------------------
+cmProfiler::~cmProfiler()
+{
+  this->Close();
+}
+
+//----------------------------------------------------------------------------
+bool cmProfiler::Open(std::string const& file)
+{
+  this->Close();
+  this->Stream = new cmsys::ofstream(file.c_str());
+  if(!*this->Stream)
+    {
+    delete this->Stream;
+    this->Stream = 0;
+    return false;
+    }
+  this->Origin = cmSystemTools::GetTime();
+  this->First = true;
+  *this->Stream << "{\"traceEvents\":[";
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void cmProfiler::Close()
+{
+  if(this->Stream)
+    {
+    *this->Stream << "\n]}\n";
+    delete this->Stream;
+    this->Stream = 0;
+    }
+}
+
+//----------------------------------------------------------------------------
+void cmProfiler::AddEvent(const char* category, std::string const& name,
+                          double start, double end, std::string const& args)
+{
+  if(!this->Stream)
+    {
+    return;
+    }
+  cmsys::ofstream& os = *this->Stream;
+  char times[128];
+  sprintf(times, "\"ts\":%.0f,\"dur\":%.0f",
+          (start - this->Origin) * 1e6, (end - start) * 1e6);
+  os << (this->First? "\n" : ",\n");
+  this->First = false;
+  os << "{\"cat\":\"" << category << "\",\"name\":\""
+     << EscapeJSON(name) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":0,"
+     << times;
+  if(!args.empty())
+    {
+    os << ",\"args\":{" << args << "}";
+    }
+  os << "}";
+}
+
+//----------------------------------------------------------------------------
+std::string cmProfiler::EscapeJSON(std::string const& s)
+{
+  std::string result;
+  result.reserve(s.size());
+  for(std::string::const_iterator c = s.begin(); c != s.end(); ++c)
+    {
+    switch(*c)
+      {
+      case '"': result += "\\\""; break;
+      case '\\': result += "\\\\"; break;
+      case '\n': result += "\\n"; break;
+      case '\r': result += "\\r"; break;
+      case '\t': result += "\\t"; break;
+      default:
+        if(static_cast<unsigned char>(*c) < 0x20)
+          {
+          char buf[8];
+          sprintf(buf, "\\u%04x", static_cast<unsigned int>(*c));
+          result += buf;
+          }
+        else
+          {
+          result += *c;
+          }
+        break;
+      }
+    }
+  return result;
+}
+
+//----------------------------------------------------------------------------
+cmProfiler::Scope::Scope(cmProfiler* profiler, const char* category,
+                         const char* name):
+  Profiler(profiler), Category(category), Start(0)
+{
+  if(this->Profiler)
+    {
+    this->Name = name;
+    this->Start = cmSystemTools::GetTime();
+    }
+}
+
+//----------------------------------------------------------------------------
+cmProfiler::Scope::Scope(cmProfiler* profiler, cmListFileFunction const& lff):
+  Profiler(profiler), Category("script"), Start(0)
+{
+  if(this->Profiler)
+    {
+    this->Name = lff.Name;
+    std::ostringstream args;
+    args << "\"location\":\"" << EscapeJSON(lff.FilePath) << ":"
+         << lff.Line << "\",\"functionArgs\":\"";
+    for(std::vector<cmListFileArgument>::const_iterator
+          a = lff.Arguments.begin(); a != lff.Arguments.end(); ++a)
+      {
+      args << (a == lff.Arguments.begin()? "" : " ")
+           << EscapeJSON(a->Value);
+      }
+    args << "\"";
+    this->Args = args.str();
+    this->Start = cmSystemTools::GetTime();
+    }
+}
+
+//----------------------------------------------------------------------------
+cmProfiler::Scope::~Scope()
+{
+  if(this->Profiler)
+    {
+    this->Profiler->AddEvent(this->Category, this->Name, this->Start,
+                             cmSystemTools::GetTime(), this->Args);
+    }
+}
@@ -0,0 +1,73 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2000-2009 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#ifndef cmProfiler_h
+#define cmProfiler_h
+
+#include "cmStandardIncludes.h"
+
+#include <cmsys/FStream.hxx>
+
+struct cmListFileFunction;
+
+/** \class cmProfiler
+ * \brief Record where the time of a cmake run goes.
+ *
+ * cmProfiler writes one event per timed region to a file in the
+ * Chrome trace event format, which about:tracing and similar viewers
+ * load directly.  Events are written as the regions end, so memory use
+ * does not grow with the length of the run.  Code times a region by
+ * creating a cmProfiler::Scope, which does nothing when the profiler
+ * it is given is null.
+ */
+class cmProfiler
+{
+public:
+  cmProfiler();
+  ~cmProfiler();
+
+  /** Start writing events to the given file.  */
+  bool Open(std::string const& file);
+
+  /** Write an event for a region that has ended.  The times are in
+      seconds as returned by cmSystemTools::GetTime and the arguments,
+      if any, are the members of a JSON object.  */
+  void AddEvent(const char* category, std::string const& name,
+                double start, double end, std::string const& args);
+
+  /** Time the region from construction to destruction.  The name is
+      copied only when profiling so callers need not build a string.  */
+  class Scope
+  {
+  public:
+    Scope(cmProfiler* profiler, const char* category, const char* name);
+    Scope(cmProfiler* profiler, cmListFileFunction const& lff);
+    ~Scope();
+  private:
+    cmProfiler* Profiler;
+    const char* Category;
+    std::string Name;
+    std::string Args;
+    double Start;
+  };
+
+  static std::string EscapeJSON(std::string const& s);
+private:
+  cmProfiler(cmProfiler const&); // Not implemented.
+  void operator=(cmProfiler const&); // Not implemented.
+  void Close();
+
+  cmsys::ofstream* Stream;
+  double Origin;
+  bool First;
+};
+
+#endif
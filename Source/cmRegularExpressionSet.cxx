@@ -0,0 +1,184 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2000-2009 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#include "cmRegularExpressionSet.h"
+
+//----------------------------------------------------------------------------
+static unsigned int cmRegularExpressionSetKey(const char* s)
+{
+  return (static_cast<unsigned int>(static_cast<unsigned char>(s[0])) << 8) |
+    static_cast<unsigned int>(static_cast<unsigned char>(s[1]));
+}
+
+//----------------------------------------------------------------------------
+cmRegularExpressionSet::cmRegularExpressionSet()
+{
+  this->HasLiteralStart.resize(1 << 16, false);
+}
+
+//----------------------------------------------------------------------------
+void cmRegularExpressionSet::Add(std::string const& expr)
+{
+  size_t index = this->Expressions.size();
+  this->Expressions.push_back(cmsys::RegularExpression());
+  this->Expressions.back().compile(expr.c_str());
+  this->Candidates.push_back(false);
+
+  // Literals of a single character would not filter much.
+  std::string literal = GetRequiredLiteral(expr);
+  if(literal.size() < 2)
+    {
+    literal = "";
+    }
+  else
+    {
+    unsigned int key = cmRegularExpressionSetKey(literal.c_str());
+    this->LiteralStarts[key].push_back(index);
+    this->HasLiteralStart[key] = true;
+    }
+  this->Literals.push_back(literal);
+}
+
+//----------------------------------------------------------------------------
+void cmRegularExpressionSet::Clear()
+{
+  this->Expressions.clear();
+  this->Literals.clear();
+  this->LiteralStarts.clear();
+  this->HasLiteralStart.assign(this->HasLiteralStart.size(), false);
+  this->Candidates.clear();
+}
+
+//----------------------------------------------------------------------------
+int cmRegularExpressionSet::Find(const char* line)
+{
+  // Scan the line once for the literals of all expressions.
+  this->Candidates.assign(this->Candidates.size(), false);
+  if(!this->LiteralStarts.empty() && line[0])
+    {
+    for(const char* p = line; p[1]; ++p)
+      {
+      unsigned int key = cmRegularExpressionSetKey(p);
+      if(!this->HasLiteralStart[key])
+        {
+        continue;
+        }
+      std::vector<size_t> const& starts = this->LiteralStarts[key];
+      for(std::vector<size_t>::const_iterator i = starts.begin();
+          i != starts.end(); ++i)
+        {
+        std::string const& literal = this->Literals[*i];
+        if(!this->Candidates[*i] &&
+           strncmp(p, literal.c_str(), literal.size()) == 0)
+          {
+          this->Candidates[*i] = true;
+          }
+        }
+      }
+    }
+
+  // Try the remaining expressions in order.
+  for(size_t i = 0; i < this->Expressions.size(); ++i)
+    {
+    if((this->Literals[i].empty() || this->Candidates[i]) &&
+       this->Expressions[i].is_valid() && this->Expressions[i].find(line))
+      {
+      return static_cast<int>(i);
+      }
+    }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+std::string cmRegularExpressionSet::GetRequiredLiteral(std::string const& e)
+{
+  // Follow the syntax of cmsys::RegularExpression.  Characters that
+  // must appear next to each other in every match form a run.  Groups
+  // are skipped because they may be optional or contain alternatives.
+  std::string best;
+  std::string run;
+  int depth = 0;
+  const char* p = e.c_str();
+  while(*p)
+    {
+    char c = *p++;
+    bool literal = false;
+    switch(c)
+      {
+      case '\\':
+        if(!*p)
+          {
+          return "";
+          }
+        c = *p++;
+        literal = true;
+        break;
+      case '[':
+        if(*p == '^')
+          {
+          ++p;
+          }
+        if(*p == ']' || *p == '-')
+          {
+          ++p;
+          }
+        while(*p && *p != ']')
+          {
+          ++p;
+          }
+        if(*p)
+          {
+          ++p;
+          }
+        break;
+      case '(':
+        ++depth;
+        break;
+      case ')':
+        --depth;
+        break;
+      case '|':
+        if(depth == 0)
+          {
+          // Every alternative would need its own literal.
+          return "";
+          }
+        break;
+      case '^': case '$': case '.':
+      case '*': case '+': case '?':
+        break;
+      default:
+        literal = true;
+        break;
+      }
+
+    if(literal && depth == 0 && *p != '*' && *p != '?')
+      {
+      run += c;
+      if(*p != '+')
+        {
+        continue;
+        }
+      }
+
+    // The run ends here.
+    if(run.size() > best.size())
+      {
+      best = run;
+      }
+    run = "";
+    }
+  if(run.size() > best.size())
+    {
+    best = run;
+    }
+  return best;
+}
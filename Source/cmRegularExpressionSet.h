@@ -0,0 +1,60 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2000-2009 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#ifndef cmRegularExpressionSet_h
+#define cmRegularExpressionSet_h
+
+#include "cmStandardIncludes.h"
+
+#include <cmsys/RegularExpression.hxx>
+
+/** \class cmRegularExpressionSet
+ * \brief Find the first of several regular expressions matching a line.
+ *
+ * Most lines scanned against a list of expressions match none of them.
+ * cmRegularExpressionSet computes for each expression a literal string
+ * that every match must contain and scans a line once for all these
+ * strings.  Only expressions whose literal occurs in the line, or that
+ * have no literal, are then tried in the order they were added.
+ */
+class cmRegularExpressionSet
+{
+public:
+  cmRegularExpressionSet();
+
+  /** Add an expression at the end of the set.  An expression that does
+      not compile never matches.  */
+  void Add(std::string const& expr);
+  void Clear();
+  size_t GetSize() const { return this->Expressions.size(); }
+
+  /** Get the index of the first expression in the set that matches
+      somewhere in the given line, or -1 if none does.  */
+  int Find(const char* line);
+
+  /** Get a string that every match of the given expression contains.
+      Returns an empty string if no such string is known.  */
+  static std::string GetRequiredLiteral(std::string const& expr);
+
+private:
+  std::vector<cmsys::RegularExpression> Expressions;
+  std::vector<std::string> Literals;
+
+  // Expressions indexed by the first two bytes of their literal.
+  typedef std::map<unsigned int, std::vector<size_t> > LiteralMapType;
+  LiteralMapType LiteralStarts;
+  std::vector<bool> HasLiteralStart;
+
+  // Expressions whose literal occurs in the line being scanned.
+  std::vector<bool> Candidates;
+};
+
+#endif
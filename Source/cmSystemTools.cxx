@@ -2056,6 +2056,12 @@ bool cmSystemTools::FileTimeSet(const char* fname, cmSystemToolsFileTime* t)
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool cmSystemTools::IsModifiedTimeSettled(long mtime)
+{
+  return static_cast<long>(time(0)) - mtime >= 2;
+}
+
 //----------------------------------------------------------------------------
 #ifdef _WIN32
 # ifndef CRYPT_SILENT
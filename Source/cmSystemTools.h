@@ -414,6 +414,12 @@ public:
   static bool FileTimeGet(const char* fname, cmSystemToolsFileTime* t);
   static bool FileTimeSet(const char* fname, cmSystemToolsFileTime* t);
 
+  /** Return whether a file modification time is old enough to detect
+      the next change of the file.  Time stamps have a resolution of one
+      second, so a file written during the current second may be written
+      again without a change in its time stamp.  */
+  static bool IsModifiedTimeSettled(long mtime);
+
   /** Random seed generation.  */
   static unsigned int RandomSeed();
 
@@ -198,6 +198,25 @@ public:
   std::set<cmLinkItem> UtilityItems;
   bool UtilityItemsDone;
 
+  // Cache usage requirements computed while generating the build system
+  // for each configuration and language.  An entry is valid only while
+  // no target property changed since it was computed.
+  struct UsageRequirements
+  {
+    UsageRequirements(): Generation(0) {}
+    std::vector<std::string> Values;
+    unsigned long Generation;
+  };
+  typedef std::map<std::pair<std::string, std::string>,
+                   UsageRequirements> UsageRequirementsMapType;
+  UsageRequirementsMapType IncludeDirectoriesMap;
+  UsageRequirementsMapType CompileOptionsMap;
+  UsageRequirementsMapType CompileDefinitionsMap;
+  UsageRequirements* GetUsageRequirements(cmTarget const* thisTarget,
+                                          UsageRequirementsMapType& map,
+                                          std::string const& config,
+                                          std::string const& language);
+
   class TargetPropertyEntry {
     static cmLinkImplItem NoLinkImplItem;
   public:
@@ -222,6 +241,11 @@ public:
 
 cmLinkImplItem cmTargetInternals::TargetPropertyEntry::NoLinkImplItem;
 
+// Incremented whenever a property of any target changes.  Usage
+// requirements of a target depend on the properties of all targets in
+// its link closure, so a change anywhere invalidates every cached entry.
+static unsigned long cmTargetPropertyGeneration = 1;
+
 //----------------------------------------------------------------------------
 static void deleteAndClear(
       std::vector<cmTargetInternals::TargetPropertyEntry*> &entries)
@@ -539,6 +563,9 @@ void cmTarget::ClearLinkMaps()
   this->Internal->LinkInterfaceUsageRequirementsOnlyMap.clear();
   this->Internal->LinkClosureMap.clear();
   this->Internal->SourceFilesMap.clear();
+  this->Internal->IncludeDirectoriesMap.clear();
+  this->Internal->CompileOptionsMap.clear();
+  this->Internal->CompileDefinitionsMap.clear();
   cmDeleteAll(this->LinkInformation);
   this->LinkInformation.clear();
 }
@@ -1795,8 +1822,8 @@ void cmTarget::SetProperty(const std::string& prop, const char* value)
   else
     {
     this->Properties.SetProperty(prop, value, cmProperty::TARGET);
-    this->MaybeInvalidatePropertyCache(prop);
     }
+  this->MaybeInvalidatePropertyCache(prop);
 }
 
 //----------------------------------------------------------------------------
@@ -1880,8 +1907,8 @@ void cmTarget::AppendProperty(const std::string& prop, const char* value,
   else
     {
     this->Properties.AppendProperty(prop, value, cmProperty::TARGET, asString);
-    this->MaybeInvalidatePropertyCache(prop);
     }
+  this->MaybeInvalidatePropertyCache(prop);
 }
 
 //----------------------------------------------------------------------------
@@ -1948,6 +1975,7 @@ void cmTarget::InsertInclude(const cmValueWithOrigin &entry,
 
   this->Internal->IncludeDirectoriesEntries.insert(position,
       new cmTargetInternals::TargetPropertyEntry(ge.Parse(entry.Value)));
+  ++cmTargetPropertyGeneration;
 }
 
 //----------------------------------------------------------------------------
@@ -1962,6 +1990,7 @@ void cmTarget::InsertCompileOption(const cmValueWithOrigin &entry,
 
   this->Internal->CompileOptionsEntries.insert(position,
       new cmTargetInternals::TargetPropertyEntry(ge.Parse(entry.Value)));
+  ++cmTargetPropertyGeneration;
 }
 
 //----------------------------------------------------------------------------
@@ -1971,6 +2000,7 @@ void cmTarget::InsertCompileDefinition(const cmValueWithOrigin &entry)
 
   this->Internal->CompileDefinitionsEntries.push_back(
       new cmTargetInternals::TargetPropertyEntry(ge.Parse(entry.Value)));
+  ++cmTargetPropertyGeneration;
 }
 
 //----------------------------------------------------------------------------
@@ -2105,11 +2135,75 @@ static void processIncludeDirectories(cmTarget const* tgt,
     }
 }
 
+//----------------------------------------------------------------------------
+cmTargetInternals::UsageRequirements*
+cmTargetInternals::GetUsageRequirements(cmTarget const* thisTarget,
+                                        UsageRequirementsMapType& map,
+                                        std::string const& config,
+                                        std::string const& language)
+{
+  // Properties are still being populated while configuring.
+  if(!thisTarget->GetMakefile()->IsGeneratingBuildSystem())
+    {
+    return 0;
+    }
+  return &map[std::make_pair(config, language)];
+}
+
+//----------------------------------------------------------------------------
+static bool cmTargetUseUsageRequirements(
+  cmTargetInternals::UsageRequirements const* entry)
+{
+  if(entry && entry->Generation == cmTargetPropertyGeneration)
+    {
+    ++cmTarget::GetUsageRequirementsStatistics().Reused;
+    return true;
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+static void cmTargetStoreUsageRequirements(
+  cmTargetInternals::UsageRequirements* entry,
+  std::vector<std::string> const& values, unsigned long generation)
+{
+  if(!entry)
+    {
+    return;
+    }
+  ++cmTarget::GetUsageRequirementsStatistics().Computed;
+  // Keep results only if evaluation succeeded so that errors are
+  // reported by every query.
+  if(!cmSystemTools::GetErrorOccuredFlag())
+    {
+    entry->Values = values;
+    entry->Generation = generation;
+    }
+}
+
+//----------------------------------------------------------------------------
+cmTarget::UsageRequirementsStatistics&
+cmTarget::GetUsageRequirementsStatistics()
+{
+  static UsageRequirementsStatistics stats;
+  return stats;
+}
+
 //----------------------------------------------------------------------------
 std::vector<std::string>
 cmTarget::GetIncludeDirectories(const std::string& config,
                                 const std::string& language) const
 {
+  cmTargetInternals::UsageRequirements* cached =
+    this->Internal->GetUsageRequirements(this,
+                                         this->Internal->IncludeDirectoriesMap,
+                                         config, language);
+  if(cmTargetUseUsageRequirements(cached))
+    {
+    return cached->Values;
+    }
+  unsigned long generation = cmTargetPropertyGeneration;
+
   std::vector<std::string> includes;
   UNORDERED_SET<std::string> uniqueIncludes;
 
@@ -2187,6 +2281,7 @@ cmTarget::GetIncludeDirectories(const std::string& config,
 
   deleteAndClear(linkInterfaceIncludeDirectoriesEntries);
 
+  cmTargetStoreUsageRequirements(cached, includes, generation);
   return includes;
 }
 
@@ -2282,6 +2377,18 @@ void cmTarget::GetCompileOptions(std::vector<std::string> &result,
                                  const std::string& config,
                                  const std::string& language) const
 {
+  cmTargetInternals::UsageRequirements* cached =
+    this->Internal->GetUsageRequirements(this,
+                                         this->Internal->CompileOptionsMap,
+                                         config, language);
+  if(cmTargetUseUsageRequirements(cached))
+    {
+    result.insert(result.end(), cached->Values.begin(), cached->Values.end());
+    return;
+    }
+  unsigned long generation = cmTargetPropertyGeneration;
+  std::vector<std::string> options;
+
   UNORDERED_SET<std::string> uniqueOptions;
 
   cmGeneratorExpressionDAGChecker dagChecker(this->GetName(),
@@ -2308,7 +2415,7 @@ void cmTarget::GetCompileOptions(std::vector<std::string> &result,
 
   processCompileOptions(this,
                             this->Internal->CompileOptionsEntries,
-                            result,
+                            options,
                             uniqueOptions,
                             &dagChecker,
                             config,
@@ -2324,7 +2431,7 @@ void cmTarget::GetCompileOptions(std::vector<std::string> &result,
 
   processCompileOptions(this,
                         linkInterfaceCompileOptionsEntries,
-                            result,
+                            options,
                             uniqueOptions,
                             &dagChecker,
                             config,
@@ -2332,6 +2439,9 @@ void cmTarget::GetCompileOptions(std::vector<std::string> &result,
                             language);
 
   deleteAndClear(linkInterfaceCompileOptionsEntries);
+
+  cmTargetStoreUsageRequirements(cached, options, generation);
+  result.insert(result.end(), options.begin(), options.end());
 }
 
 //----------------------------------------------------------------------------
@@ -2353,6 +2463,18 @@ void cmTarget::GetCompileDefinitions(std::vector<std::string> &list,
                                             const std::string& config,
                                             const std::string& language) const
 {
+  cmTargetInternals::UsageRequirements* cached =
+    this->Internal->GetUsageRequirements(this,
+                                         this->Internal->CompileDefinitionsMap,
+                                         config, language);
+  if(cmTargetUseUsageRequirements(cached))
+    {
+    list.insert(list.end(), cached->Values.begin(), cached->Values.end());
+    return;
+    }
+  unsigned long generation = cmTargetPropertyGeneration;
+  std::vector<std::string> definitions;
+
   UNORDERED_SET<std::string> uniqueOptions;
 
   cmGeneratorExpressionDAGChecker dagChecker(this->GetName(),
@@ -2379,7 +2501,7 @@ void cmTarget::GetCompileDefinitions(std::vector<std::string> &list,
 
   processCompileDefinitions(this,
                             this->Internal->CompileDefinitionsEntries,
-                            list,
+                            definitions,
                             uniqueOptions,
                             &dagChecker,
                             config,
@@ -2427,7 +2549,7 @@ void cmTarget::GetCompileDefinitions(std::vector<std::string> &list,
 
   processCompileDefinitions(this,
                             linkInterfaceCompileDefinitionsEntries,
-                            list,
+                            definitions,
                             uniqueOptions,
                             &dagChecker,
                             config,
@@ -2435,6 +2557,9 @@ void cmTarget::GetCompileDefinitions(std::vector<std::string> &list,
                             language);
 
   deleteAndClear(linkInterfaceCompileDefinitionsEntries);
+
+  cmTargetStoreUsageRequirements(cached, definitions, generation);
+  list.insert(list.end(), definitions.begin(), definitions.end());
 }
 
 //----------------------------------------------------------------------------
@@ -2507,6 +2632,9 @@ void cmTarget::GetCompileFeatures(std::vector<std::string> &result,
 //----------------------------------------------------------------------------
 void cmTarget::MaybeInvalidatePropertyCache(const std::string& prop)
 {
+  // Any property may contribute to the usage requirements of a target.
+  ++cmTargetPropertyGeneration;
+
   // Wipe out maps caching information affected by this property.
   if(this->IsImported() && cmHasLiteralPrefix(prop, "IMPORTED"))
     {
@@ -586,6 +586,17 @@ public:
   void GetCompileFeatures(std::vector<std::string> &features,
                           const std::string& config) const;
 
+  /** Counters describing how often the include directories, compile
+   *  options and compile definitions of a target were computed and how
+   *  often an earlier result was reused while generating.  */
+  struct UsageRequirementsStatistics
+  {
+    UsageRequirementsStatistics(): Computed(0), Reused(0) {}
+    unsigned long Computed;
+    unsigned long Reused;
+  };
+  static UsageRequirementsStatistics& GetUsageRequirementsStatistics();
+
   bool IsNullImpliedByLinkLibraries(const std::string &p) const;
   bool IsLinkInterfaceDependentBoolProperty(const std::string &p,
                          const std::string& config) const;
@@ -31,7 +31,7 @@ bool cmTryCompileCommand
   this->TryCompileCode(argv);
 
   // if They specified clean then we clean up what we can
-  if (this->SrcFileSignature)
+  if (this->SrcFileSignature && !this->Queued)
     {
     if(!this->Makefile->GetCMakeInstance()->GetDebugTryCompile())
       {
@@ -95,6 +95,13 @@ bool cmTryRunCommand
         i++;
         this->CompileOutputVariable = argv[i];
         }
+      else if (argv[i] == "BATCH")
+        {
+        cmSystemTools::Error(
+          "BATCH may not be used with TRY_RUN because the executable "
+          "must be run right away.");
+        return false;
+        }
       else
         {
         tryCompile.push_back(argv[i]);
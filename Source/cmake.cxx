@@ -20,6 +20,7 @@
 #include "cmSourceFile.h"
 #include "cmTest.h"
 #include "cmDocumentationFormatter.h"
+#include "cmProfiler.h"
 
 #if defined(CMAKE_BUILD_WITH_CMAKE)
 # include "cmGraphVizWriter.h"
@@ -107,6 +108,10 @@
 
 static bool cmakeCheckStampFile(const char* stampName);
 static bool cmakeCheckStampList(const char* stampName);
+static bool cmakeCheckBuildSystemStamp(std::string const& stampName);
+static void cmakeWriteBuildSystemStamp(std::string const& stampName,
+                                       std::vector<std::string> const& files,
+                                       std::vector<std::string> const& prods);
 
 void cmWarnUnusedCliWarning(const std::string& variable,
   int, void* ctx, const char*, const cmMakefile*)
@@ -118,6 +123,7 @@ void cmWarnUnusedCliWarning(const std::string& variable,
 cmake::cmake()
 {
   this->Trace = false;
+  this->Profiler = 0;
   this->WarnUninitialized = false;
   this->WarnUnused = false;
   this->WarnUnusedCli = true;
@@ -166,6 +172,7 @@ cmake::cmake()
 
 cmake::~cmake()
 {
+  delete this->Profiler;
   delete this->CacheManager;
   delete this->Policies;
   if (this->GlobalGenerator)
@@ -740,6 +747,20 @@ void cmake::SetArgs(const std::vector<std::string>& args,
       std::cout << "Running with trace output on.\n";
       this->SetTrace(true);
       }
+    else if(arg.find("--profile=",0) == 0)
+      {
+      std::string path = arg.substr(strlen("--profile="));
+      path = cmSystemTools::CollapseFullPath(path);
+      delete this->Profiler;
+      this->Profiler = new cmProfiler;
+      if(path.empty() || !this->Profiler->Open(path))
+        {
+        cmSystemTools::Error("Could not open profile output file: ",
+                             path.c_str());
+        delete this->Profiler;
+        this->Profiler = 0;
+        }
+      }
     else if(arg.find("--warn-uninitialized",0) == 0)
       {
       std::cout << "Warn about uninitialized values.\n";
@@ -1531,7 +1552,19 @@ int cmake::ActualConfigure()
     }
 
   // actually do the configure
+  {
+  cmProfiler::Scope profileScope(this->Profiler, "cmake", "Configure");
   this->GlobalGenerator->Configure();
+  }
+  if(this->GetTrace() && !this->InTryCompile)
+    {
+    std::ostringstream msg;
+    msg << "List file cache: "
+        << cmListFileCache::GetNumberOfHits() << " hits, "
+        << cmListFileCache::GetNumberOfMisses() << " misses, "
+        << cmListFileCache::GetNumberOfEntries() << " files cached";
+    cmSystemTools::Message(msg.str().c_str());
+    }
   // Before saving the cache
   // if the project did not define one of the entries below, add them now
   // so users can edit the values in the cache:
@@ -1653,6 +1686,16 @@ int cmake::Run(const std::vector<std::string>& args, bool noconfigure)
     return 0;
     }
 
+  // If no input of the build system changed since the last check that
+  // passed, skip loading the cache and reading the check file.
+  if(!this->CheckBuildSystemArgument.empty() && !this->ClearBuildSystem &&
+     cmakeCheckBuildSystemStamp(
+       cmSystemTools::CollapseFullPath(this->CheckBuildSystemArgument) +
+       ".stamp"))
+    {
+    return 0;
+    }
+
   if ( this->GetWorkingMode() == NORMAL_MODE )
     {
     // load the cache
@@ -1757,7 +1800,10 @@ int cmake::Generate()
     {
     return -1;
     }
+  {
+  cmProfiler::Scope profileScope(this->Profiler, "cmake", "Generate");
   this->GlobalGenerator->DoGenerate();
+  }
   if ( !this->GraphVizFile.empty() )
     {
     std::cout << "Generate graphviz: " << this->GraphVizFile << std::endl;
@@ -1778,6 +1824,22 @@ int cmake::Generate()
     {
     this->CacheManager->SaveCache(this->GetHomeOutputDirectory());
     }
+  // Check the new build system once so that its inputs are stamped
+  // before the build tool first checks it.
+  std::string checkFile = this->GlobalGenerator->GetBuildSystemCheckFile();
+  if(!checkFile.empty() && !this->GetIsInTryCompile() &&
+     this->GetWorkingMode() == NORMAL_MODE)
+    {
+    std::string checkArgument = this->CheckBuildSystemArgument;
+    bool clearBuildSystem = this->ClearBuildSystem;
+    this->CheckBuildSystemArgument = checkFile;
+    this->ClearBuildSystem = false;
+    delete this->FileComparison;
+    this->FileComparison = new cmFileTimeComparison;
+    this->CheckBuildSystem();
+    this->CheckBuildSystemArgument = checkArgument;
+    this->ClearBuildSystem = clearBuildSystem;
+    }
   return 0;
 }
 
@@ -2057,6 +2119,20 @@ int cmake::CheckBuildSystem()
     cmSystemTools::ExpandListArgument(dependsStr, depends);
     cmSystemTools::ExpandListArgument(outputsStr, outputs);
     }
+  if(!this->HomeOutputDirectory.empty())
+    {
+    // Paths in the check file are relative to the top of the build tree.
+    std::string const& home = this->HomeOutputDirectory;
+    std::vector<std::string>* lists[] = { &products, &depends, &outputs };
+    for(size_t l = 0; l < sizeof(lists) / sizeof(lists[0]); ++l)
+      {
+      for(std::vector<std::string>::iterator i = lists[l]->begin();
+          i != lists[l]->end(); ++i)
+        {
+        *i = cmSystemTools::CollapseFullPath(*i, home);
+        }
+      }
+    }
   if(depends.empty() || outputs.empty())
     {
     // Not enough information was provided to do the test.  Just rerun.
@@ -2141,6 +2217,16 @@ int cmake::CheckBuildSystem()
     }
   }
 
+  // Record the inputs of this check so the next one can skip reading
+  // the check file as long as none of them changes.
+  std::vector<std::string> files = depends;
+  files.insert(files.end(), outputs.begin(), outputs.end());
+  files.push_back(
+    cmSystemTools::CollapseFullPath(this->CheckBuildSystemArgument));
+  cmakeWriteBuildSystemStamp(
+    cmSystemTools::CollapseFullPath(this->CheckBuildSystemArgument) +
+    ".stamp", files, products);
+
   // No need to rerun.
   return 0;
 }
@@ -2607,6 +2693,154 @@ static bool cmakeCheckStampList(const char* stampList)
   return true;
 }
 
+//----------------------------------------------------------------------------
+// The build system stamp written next to the --check-build-system file
+// lists every input of the check with the time and size it had when the
+// check last passed.  Numbers are stored little-endian.
+static const char cmakeBuildSystemStampSignature[] = "CMSTAMP1";
+
+//----------------------------------------------------------------------------
+static void cmakeStampAppend(std::string& out, cmIML_INT_uint64_t value,
+                             int bytes)
+{
+  for(int i = 0; i < bytes; ++i)
+    {
+    out += static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+//----------------------------------------------------------------------------
+static bool cmakeStampRead(std::string const& in, size_t& pos,
+                           cmIML_INT_uint64_t& value, int bytes)
+{
+  if(in.size() - pos < static_cast<size_t>(bytes))
+    {
+    return false;
+    }
+  value = 0;
+  for(int i = 0; i < bytes; ++i)
+    {
+    value |= static_cast<cmIML_INT_uint64_t>(
+      static_cast<unsigned char>(in[pos++])) << (8 * i);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+static void cmakeWriteBuildSystemStamp(std::string const& stampName,
+                                       std::vector<std::string> const& files,
+                                       std::vector<std::string> const& prods)
+{
+  // Entries of kind 'f' must keep their time and size.  Entries of
+  // kind 'p' only have to exist.
+  std::string data = cmakeBuildSystemStampSignature;
+  cmFileTimeComparison ftc;
+  for(size_t i = 0; i < files.size() + prods.size(); ++i)
+    {
+    bool isFile = i < files.size();
+    std::string const& f = isFile? files[i] : prods[i - files.size()];
+    cmIML_INT_int64_t time = 0;
+    cmIML_INT_int64_t size = 0;
+    if(isFile && !ftc.GetFileTimeAndSize(f.c_str(), &time, &size))
+      {
+      // The stamp could never match.
+      cmSystemTools::RemoveFile(stampName);
+      return;
+      }
+    data += isFile? 'f' : 'p';
+    cmakeStampAppend(data, static_cast<cmIML_INT_uint64_t>(time), 8);
+    cmakeStampAppend(data, static_cast<cmIML_INT_uint64_t>(size), 8);
+    cmakeStampAppend(data, f.size(), 4);
+    data += f;
+    }
+
+  // Replace the stamp atomically so a concurrent check never reads
+  // a partial file.
+  std::ostringstream stampTempStream;
+  stampTempStream << stampName << ".tmp" << cmSystemTools::RandomSeed();
+  std::string stampTemp = stampTempStream.str();
+  {
+  cmsys::ofstream fout(stampTemp.c_str(), std::ios::out | std::ios::binary);
+  fout.write(data.data(), static_cast<std::streamsize>(data.size()));
+  if(!fout)
+    {
+    fout.close();
+    cmSystemTools::RemoveFile(stampTemp);
+    cmSystemTools::RemoveFile(stampName);
+    return;
+    }
+  }
+  if(!cmSystemTools::RenameFile(stampTemp.c_str(), stampName.c_str()))
+    {
+    cmSystemTools::RemoveFile(stampTemp);
+    cmSystemTools::RemoveFile(stampName);
+    }
+}
+
+//----------------------------------------------------------------------------
+static bool cmakeCheckBuildSystemStamp(std::string const& stampName)
+{
+  cmsys::ifstream fin(stampName.c_str(), std::ios::in | std::ios::binary);
+  if(!fin)
+    {
+    return false;
+    }
+  std::ostringstream content;
+  content << fin.rdbuf();
+  std::string const data = content.str();
+  size_t const sigLen = sizeof(cmakeBuildSystemStampSignature) - 1;
+  if(data.compare(0, sigLen, cmakeBuildSystemStampSignature) != 0)
+    {
+    return false;
+    }
+
+  // Check every entry with a single stat and no list file parsing.
+  cmFileTimeComparison ftc;
+  size_t pos = sigLen;
+  size_t entries = 0;
+  while(pos < data.size())
+    {
+    char kind = data[pos++];
+    cmIML_INT_uint64_t time;
+    cmIML_INT_uint64_t size;
+    cmIML_INT_uint64_t len;
+    if(!cmakeStampRead(data, pos, time, 8) ||
+       !cmakeStampRead(data, pos, size, 8) ||
+       !cmakeStampRead(data, pos, len, 4) ||
+       data.size() - pos < len)
+      {
+      return false;
+      }
+    std::string f = data.substr(pos, static_cast<size_t>(len));
+    pos += static_cast<size_t>(len);
+    if(kind == 'f')
+      {
+      cmIML_INT_int64_t t;
+      cmIML_INT_int64_t s;
+      if(!ftc.GetFileTimeAndSize(f.c_str(), &t, &s) ||
+         static_cast<cmIML_INT_uint64_t>(t) != time ||
+         static_cast<cmIML_INT_uint64_t>(s) != size)
+        {
+        return false;
+        }
+      }
+    else if(kind == 'p')
+      {
+      if(!(cmSystemTools::FileExists(f.c_str()) ||
+           cmSystemTools::FileIsSymlink(f)))
+        {
+        return false;
+        }
+      }
+    else
+      {
+      return false;
+      }
+    ++entries;
+    }
+  return entries > 0;
+}
+
 //----------------------------------------------------------------------------
 void cmake::IssueMessage(cmake::MessageType t, std::string const& text,
                          cmListFileBacktrace const& bt)
@@ -32,6 +32,7 @@ class cmDocumentationSection;
 class cmPolicies;
 class cmTarget;
 class cmGeneratedFileStream;
+class cmProfiler;
 
 /** \brief Represents a cmake invocation.
  *
@@ -326,6 +327,9 @@ class cmake
   // Do we want trace output during the cmake run.
   bool GetTrace() { return this->Trace;}
   void SetTrace(bool b) {  this->Trace = b;}
+
+  // The profiler recording the cmake run, or 0 if not profiling.
+  cmProfiler* GetProfiler() { return this->Profiler; }
   bool GetWarnUninitialized() { return this->WarnUninitialized;}
   void SetWarnUninitialized(bool b) {  this->WarnUninitialized = b;}
   bool GetWarnUnused() { return this->WarnUnused;}
@@ -448,6 +452,7 @@ private:
   WorkingMode CurrentWorkingMode;
   bool DebugOutput;
   bool Trace;
+  cmProfiler* Profiler;
   bool WarnUninitialized;
   bool WarnUnused;
   bool WarnUnusedCli;
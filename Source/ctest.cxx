@@ -75,6 +75,9 @@ static const char * cmDocumentationOptions[][2] =
    "Run a specific number of tests by number."},
   {"-U, --union", "Take the Union of -I and -R"},
   {"--rerun-failed", "Run only the tests that failed previously"},
+  {"--skip-unchanged", "Skip tests that passed before with the same inputs"},
+  {"--shard <index>/<count>", "Run one of <count> parts of the tests "
+   "balanced by their recorded times."},
   {"--max-width <width>", "Set the max width for a test name to output"},
   {"--interactive-debug-mode [0|1]", "Set the interactive mode to 0 or 1."},
   {"--no-label-summary", "Disable timing summary information for labels."},
@@ -0,0 +1,160 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2000-2009 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#include "cmDefinitions.h"
+#include "cmSystemTools.h"
+
+#include <list>
+
+#define cmFailed(m) std::cout << "FAILED: " << m << "\n"; failed=1
+
+//----------------------------------------------------------------------------
+static bool checkValue(cmDefinitions& defs, const char* key,
+                       const char* expect)
+{
+  const char* value = defs.Get(key);
+  if(!value || !expect)
+    {
+    return value == expect;
+    }
+  return strcmp(value, expect) == 0;
+}
+
+//----------------------------------------------------------------------------
+static int testScopes()
+{
+  int failed = 0;
+
+  cmDefinitions top;
+  top.Set("A", "a");
+  top.Set("B", "b");
+  top.Set("C", 0);
+
+  cmDefinitions child(&top);
+  child.Set("B", "child-b");
+  child.Set("A", 0);
+  child.Set("D", "d");
+  if(!checkValue(child, "A", 0) ||
+     !checkValue(child, "B", "child-b") ||
+     !checkValue(child, "D", "d"))
+    {
+    cmFailed("child scope does not see its own definitions");
+    }
+
+  cmDefinitions grandChild(&child);
+  if(!checkValue(grandChild, "A", 0) ||
+     !checkValue(grandChild, "B", "child-b") ||
+     !checkValue(grandChild, "C", 0))
+    {
+    cmFailed("nested scope does not see parent definitions");
+    }
+
+  if(!checkValue(top, "A", "a") ||
+     !checkValue(top, "B", "b") ||
+     !checkValue(top, "D", 0))
+    {
+    cmFailed("child definitions leaked into the parent scope");
+    }
+
+  // A value looked up from a parent must stay valid after the parent
+  // changes it.
+  const char* b = grandChild.Get("B");
+  grandChild.Get("B");
+  child.Set("B", "changed");
+  if(!checkValue(grandChild, "B", "child-b") || strcmp(b, "child-b") != 0)
+    {
+    cmFailed("looked up value changed with the parent scope");
+    }
+
+  cmDefinitions closure = grandChild.Closure();
+  if(closure.GetParent() ||
+     !checkValue(closure, "A", 0) ||
+     !checkValue(closure, "B", "child-b") ||
+     !checkValue(closure, "D", "d"))
+    {
+    cmFailed("closure does not match the flattened scope");
+    }
+
+  std::set<std::string> keys = grandChild.ClosureKeys();
+  if(keys.size() != 2 || !keys.count("B") || !keys.count("D"))
+    {
+    cmFailed("closure keys do not match the flattened scope");
+    }
+
+  return failed;
+}
+
+//----------------------------------------------------------------------------
+static void benchmarkLookup(unsigned int depth)
+{
+  const unsigned int numberOfKeys = 1000;
+  const unsigned int numberOfRounds = 200;
+  std::vector<std::string> keys;
+  for(unsigned int i = 0; i < numberOfKeys; ++i)
+    {
+    std::ostringstream key;
+    key << "CMAKE_BENCHMARK_VARIABLE_" << i;
+    keys.push_back(key.str());
+    }
+
+  std::list<cmDefinitions> stack;
+  stack.push_back(cmDefinitions());
+  for(std::vector<std::string>::const_iterator ki = keys.begin();
+      ki != keys.end(); ++ki)
+    {
+    stack.back().Set(*ki, "some value that is long enough to be allocated");
+    }
+
+  double start = cmSystemTools::GetTime();
+  for(unsigned int r = 0; r < numberOfRounds; ++r)
+    {
+    // Push a fresh chain of scopes, look everything up from the top
+    // and pop the chain again, like nested function calls would.
+    for(unsigned int d = 0; d < depth; ++d)
+      {
+      cmDefinitions* parent = &stack.back();
+      stack.push_back(cmDefinitions(parent));
+      }
+    for(std::vector<std::string>::const_iterator ki = keys.begin();
+        ki != keys.end(); ++ki)
+      {
+      stack.back().Get(*ki);
+      stack.back().Get(*ki);
+      }
+    for(unsigned int d = 0; d < depth; ++d)
+      {
+      stack.pop_back();
+      }
+    }
+  double elapsed = cmSystemTools::GetTime() - start;
+  double lookups = 2.0 * numberOfKeys * numberOfRounds;
+  std::cout << "depth " << std::setw(4) << depth << ": "
+            << std::setw(12) << static_cast<long>(lookups / elapsed)
+            << " lookups/s\n";
+}
+
+//----------------------------------------------------------------------------
+int testDefinitions(int argc, char* argv[])
+{
+  int failed = testScopes();
+
+  // Measure lookup throughput only on request.
+  if(argc > 1 && strcmp(argv[1], "--benchmark") == 0)
+    {
+    unsigned int const depths[] = { 1, 4, 16, 64 };
+    for(unsigned int i = 0; i < sizeof(depths)/sizeof(depths[0]); ++i)
+      {
+      benchmarkLookup(depths[i]);
+      }
+    }
+
+  return failed;
+}
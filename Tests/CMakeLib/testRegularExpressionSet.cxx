@@ -0,0 +1,161 @@
+/*============================================================================
+  CMake - Cross Platform Makefile Generator
+  Copyright 2000-2009 Kitware, Inc., Insight Software Consortium
+
+  Distributed under the OSI-approved BSD License (the "License");
+  see accompanying file Copyright.txt for details.
+
+  This software is distributed WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the License for more information.
+============================================================================*/
+#include "cmRegularExpressionSet.h"
+
+struct literal_pair
+{
+  const char* expr;
+  const char* literal;
+};
+
+static literal_pair const literals[] = {
+  {"plain text", "plain text"},
+  {"^Error ([0-9]+):", "Error "},
+  {"([^ :]+) : warning", " : warning"},
+  {"ab*cdef", "cdef"},
+  {"abc?de", "ab"},
+  {"ab+cd", "ab"},
+  {"a\\*\\*\\*b", "a***b"},
+  {"[xy]z[^]q]rst", "rst"},
+  {"one|two", ""},
+  {"x(one|two)yz", "yz"},
+  {"\\([0-9]*\\): remark #[0-9]*", "): remark #"},
+  {0,0}
+};
+
+// A selection of the default expressions of the ctest build step.
+static const char* expressions[] = {
+  "^[Bb]us [Ee]rror",
+  "^[Ss]egmentation [Ff]ault",
+  ":.*[Pp]ermission [Dd]enied",
+  "([^ :]+):([0-9]+): ([^ \\t])",
+  "([^:]+): error[ \\t]*[0-9]+[ \\t]*:",
+  "^Error ([0-9]+):",
+  "^Fatal",
+  "([^ :]+) : (error|fatal error|catastrophic error)",
+  "^fatal error C[0-9]+:",
+  "^collect2: ld returned 1 exit status",
+  "Undefined symbol",
+  "^CMake Error.*:",
+  ": \\*\\*\\* No rule to make target \\[`'].*\\'.  Stop",
+  "make: \\*\\*\\*.*Error",
+  "make\\[.*\\]: \\*\\*\\*.*Error",
+  "Makefile:[0-9]+: \\*\\*\\* .*  Stop\\.",
+  ": No such file or directory",
+  "^\\[ERROR\\]",
+  "([^ :]+):([0-9]+): warning:",
+  "^(Warning|Warnung)[ :]",
+  "WARNING: ",
+  "\\([0-9]*\\): remark #[0-9]*",
+  "^CMake Warning.*:",
+  0
+};
+
+static const char* lines[] = {
+  "[ 12%] Building CXX object Source/CMakeFiles/CMakeLib.dir/cmake.cxx.o",
+  "/path/to/file.cxx:12: warning: unused variable 'x'",
+  "/path/to/file.cxx:12:5: error: expected ';' before '}' token",
+  "make[2]: *** [Source/CMakeFiles/CMakeLib.dir/all] Error 2",
+  "Segmentation fault (core dumped)",
+  "ld: cannot open output file: Permission denied",
+  "file.c(10) : error C2065: 'x' : undeclared identifier",
+  "CMake Error at CMakeLists.txt:3 (foo):",
+  "CMake Warning (dev) in CMakeLists.txt:",
+  "Warning: something",
+  "WARNING: other",
+  "foo.f(12): remark #8291: Recommended relationship",
+  "[ERROR] build failed",
+  "collect2: ld returned 1 exit status",
+  "gmake: *** No rule to make target `all'.  Stop.",
+  "x: No such file or directory",
+  "",
+  "Scanning dependencies of target CMakeLib",
+  0
+};
+
+//----------------------------------------------------------------------------
+static int naiveFind(std::vector<cmsys::RegularExpression>& regexes,
+                     const char* line)
+{
+  for(size_t i = 0; i < regexes.size(); ++i)
+    {
+    if(regexes[i].find(line))
+      {
+      return static_cast<int>(i);
+      }
+    }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+int testRegularExpressionSet(int, char*[])
+{
+  int result = 0;
+  for(literal_pair const* p = literals; p->expr; ++p)
+    {
+    std::string literal = cmRegularExpressionSet::GetRequiredLiteral(p->expr);
+    if(literal != p->literal)
+      {
+      printf("expected literal [%s] for [%s], got [%s]\n",
+             p->literal, p->expr, literal.c_str());
+      result = 1;
+      }
+    }
+
+  cmRegularExpressionSet set;
+  std::vector<cmsys::RegularExpression> regexes;
+  for(const char** e = expressions; *e; ++e)
+    {
+    set.Add(*e);
+    regexes.push_back(cmsys::RegularExpression(*e));
+    }
+
+  // The set must find the same expression as trying them one by one.
+  for(const char** l = lines; *l; ++l)
+    {
+    int expect = naiveFind(regexes, *l);
+    int actual = set.Find(*l);
+    if(actual != expect)
+      {
+      printf("expected match %d for [%s], got %d\n", expect, *l, actual);
+      result = 1;
+      }
+    }
+
+  // Check a log made mostly of regular lines.
+  std::vector<std::string> log;
+  for(int i = 0; i < 5000; ++i)
+    {
+    std::ostringstream line;
+    line << "[ " << (i % 100) << "%] Building CXX object "
+         << "Source/CMakeFiles/CMakeLib.dir/cmFile" << i << ".cxx.o";
+    log.push_back(line.str());
+    if(i % 50 == 0)
+      {
+      log.push_back(lines[i / 50 % (sizeof(lines)/sizeof(lines[0]) - 1)]);
+      }
+    }
+  int naiveMatches = 0;
+  int setMatches = 0;
+  for(std::vector<std::string>::const_iterator l = log.begin();
+      l != log.end(); ++l)
+    {
+    naiveMatches += naiveFind(regexes, l->c_str()) >= 0? 1 : 0;
+    setMatches += set.Find(l->c_str()) >= 0? 1 : 0;
+    }
+  if(naiveMatches != setMatches)
+    {
+    printf("expected %d matching lines, got %d\n", naiveMatches, setMatches);
+    result = 1;
+    }
+  return result;
+}
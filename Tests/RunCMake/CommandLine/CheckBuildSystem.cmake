@@ -0,0 +1 @@
+configure_file(${CMAKE_BINARY_DIR}/input.txt output.txt COPYONLY)
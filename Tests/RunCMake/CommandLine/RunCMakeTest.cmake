@@ -34,6 +34,40 @@ if(RunCMake_GENERATOR STREQUAL "Ninja")
   unset(RunCMake_TEST_NO_CLEAN)
 endif()
 
+if(RunCMake_GENERATOR MATCHES "Make")
+  # Use a single build tree for a few tests without cleaning.
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/CheckBuildSystem-build)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/input.txt" "1\n")
+
+  run_cmake(CheckBuildSystem)
+  set(check ${CMAKE_COMMAND} -H${RunCMake_SOURCE_DIR} -B.
+    --check-build-system CMakeFiles/Makefile.cmake 0)
+  run_cmake_command(CheckBuildSystem-unchanged ${check})
+  execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 1)
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/input.txt" "12\n")
+  run_cmake_command(CheckBuildSystem-changed ${check})
+  run_cmake_command(CheckBuildSystem-unchanged ${check})
+  if(UNIX)
+    # Make the check file invalid while keeping its time and size.  Only
+    # a check that does not read it can pass.
+    set(check_file "${RunCMake_TEST_BINARY_DIR}/CMakeFiles/Makefile.cmake")
+    execute_process(COMMAND cp -p "${check_file}" "${check_file}.orig")
+    file(READ "${check_file}" content)
+    string(REGEX REPLACE "." "(" content "${content}")
+    file(WRITE "${check_file}" "${content}")
+    execute_process(COMMAND touch -r "${check_file}.orig" "${check_file}")
+    run_cmake_command(CheckBuildSystem-unread ${check})
+    execute_process(COMMAND mv "${check_file}.orig" "${check_file}")
+    run_cmake_command(CheckBuildSystem-unchanged ${check})
+  endif()
+
+  unset(RunCMake_TEST_BINARY_DIR)
+  unset(RunCMake_TEST_NO_CLEAN)
+endif()
+
 if(UNIX)
   run_cmake_command(E_create_symlink-missing-dir
     ${CMAKE_COMMAND} -E create_symlink T missing-dir/L
@@ -80,3 +114,7 @@ run_cmake(D_nested_cache)
 set(RunCMake_TEST_OPTIONS
   "-DFOO:STRING=-DBAR:BOOL=BAZ")
 run_cmake(D_typed_nested_cache)
+
+set(RunCMake_TEST_OPTIONS "--profile=${RunCMake_BINARY_DIR}/profile.json")
+run_cmake(profile)
+unset(RunCMake_TEST_OPTIONS)
@@ -0,0 +1,21 @@
+set(profile "${RunCMake_BINARY_DIR}/profile.json")
+if(NOT EXISTS "${profile}")
+  set(RunCMake_TEST_FAILED "Profile file\n  ${profile}\nnot written.")
+  return()
+endif()
+file(READ "${profile}" content)
+foreach(event
+    [["cat":"cmake","name":"Configure"]]
+    [["cat":"cmake","name":"Generate"]]
+    [["cat":"script","name":"profile_function"]]
+    [["cat":"generate","name":"project files"]]
+    )
+  string(FIND "${content}" "${event}" pos)
+  if(pos EQUAL -1)
+    set(RunCMake_TEST_FAILED "Profile file\n  ${profile}\ndoes not contain\n  ${event}")
+    return()
+  endif()
+endforeach()
+if(NOT content MATCHES "^{\"traceEvents\":\\[.*\n\\]}\n$")
+  set(RunCMake_TEST_FAILED "Profile file\n  ${profile}\nis not a trace event list.")
+endif()
@@ -0,0 +1,4 @@
+function(profile_function)
+  message(STATUS "profile_function")
+endfunction()
+profile_function()
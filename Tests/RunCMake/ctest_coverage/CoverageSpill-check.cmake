@@ -0,0 +1,18 @@
+file(GLOB coverage_xml "${RunCMake_TEST_BINARY_DIR}/Testing/*/Coverage.xml")
+if(NOT coverage_xml)
+  set(RunCMake_TEST_FAILED "Coverage.xml not found")
+  return()
+endif()
+file(READ "${coverage_xml}" coverage)
+foreach(name a1.c a2.c a3.c a4.c a5.c b.c)
+  string(REGEX MATCHALL "<File Name=\"${name}\"" entries "${coverage}")
+  list(LENGTH entries count)
+  if(NOT count EQUAL 1)
+    set(RunCMake_TEST_FAILED
+      "${name} appears ${count} times in Coverage.xml:\n  ${coverage_xml}")
+    return()
+  endif()
+endforeach()
+if(NOT coverage MATCHES "<File Name=\"b.c\"[^<]*<LOCTested>0</LOCTested>")
+  set(RunCMake_TEST_FAILED "b.c not reported as uncovered")
+endif()
@@ -1,6 +1,7 @@
 include(RunCTest)
 
 set(CASE_CTEST_COVERAGE_ARGS "")
+set(CASE_TEST_PREFIX_CODE "")
 
 function(run_ctest_coverage CASE_NAME)
   set(CASE_CTEST_COVERAGE_ARGS "${ARGN}")
@@ -8,3 +9,38 @@ function(run_ctest_coverage CASE_NAME)
 endfunction()
 
 run_ctest_coverage(CoverageQuiet QUIET)
+
+# Use a fake gcov reporting 65536 lines for each of five sources so that
+# a limit of 1 MB spills the counts to disk, and check that the extra
+# coverage glob does not report the spilled sources a second time.
+set(CASE_TEST_PREFIX_CODE [[
+set(lines "x\n")
+foreach(i RANGE 1 16)
+  set(lines "${lines}${lines}")
+endforeach()
+foreach(i 1 2 3 4 5)
+  file(WRITE "${CTEST_SOURCE_DIRECTORY}/a${i}.c" "${lines}")
+  file(WRITE "${CTEST_BINARY_DIRECTORY}/CMakeFiles/spill.dir/a${i}.gcda" "")
+endforeach()
+file(WRITE "${CTEST_SOURCE_DIRECTORY}/b.c" "x\n")
+file(APPEND "${CTEST_BINARY_DIRECTORY}/CMakeFiles/TargetDirectories.txt"
+  "${CTEST_BINARY_DIRECTORY}/CMakeFiles/spill.dir\n")
+file(WRITE "${CTEST_BINARY_DIRECTORY}/fakegcov.cmake" "
+foreach(i RANGE 0 \${CMAKE_ARGC})
+  if(\"\${CMAKE_ARGV\${i}}\" MATCHES \"([^/]*)\\\\.gcda$\")
+    set(name \"\${CMAKE_MATCH_1}\")
+  endif()
+endforeach()
+file(WRITE \"\${CMAKE_SOURCE_DIR}/\${name}.c.gcov\" \"        1:65536:x\\n\")
+foreach(line \"File '${CTEST_SOURCE_DIRECTORY}/\${name}.c'\"
+    \"Lines executed:100.00% of 1\" \"Creating '\${name}.c.gcov'\")
+  execute_process(COMMAND \${CMAKE_COMMAND} -E echo \"\${line}\")
+endforeach()
+")
+set(CTEST_COVERAGE_COMMAND "${CMAKE_COMMAND}")
+set(CTEST_COVERAGE_EXTRA_FLAGS "-P \"${CTEST_BINARY_DIRECTORY}/fakegcov.cmake\"")
+set(CTEST_COVERAGE_MEMORY_LIMIT 1)
+set(CTEST_EXTRA_COVERAGE_GLOB "*.c")
+]])
+run_ctest(CoverageSpill -VV)
+set(CASE_TEST_PREFIX_CODE "")
@@ -45,3 +45,11 @@ run_ctest_submit_FailDrop(http)
 run_ctest_submit_FailDrop(https)
 run_ctest_submit_FailDrop(scp)
 run_ctest_submit_FailDrop(xmlrpc)
+
+function(run_ctest_submit_FailDrop_parallel)
+  set(CASE_DROP_METHOD http)
+  set(CASE_TEST_PREFIX_CODE "set(CTEST_SUBMIT_PARALLEL_LEVEL 4)
+set(CTEST_SUBMIT_COMPRESSION ON)")
+  run_ctest(FailDrop-http-parallel)
+endfunction()
+run_ctest_submit_FailDrop_parallel()
@@ -1,6 +1,9 @@
 include(RunCTest)
 
 set(CASE_CTEST_TEST_ARGS "")
+set(CASE_CMAKELISTS_SUFFIX_CODE "")
+set(CASE_TEST_PREFIX_CODE "")
+set(CASE_TEST_SUFFIX_CODE "")
 
 function(run_ctest_test CASE_NAME)
   set(CASE_CTEST_TEST_ARGS "${ARGN}")
@@ -8,3 +11,159 @@ function(run_ctest_test CASE_NAME)
 endfunction()
 
 run_ctest_test(TestQuiet QUIET)
+
+set(CASE_CMAKELISTS_SUFFIX_CODE [[
+foreach(i 1 2 3)
+  add_test(NAME Chain${i} COMMAND ${CMAKE_COMMAND} -E echo Chain${i})
+  set_tests_properties(Chain${i} PROPERTIES COST 1)
+endforeach()
+set_tests_properties(Chain2 PROPERTIES DEPENDS Chain1)
+set_tests_properties(Chain3 PROPERTIES DEPENDS Chain2)
+add_test(NAME Long COMMAND ${CMAKE_COMMAND} -E echo Long)
+set_tests_properties(Long PROPERTIES COST 5)
+]])
+run_ctest_test(TestCriticalPath PARALLEL_LEVEL 2)
+
+set(CASE_CMAKELISTS_SUFFIX_CODE [[
+foreach(i 1 2 3)
+  add_test(NAME Bad${i} COMMAND ${CMAKE_COMMAND} -E echo Bad${i})
+endforeach()
+]])
+set(CASE_TEST_PREFIX_CODE [[
+file(WRITE "${CTEST_BINARY_DIRECTORY}/Testing/Temporary/CTestCostData.txt"
+  "Bad1 1 nan nan\nBad2 -3 -1 -1\nBad3 1 1e999 inf\nGone -2 nan -inf\n")
+]])
+run_ctest_test(TestBadCostData PARALLEL_LEVEL 2)
+set(CASE_TEST_PREFIX_CODE "")
+
+set(CASE_CMAKELISTS_SUFFIX_CODE [[
+foreach(i 1 2 3)
+  add_test(NAME Chain${i} COMMAND ${CMAKE_COMMAND} -E echo Chain${i})
+endforeach()
+set_tests_properties(Chain2 PROPERTIES DEPENDS Chain1)
+set_tests_properties(Chain3 PROPERTIES DEPENDS Chain2)
+add_test(NAME Lone1 COMMAND ${CMAKE_COMMAND} -E echo Lone1)
+add_test(NAME Lone2 COMMAND ${CMAKE_COMMAND} -E echo Lone2)
+]])
+run_ctest_test(TestShard SHARD 2/2)
+
+# Both shards of one build tree keep the failures of the other.
+set(CASE_CMAKELISTS_SUFFIX_CODE [[
+file(WRITE "${CMAKE_CURRENT_BINARY_DIR}/fails.cmake"
+  "message(FATAL_ERROR \"This test fails.\")\n")
+foreach(i 1 2 3)
+  add_test(NAME Chain${i} COMMAND ${CMAKE_COMMAND}
+    -P "${CMAKE_CURRENT_BINARY_DIR}/fails.cmake")
+endforeach()
+set_tests_properties(Chain2 PROPERTIES DEPENDS Chain1)
+set_tests_properties(Chain3 PROPERTIES DEPENDS Chain2)
+add_test(NAME Lone1 COMMAND ${CMAKE_COMMAND}
+  -P "${CMAKE_CURRENT_BINARY_DIR}/fails.cmake")
+add_test(NAME Lone2 COMMAND ${CMAKE_COMMAND} -E echo Lone2)
+]])
+set(CASE_TEST_SUFFIX_CODE "ctest_test(SHARD 2/2)")
+run_ctest_test(TestShardFailed SHARD 1/2)
+set(CASE_TEST_SUFFIX_CODE "")
+
+# Both shards split by the times recorded before either of them ran.
+set(CASE_CMAKELISTS_SUFFIX_CODE [[
+add_test(NAME Slow COMMAND ${CMAKE_COMMAND} -E echo Slow)
+foreach(i 1 2 3)
+  add_test(NAME Fast${i} COMMAND ${CMAKE_COMMAND} -E echo Fast${i})
+endforeach()
+]])
+set(CASE_TEST_PREFIX_CODE [[
+file(WRITE "${CTEST_BINARY_DIRECTORY}/Testing/Temporary/CTestCostData.txt"
+  "RunCMakeVersion 1 0.01\nSlow 1 3\nFast1 1 0.01\nFast2 1 0.01\n"
+  "Fast3 1 0.01\n---\n")
+]])
+set(CASE_TEST_SUFFIX_CODE "ctest_test(SHARD 2/2)")
+run_ctest_test(TestShardRecorded SHARD 1/2)
+set(CASE_TEST_PREFIX_CODE "")
+set(CASE_TEST_SUFFIX_CODE "")
+
+set(CASE_CMAKELISTS_SUFFIX_CODE [[
+file(WRITE "${CMAKE_CURRENT_BINARY_DIR}/fails.cmake"
+  "message(FATAL_ERROR \"This test fails.\")\n")
+add_test(NAME Fails COMMAND ${CMAKE_COMMAND}
+  -P "${CMAKE_CURRENT_BINARY_DIR}/fails.cmake")
+]])
+set(CASE_TEST_SUFFIX_CODE "ctest_test()")
+run_ctest(TestSkipUnchanged --skip-unchanged)
+
+# A test that fails in a run without --skip-unchanged must run again
+# even though its inputs did not change.
+set(CASE_CMAKELISTS_SUFFIX_CODE [[
+file(WRITE "${CMAKE_CURRENT_BINARY_DIR}/flaky.cmake"
+  "if(EXISTS \"${CMAKE_CURRENT_BINARY_DIR}/fail\")
+  message(FATAL_ERROR \"This test fails.\")
+endif()
+")
+add_test(NAME Flaky COMMAND ${CMAKE_COMMAND}
+  -P "${CMAKE_CURRENT_BINARY_DIR}/flaky.cmake")
+]])
+set(CASE_TEST_SUFFIX_CODE "
+file(WRITE \"\${CTEST_BINARY_DIRECTORY}/fail\" \"\")
+execute_process(COMMAND \"${CMAKE_CTEST_COMMAND}\"
+  WORKING_DIRECTORY \"\${CTEST_BINARY_DIRECTORY}\"
+  OUTPUT_QUIET ERROR_QUIET)
+ctest_test()
+")
+run_ctest(TestSkipUnchangedFailed --skip-unchanged)
+
+# Another run in the same build tree while the tests run keeps the
+# results it adds to the result cache.
+set(CASE_CMAKELISTS_SUFFIX_CODE [[
+add_test(NAME Inner COMMAND ${CMAKE_COMMAND} -E echo Inner)
+file(WRITE "${CMAKE_CURRENT_BINARY_DIR}/nested.cmake" "
+set(CTEST_SOURCE_DIRECTORY \"${CMAKE_CURRENT_SOURCE_DIR}\")
+set(CTEST_BINARY_DIRECTORY \"${CMAKE_CURRENT_BINARY_DIR}\")
+ctest_start(Experimental APPEND)
+ctest_test(INCLUDE ^Inner$)
+")
+add_test(NAME Nested COMMAND ${CMAKE_CTEST_COMMAND}
+  -S "${CMAKE_CURRENT_BINARY_DIR}/nested.cmake" --skip-unchanged)
+]])
+set(CASE_TEST_SUFFIX_CODE "")
+set(CASE_CTEST_TEST_ARGS EXCLUDE ^Inner$)
+run_ctest(TestSkipUnchangedNested --skip-unchanged)
+set(CASE_CTEST_TEST_ARGS "")
+
+# A second run in the same build tree while the tests run must not take
+# over the file of streamed results.
+set(CASE_CMAKELISTS_SUFFIX_CODE [[
+file(WRITE "${CMAKE_CURRENT_BINARY_DIR}/nested.cmake" "
+set(CTEST_SOURCE_DIRECTORY \"${CMAKE_CURRENT_SOURCE_DIR}\")
+set(CTEST_BINARY_DIRECTORY \"${CMAKE_CURRENT_BINARY_DIR}\")
+ctest_start(Experimental APPEND)
+ctest_test(INCLUDE RunCMakeVersion)
+")
+add_test(NAME Nested COMMAND ${CMAKE_CTEST_COMMAND}
+  -S "${CMAKE_CURRENT_BINARY_DIR}/nested.cmake")
+set_tests_properties(Nested PROPERTIES DEPENDS RunCMakeVersion)
+]])
+run_ctest_test(TestNested)
+
+if(UNIX)
+  # Kill ctest in the middle of the run and check that the results of the
+  # tests finished so far were kept.
+  set(CASE_CMAKELISTS_SUFFIX_CODE [[
+add_test(NAME KillCTest COMMAND sh -c "kill -9 $PPID")
+set_tests_properties(KillCTest PROPERTIES DEPENDS RunCMakeVersion)
+]])
+  set(CASE_TEST_SUFFIX_CODE "")
+  run_ctest(TestKilled)
+
+  # Report results streamed to a file that went away, but still write
+  # what is known about them.
+  set(CASE_CMAKELISTS_SUFFIX_CODE [[
+file(WRITE "${CMAKE_CURRENT_BINARY_DIR}/lose.cmake" "
+file(GLOB results \"${CMAKE_CURRENT_BINARY_DIR}/Testing/Temporary/LastTestResults*.xml\")
+file(REMOVE \${results})
+")
+add_test(NAME Lose COMMAND ${CMAKE_COMMAND}
+  -P "${CMAKE_CURRENT_BINARY_DIR}/lose.cmake")
+set_tests_properties(Lose PROPERTIES DEPENDS RunCMakeVersion)
+]])
+  run_ctest_test(TestLost)
+endif()
@@ -0,0 +1,5 @@
+set(cost_data "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestCostData.txt")
+file(READ "${cost_data}" content)
+if(content MATCHES "nan|inf| -")
+  set(RunCMake_TEST_FAILED "Invalid values kept in cost data:\n${content}")
+endif()
@@ -0,0 +1,12 @@
+file(GLOB results
+  "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/LastTestResults*.xml")
+if(NOT results)
+  set(RunCMake_TEST_FAILED "No test results were kept.")
+  return()
+endif()
+file(READ "${results}" content)
+if(NOT content MATCHES "<Name>RunCMakeVersion</Name>")
+  set(RunCMake_TEST_FAILED "Results of RunCMakeVersion not found in\n  ${results}")
+elseif(content MATCHES "<Name>KillCTest</Name>")
+  set(RunCMake_TEST_FAILED "Results of KillCTest found in\n  ${results}")
+endif()
@@ -0,0 +1,7 @@
+file(GLOB test_xml "${RunCMake_TEST_BINARY_DIR}/Testing/*/Test.xml")
+file(READ "${test_xml}" content)
+string(REGEX MATCHALL "<Test Status=\"passed\">" results "${content}")
+list(LENGTH results count)
+if(NOT count EQUAL 2)
+  set(RunCMake_TEST_FAILED "Expected 2 passed test results in\n  ${test_xml}\nbut found ${count}.")
+endif()
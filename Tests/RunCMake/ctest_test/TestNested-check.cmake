@@ -0,0 +1,11 @@
+file(GLOB test_xml "${RunCMake_TEST_BINARY_DIR}/Testing/*/Test.xml")
+file(READ "${test_xml}" content)
+string(REGEX MATCHALL "<Test Status=\"passed\">" results "${content}")
+list(LENGTH results count)
+if(NOT count EQUAL 2)
+  set(RunCMake_TEST_FAILED "Expected 2 passed test results in\n  ${test_xml}\nbut found ${count}.")
+endif()
+file(GLOB leftover "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/LastTestResults*.xml")
+if(leftover)
+  set(RunCMake_TEST_FAILED "${RunCMake_TEST_FAILED}\nStreamed results were not removed:\n  ${leftover}")
+endif()
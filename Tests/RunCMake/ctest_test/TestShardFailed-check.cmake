@@ -0,0 +1,16 @@
+set(temp "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary")
+file(GLOB log "${temp}/LastTestsFailed*.log")
+file(READ "${log}" failed)
+file(READ "${temp}/CTestCostData.txt" cost_data)
+string(REGEX REPLACE ".*---\n" "" cost_data_failed "${cost_data}")
+foreach(test Chain1 Chain2 Chain3 Lone1)
+  if(NOT failed MATCHES ":${test}\n")
+    set(RunCMake_TEST_FAILED "${test} missing from\n  ${log}")
+    return()
+  endif()
+  if(NOT cost_data_failed MATCHES "(^|\n)${test}\n")
+    set(RunCMake_TEST_FAILED "${test} missing from the failed tests in\n"
+      "  ${temp}/CTestCostData.txt")
+    return()
+  endif()
+endforeach()
@@ -0,0 +1,13 @@
+set(cost_file "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestCostData.txt")
+file(GLOB shard_files "${cost_file}.*of2")
+if(shard_files)
+  set(RunCMake_TEST_FAILED "Shard cost files not merged:\n  ${shard_files}")
+  return()
+endif()
+file(READ "${cost_file}" cost_data)
+foreach(test RunCMakeVersion Slow Fast1 Fast2 Fast3)
+  if(NOT cost_data MATCHES "(^|\n)${test} 2 ")
+    set(RunCMake_TEST_FAILED "${test} not updated in\n  ${cost_file}")
+    return()
+  endif()
+endforeach()
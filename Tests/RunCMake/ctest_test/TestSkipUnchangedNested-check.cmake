@@ -0,0 +1,7 @@
+set(cache "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestResultCache.txt")
+file(STRINGS "${cache}" lines)
+foreach(test Inner Nested RunCMakeVersion)
+  if(NOT lines MATCHES "[^;]+ ${test}(;|$)")
+    set(RunCMake_TEST_FAILED "${RunCMake_TEST_FAILED}Test ${test} is missing from the result cache:\n  ${lines}\n")
+  endif()
+endforeach()
@@ -0,0 +1,9 @@
+set(dir ${CMAKE_CURRENT_BINARY_DIR}/include)
+file(WRITE "${dir}/a.h" "")
+find_file(A_H a.h PATHS ${dir} NO_DEFAULT_PATH)
+message("A_H='${A_H}'")
+file(WRITE "${dir}/b.h" "")
+find_file(B_H b.h PATHS ${dir} NO_DEFAULT_PATH)
+message("B_H='${B_H}'")
+find_path(B_H_PATH b.h PATHS ${dir} NO_DEFAULT_PATH)
+message("B_H_PATH='${B_H_PATH}'")
@@ -1,3 +1,4 @@
 include(RunCMake)
 
+run_cmake(CreatedSameSecond)
 run_cmake(PrefixInPATH)
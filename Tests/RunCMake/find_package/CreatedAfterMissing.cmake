@@ -0,0 +1,7 @@
+set(dir ${CMAKE_CURRENT_BINARY_DIR}/pkg)
+file(MAKE_DIRECTORY ${dir})
+find_package(Created CONFIG QUIET PATHS ${dir} NO_DEFAULT_PATH)
+message("Created_FOUND='${Created_FOUND}'")
+file(WRITE "${dir}/CreatedConfig.cmake" "")
+find_package(Created CONFIG QUIET PATHS ${dir} NO_DEFAULT_PATH)
+message("Created_FOUND='${Created_FOUND}'")
@@ -1,6 +1,7 @@
 include(RunCMake)
 
 run_cmake(ComponentRequiredAndOptional)
+run_cmake(CreatedAfterMissing)
 run_cmake(MissingNormal)
 run_cmake(MissingNormalRequired)
 run_cmake(MissingNormalVersion)
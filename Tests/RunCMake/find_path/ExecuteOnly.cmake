@@ -0,0 +1,8 @@
+# A directory that can be searched but not listed still holds files.
+set(dir ${CMAKE_CURRENT_BINARY_DIR}/xonly)
+file(WRITE ${dir}/ExecuteOnly.h "")
+execute_process(COMMAND chmod 111 ${dir})
+find_path(ExecuteOnly_INCLUDE_DIR NAMES ExecuteOnly.h PATHS ${dir}
+  NO_DEFAULT_PATH)
+execute_process(COMMAND chmod 755 ${dir})
+message(STATUS "ExecuteOnly_INCLUDE_DIR='${ExecuteOnly_INCLUDE_DIR}'")
@@ -1,3 +1,6 @@
 include(RunCMake)
 
 run_cmake(PrefixInPATH)
+if(UNIX)
+  run_cmake(ExecuteOnly)
+endif()
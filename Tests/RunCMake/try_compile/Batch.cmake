@@ -0,0 +1,43 @@
+enable_language(C)
+
+# Queued checks share one temporary source, as the Check modules do.
+set(src ${CMAKE_CURRENT_BINARY_DIR}/CMakeFiles/CMakeTmp/batch.c)
+file(WRITE ${src} "int main(void) { return 0; }\n")
+try_compile(RESULT_PASS ${CMAKE_CURRENT_BINARY_DIR} ${src}
+  COPY_FILE ${CMAKE_CURRENT_BINARY_DIR}/copy${CMAKE_EXECUTABLE_SUFFIX}
+  BATCH
+  )
+file(WRITE ${src} "does-not-compile\n")
+try_compile(RESULT_FAIL ${CMAKE_CURRENT_BINARY_DIR} ${src}
+  OUTPUT_VARIABLE out_fail
+  BATCH
+  )
+# Two sources are built with the test project right away.
+file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/other.c "int other(void) { return 0; }\n")
+try_compile(RESULT_SOURCES ${CMAKE_CURRENT_BINARY_DIR}
+  SOURCES ${CMAKE_CURRENT_SOURCE_DIR}/src.c ${CMAKE_CURRENT_BINARY_DIR}/other.c
+  BATCH
+  )
+foreach(v RESULT_PASS RESULT_FAIL RESULT_SOURCES)
+  if(DEFINED ${v})
+    message(FATAL_ERROR "${v} is defined before the batch ran")
+  endif()
+endforeach()
+
+cmake_check_batch(RUN PARALLEL_LEVEL 2)
+
+if(NOT RESULT_PASS)
+  message(FATAL_ERROR "batched try_compile failed but should have passed")
+endif()
+if(NOT EXISTS ${CMAKE_CURRENT_BINARY_DIR}/copy${CMAKE_EXECUTABLE_SUFFIX})
+  message(FATAL_ERROR "batched try_compile did not provide COPY_FILE")
+endif()
+if(RESULT_FAIL)
+  message(FATAL_ERROR "batched try_compile passed but should have failed")
+endif()
+if(NOT out_fail MATCHES "does-not-compile")
+  message(FATAL_ERROR "batched try_compile output is missing:\n${out_fail}")
+endif()
+if(NOT RESULT_SOURCES)
+  message(FATAL_ERROR "batched try_compile failed but should have passed")
+endif()
@@ -0,0 +1,35 @@
+enable_language(C)
+set(CMAKE_TRY_COMPILE_CACHE_DIR ${CMAKE_CURRENT_BINARY_DIR}/cache)
+
+# A queued check builds its source as it is when the batch runs, and
+# its cache entry must describe that text.
+set(src ${CMAKE_CURRENT_BINARY_DIR}/late.c)
+file(WRITE ${src} "int main(void) { return 0; }\n")
+try_compile(RESULT_LATE ${CMAKE_CURRENT_BINARY_DIR} ${src} BATCH)
+file(WRITE ${src} "does-not-compile\n")
+cmake_check_batch(RUN)
+if(RESULT_LATE)
+  message(FATAL_ERROR "batched try_compile passed but should have failed")
+endif()
+file(WRITE ${src} "int main(void) { return 0; }\n")
+try_compile(RESULT ${CMAKE_CURRENT_BINARY_DIR} ${src})
+if(NOT RESULT)
+  message(FATAL_ERROR "try_compile failed but should have passed")
+endif()
+
+# The same queued check in two directories shares one cache entry.
+set(CMAKE_TRY_COMPILE_CACHE_DIR ${CMAKE_CURRENT_BINARY_DIR}/shared)
+foreach(dir one two)
+  set(src ${CMAKE_CURRENT_BINARY_DIR}/${dir}/CMakeFiles/CMakeTmp/batch.c)
+  file(WRITE ${src} "int main(void) { return 0; }\n")
+  try_compile(RESULT_${dir} ${CMAKE_CURRENT_BINARY_DIR}/${dir} ${src} BATCH)
+  cmake_check_batch(RUN)
+endforeach()
+if(NOT RESULT_one OR NOT RESULT_two)
+  message(FATAL_ERROR "batched try_compile failed but should have passed")
+endif()
+file(GLOB entries ${CMAKE_TRY_COMPILE_CACHE_DIR}/*.lock)
+list(LENGTH entries count)
+if(NOT count EQUAL 1)
+  message(FATAL_ERROR "expected 1 cache entry, found ${count}")
+endif()
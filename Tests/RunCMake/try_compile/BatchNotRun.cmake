@@ -0,0 +1,5 @@
+enable_language(C)
+try_compile(RESULT_QUEUED ${CMAKE_CURRENT_BINARY_DIR}
+  ${CMAKE_CURRENT_SOURCE_DIR}/src.c
+  BATCH
+  )
@@ -0,0 +1,47 @@
+enable_language(C)
+set(CMAKE_TRY_COMPILE_CACHE_DIR ${CMAKE_CURRENT_BINARY_DIR}/cache)
+
+# The same check in two directories shares one cache entry.
+try_compile(RESULT1 ${CMAKE_CURRENT_BINARY_DIR}/one
+  ${CMAKE_CURRENT_SOURCE_DIR}/src.c
+  COPY_FILE ${CMAKE_CURRENT_BINARY_DIR}/copy1${CMAKE_EXECUTABLE_SUFFIX}
+  )
+file(GLOB entries ${CMAKE_TRY_COMPILE_CACHE_DIR}/*.lock)
+list(LENGTH entries count)
+if(NOT count EQUAL 1)
+  message(FATAL_ERROR "expected 1 cache entry, found ${count}")
+endif()
+# Mark the stored output to tell a cached result from a new build.
+string(REGEX REPLACE "\\.lock$" "/output" output_file "${entries}")
+file(WRITE "${output_file}" "output stored in the cache\n")
+try_compile(RESULT2 ${CMAKE_CURRENT_BINARY_DIR}/two
+  ${CMAKE_CURRENT_SOURCE_DIR}/src.c
+  COPY_FILE ${CMAKE_CURRENT_BINARY_DIR}/copy2${CMAKE_EXECUTABLE_SUFFIX}
+  OUTPUT_VARIABLE out
+  )
+if(NOT RESULT1 OR NOT RESULT2)
+  message(FATAL_ERROR "try_compile failed but should have passed")
+endif()
+if(NOT out STREQUAL "output stored in the cache\n")
+  message(FATAL_ERROR "try_compile built again instead of using the "
+    "cached result:\n${out}")
+endif()
+if(NOT EXISTS ${CMAKE_CURRENT_BINARY_DIR}/copy2${CMAKE_EXECUTABLE_SUFFIX})
+  message(FATAL_ERROR "cached try_compile did not provide COPY_FILE")
+endif()
+
+# Failures are cached too, in an entry of their own.
+file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/bad.c "does-not-compile\n")
+foreach(dir one two)
+  try_compile(RESULT ${CMAKE_CURRENT_BINARY_DIR}/${dir}
+    ${CMAKE_CURRENT_BINARY_DIR}/bad.c
+    )
+  if(RESULT)
+    message(FATAL_ERROR "try_compile passed but should have failed")
+  endif()
+endforeach()
+file(GLOB entries ${CMAKE_TRY_COMPILE_CACHE_DIR}/*.lock)
+list(LENGTH entries count)
+if(NOT count EQUAL 2)
+  message(FATAL_ERROR "expected 2 cache entries, found ${count}")
+endif()
@@ -0,0 +1,63 @@
+enable_language(C)
+set(CMAKE_TRY_COMPILE_DIRECT 1)
+
+try_compile(RESULT ${CMAKE_CURRENT_BINARY_DIR}
+  ${CMAKE_CURRENT_SOURCE_DIR}/src.c
+  COPY_FILE ${CMAKE_CURRENT_BINARY_DIR}/copy${CMAKE_EXECUTABLE_SUFFIX}
+  OUTPUT_VARIABLE out
+  )
+if(NOT RESULT)
+  message(FATAL_ERROR "try_compile failed but should have passed:\n${out}")
+endif()
+if(NOT EXISTS ${CMAKE_CURRENT_BINARY_DIR}/copy${CMAKE_EXECUTABLE_SUFFIX})
+  message(FATAL_ERROR "direct try_compile did not provide COPY_FILE")
+endif()
+if(CMAKE_GENERATOR MATCHES "Make|Ninja" AND
+    NOT out MATCHES "Run Build Command:\"?[^\n]*src\\.c")
+  message(FATAL_ERROR "try_compile did not run the compiler directly:\n${out}")
+endif()
+
+file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/defs.c
+  "#if !defined(DEF) || !defined(FLAG)\n#error missing definitions\n#endif\n"
+  "int main(void) { return 0; }\n")
+try_compile(RESULT ${CMAKE_CURRENT_BINARY_DIR}
+  ${CMAKE_CURRENT_BINARY_DIR}/defs.c
+  COMPILE_DEFINITIONS -DDEF
+  CMAKE_FLAGS -DCOMPILE_DEFINITIONS:STRING=-DFLAG
+  OUTPUT_VARIABLE out
+  )
+if(NOT RESULT)
+  message(FATAL_ERROR "try_compile failed but should have passed:\n${out}")
+endif()
+
+file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/bad.c "does-not-compile\n")
+try_compile(RESULT ${CMAKE_CURRENT_BINARY_DIR}
+  ${CMAKE_CURRENT_BINARY_DIR}/bad.c
+  )
+if(RESULT)
+  message(FATAL_ERROR "try_compile passed but should have failed")
+endif()
+
+file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/exit.c
+  "int main(void) { return 3; }\n")
+try_run(EXIT_CODE COMPILED ${CMAKE_CURRENT_BINARY_DIR}
+  ${CMAKE_CURRENT_BINARY_DIR}/exit.c
+  )
+if(NOT COMPILED OR NOT EXIT_CODE EQUAL 3)
+  message(FATAL_ERROR "try_run gave ${COMPILED} ${EXIT_CODE}, not TRUE 3")
+endif()
+
+# The test project would build the default configuration of the platform.
+set(CMAKE_BUILD_TYPE_INIT Debug)
+try_compile(RESULT ${CMAKE_CURRENT_BINARY_DIR}
+  ${CMAKE_CURRENT_SOURCE_DIR}/src.c
+  OUTPUT_VARIABLE out
+  )
+unset(CMAKE_BUILD_TYPE_INIT)
+if(NOT RESULT)
+  message(FATAL_ERROR "try_compile failed but should have passed:\n${out}")
+endif()
+if(out MATCHES "Run Build Command:\"?[^\n]*src\\.c")
+  message(FATAL_ERROR "try_compile ran the compiler directly although "
+    "the test project builds a default configuration:\n${out}")
+endif()
@@ -17,6 +17,11 @@ run_cmake(NonSourceCopyFile)
 run_cmake(NonSourceCompileDefinitions)
 
 run_cmake(CMP0056)
+run_cmake(CacheDir)
+run_cmake(Direct)
+run_cmake(Batch)
+run_cmake(BatchCache)
+run_cmake(BatchNotRun)
 
 if(RunCMake_GENERATOR MATCHES "Make|Ninja")
   # Use a single build tree for a few tests without cleaning.